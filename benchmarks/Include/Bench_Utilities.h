@@ -0,0 +1,109 @@
+#ifndef __BENCH_UTILITIES_H__
+#define __BENCH_UTILITIES_H__
+
+#include "../../src/FdaPDE.h"
+#include "../../src/Global_Utilities/Include/Timing.h"
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+//! Options of a benchmark run, set from the command line
+struct BenchConfig
+{
+  UInt scale = 32;		//!< Number of cells on each side of the 2D and 2.5D meshes
+  UInt scale_3d = 12;		//!< Number of cells on each side of the 3D mesh
+  UInt reps = 3;		//!< Number of repetitions of each scenario
+  UInt n_locations = 1000;	//!< Number of observation (and query) points, 0 means as many as the mesh nodes
+  UInt n_lambdas = 10;		//!< Size of the lambda grid of the GCV sweep
+  UInt n_realizations = 100;	//!< Number of realizations of the stochastic GCV
+  UInt n_flips = 1000;		//!< Number of flips of the sign-flip test
+  Real mc_error = 0;		//!< Error probability of the early stopping of the sign-flip tests, 0 means all the flips
+  UInt n_density_data = 1000;	//!< Number of points of the density estimation problem
+  UInt n_density_iter = 50;	//!< Maximum number of iterations of the density estimation optimizer
+  UInt n_curves = 50;		//!< Number of curves of the FPCA problem
+  UInt n_components = 3;	//!< Number of principal components of the FPCA problem
+  UInt seed = 42;
+  std::set<std::string> scenarios;	//!< Scenarios (or groups of scenarios) to run, empty means all
+
+  //! A method that tells if a scenario has been selected, either by its name or by its group
+  bool enabled(const std::string & group, const std::string & scenario) const
+  {
+    return scenarios.empty() || scenarios.count(group) || scenarios.count(scenario);
+  }
+  //! A method returning the number of locations to be used with a mesh of num_nodes nodes
+  UInt locations(UInt num_nodes) const {return n_locations > 0 ? n_locations : num_nodes;}
+};
+
+//! Synthetic structured mesh of order 1
+/*!
+  The arrays are stored column-major, as the R objects read by MeshHandler, with 0-based indices;
+  neighbors(i,j) is the element opposite to the j-th vertex of element i (-1 on the boundary).
+*/
+struct SyntheticMesh
+{
+  std::string domain;
+  UInt mydim = 0;
+  UInt ndim = 0;
+  UInt num_nodes = 0;
+  UInt num_elements = 0;
+  UInt num_sides = 0;
+  std::vector<Real> nodes;		//!< num_nodes x ndim
+  std::vector<UInt> elements;		//!< num_elements x (mydim+1)
+  std::vector<UInt> sides;		//!< num_sides x mydim (edges in 2D, faces in 3D)
+  std::vector<UInt> neighbors;		//!< num_elements x (mydim+1)
+};
+
+//! Unit square, n x n cells split into two triangles each
+SyntheticMesh build_square_mesh(UInt n);
+//! The square mesh mapped onto the surface z = sin(pi x) sin(pi y)/4 (2.5D)
+SyntheticMesh build_surface_mesh(UInt n);
+//! Unit cube, n x n x n cells split into six tetrahedra each (Kuhn subdivision, conforming)
+SyntheticMesh build_cube_mesh(UInt n);
+//! Builds the mesh of the given domain: "2D", "2.5D" or "3D"
+SyntheticMesh build_mesh(const std::string & domain, UInt n);
+
+//! Points uniformly distributed on the elements of the mesh (num_points x ndim, column-major), they always lie on the domain
+std::vector<Real> sample_points(const SyntheticMesh & mesh, UInt num_points, UInt seed);
+
+//! Peak resident set size (in kB) since the last call to reset_peak_rss()
+long peak_rss_kb(void);
+//! Resets the peak resident set size where the system allows it (Linux), otherwise the peak of the process is reported
+void reset_peak_rss(void);
+
+//! A class that measures the scenarios and writes one CSV line for each repetition
+/*!
+  Columns: scenario, domain, nodes, elements, n_data, rep, seconds, peak_rss_kb, checksum.
+  The checksum is a scalar summary of the result, useful to check that an optimization does not change the output.
+*/
+class BenchReport
+{
+public:
+  explicit BenchReport(std::ostream & out);
+
+  void setMesh(const SyntheticMesh & mesh) {domain_ = mesh.domain; num_nodes_ = mesh.num_nodes; num_elements_ = mesh.num_elements;}
+  //! A method that starts the measure: it resets the peak resident set size and starts the timer
+  void start(void);
+  //! A method that stops the measure and writes it
+  void stop(const std::string & scenario, UInt n_data, UInt rep, Real checksum);
+
+private:
+  std::ostream & out_;
+  timer timer_;
+  std::string domain_;
+  UInt num_nodes_ = 0;
+  UInt num_elements_ = 0;
+};
+
+// Scenarios, grouped by the module they exercise (each group has its own translation unit)
+//! Group "mesh": tree_build, point_location_tree, point_location_walking (2D and 3D), assembly_mass, assembly_stiff
+void bench_mesh(SyntheticMesh & mesh, const BenchConfig & config, BenchReport & report);
+//! Group "regression": regression_preapply, factorization, gcv_sweep, sign_flip, sign_flip_f, sign_flip_ci, speckman, wald_esf_f_ci, wald_f_ci
+void bench_regression(SyntheticMesh & mesh, const BenchConfig & config, BenchReport & report);
+//! Group "density": density_estimation, density_ci, density_newton_cg, density_cv, density_heat_cv,
+//! density_time_setup, density_time_functional
+void bench_density(SyntheticMesh & mesh, const BenchConfig & config, BenchReport & report);
+//! Group "fpca": fpca
+void bench_fpca(SyntheticMesh & mesh, const BenchConfig & config, BenchReport & report);
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __FDAPDE_SHIM_R_H__
+#define __FDAPDE_SHIM_R_H__
+
+#include "R_ext/Print.h"
+
+#endif
@@ -0,0 +1,306 @@
+#include "Rinternals.h"
+#include "Rcpp.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// In-memory replacement of the R objects: vectors, lists, strings and external pointers.
+// Objects are never collected, they live until the end of the program (the benchmarks only
+// allocate a few of them, when an R-like entry point is exercised).
+struct SEXPREC
+{
+  SEXPTYPE type;
+  std::vector<int> integers;
+  std::vector<double> reals;
+  std::vector<SEXP> elements;
+  std::string chars;
+  SEXP dim = nullptr;
+  void * address = nullptr;
+};
+
+namespace
+{
+  std::vector<std::unique_ptr<SEXPREC>> & pool()
+  {
+    static std::vector<std::unique_ptr<SEXPREC>> objects;
+    return objects;
+  }
+
+  SEXP newObject(SEXPTYPE type)
+  {
+    pool().push_back(std::unique_ptr<SEXPREC>(new SEXPREC{type, {}, {}, {}, {}}));
+    return pool().back().get();
+  }
+
+  SEXPREC nil_value{NILSXP, {}, {}, {}, {}};
+  SEXPREC dim_symbol{SYMSXP, {}, {}, {}, "dim"};
+
+  double makeNA()
+  {
+    // Same bit pattern used by R: a NaN whose low word is 1954
+    const std::uint64_t bits = 0x7FF00000000007A2ULL;
+    double x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+  }
+}
+
+SEXP R_NilValue = &nil_value;
+SEXP R_DimSymbol = &dim_symbol;
+double R_NaReal = makeNA();
+
+extern "C" {
+
+SEXPTYPE TYPEOF(SEXP x) {return x == nullptr ? NILSXP : x->type;}
+int * INTEGER(SEXP x) {return x->integers.data();}
+int * LOGICAL(SEXP x) {return x->integers.data();}
+double * REAL(SEXP x) {return x->reals.data();}
+
+SEXP VECTOR_ELT(SEXP x, R_xlen_t i) {return x->elements[i];}
+SEXP SET_VECTOR_ELT(SEXP x, R_xlen_t i, SEXP v) {x->elements[i] = v; return v;}
+SEXP STRING_ELT(SEXP x, R_xlen_t i) {return x->elements[i];}
+void SET_STRING_ELT(SEXP x, R_xlen_t i, SEXP v) {x->elements[i] = v;}
+const char * CHAR(SEXP x) {return x->chars.c_str();}
+
+R_xlen_t XLENGTH(SEXP x)
+{
+  switch(TYPEOF(x))
+    {
+    case LGLSXP:
+    case INTSXP:
+      return x->integers.size();
+    case REALSXP:
+      return x->reals.size();
+    case STRSXP:
+    case VECSXP:
+      return x->elements.size();
+    default:
+      return (x == nullptr || x->type == NILSXP) ? 0 : 1;
+    }
+}
+
+R_len_t Rf_length(SEXP x) {return static_cast<R_len_t>(XLENGTH(x));}
+
+SEXP Rf_allocVector(SEXPTYPE type, R_xlen_t length)
+{
+  SEXP x = newObject(type);
+  switch(type)
+    {
+    case LGLSXP:
+    case INTSXP:
+      x->integers.assign(length, 0);
+      break;
+    case REALSXP:
+      x->reals.assign(length, 0.);
+      break;
+    case STRSXP:
+    case VECSXP:
+      x->elements.assign(length, R_NilValue);
+      break;
+    default:
+      break;
+    }
+  return x;
+}
+
+SEXP Rf_allocMatrix(SEXPTYPE type, int nrow, int ncol)
+{
+  SEXP x = Rf_allocVector(type, static_cast<R_xlen_t>(nrow)*ncol);
+  x->dim = Rf_allocVector(INTSXP, 2);
+  x->dim->integers[0] = nrow;
+  x->dim->integers[1] = ncol;
+  return x;
+}
+
+SEXP Rf_getAttrib(SEXP x, SEXP name)
+{
+  if(name == R_DimSymbol && x != nullptr && x->dim != nullptr)
+    return x->dim;
+  return R_NilValue;
+}
+
+SEXP Rf_setAttrib(SEXP x, SEXP name, SEXP value)
+{
+  if(name == R_DimSymbol)
+    x->dim = value;
+  return value;
+}
+
+SEXP Rf_mkChar(const char * s)
+{
+  SEXP x = newObject(SYMSXP);
+  x->chars = s;
+  return x;
+}
+
+SEXP Rf_mkString(const char * s)
+{
+  SEXP x = Rf_allocVector(STRSXP, 1);
+  x->elements[0] = Rf_mkChar(s);
+  return x;
+}
+
+SEXP Rf_ScalarInteger(int v) {SEXP x = Rf_allocVector(INTSXP, 1); x->integers[0] = v; return x;}
+SEXP Rf_ScalarReal(double v) {SEXP x = Rf_allocVector(REALSXP, 1); x->reals[0] = v; return x;}
+SEXP Rf_ScalarLogical(int v) {SEXP x = Rf_allocVector(LGLSXP, 1); x->integers[0] = v; return x;}
+SEXP Rf_install(const char * name) {return std::strcmp(name, "dim") == 0 ? R_DimSymbol : Rf_mkChar(name);}
+
+SEXP Rf_protect(SEXP x) {return x;}
+void Rf_unprotect(int) {}
+
+SEXP R_MakeExternalPtr(void * p, SEXP tag, SEXP prot)
+{
+  SEXP x = newObject(EXTPTRSXP);
+  x->address = p;
+  x->elements = {tag, prot};
+  return x;
+}
+
+void * R_ExternalPtrAddr(SEXP s) {return s->address;}
+void R_ClearExternalPtr(SEXP s) {s->address = nullptr;}
+void R_RegisterCFinalizerEx(SEXP, R_CFinalizer_t, int) {}
+
+int R_IsNA(double x)
+{
+  if(!std::isnan(x))
+    return 0;
+  std::uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(x));
+  return (bits & 0xFFFFFFFFULL) == 1954;
+}
+
+// The messages of the library go to stderr, stdout is left to the benchmark report
+void Rprintf(const char * format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+void REprintf(const char * format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stderr, format, args);
+  va_end(args);
+}
+
+void Rf_error(const char * format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  std::fputs("Error: ", stderr);
+  std::vfprintf(stderr, format, args);
+  std::fputs("\n", stderr);
+  va_end(args);
+  std::abort();
+}
+
+}
+
+namespace
+{
+  //! Regularized lower incomplete gamma function P(a,x), series or continued fraction (Numerical Recipes, 6.2)
+  double regularizedGammaP(double a, double x)
+  {
+    if(x <= 0.)
+      return 0.;
+
+    const double eps = std::numeric_limits<double>::epsilon();
+    const double log_prefactor = -x + a*std::log(x) - std::lgamma(a);
+
+    if(x < a+1.)
+      {
+	double term = 1./a, sum = term;
+	for(int n=1; n<1000 && std::fabs(term) > std::fabs(sum)*eps; ++n)
+	  {
+	    term *= x/(a+n);
+	    sum += term;
+	  }
+	return sum*std::exp(log_prefactor);
+      }
+
+    const double tiny = std::numeric_limits<double>::min()/eps;
+    double b = x+1.-a, c = 1./tiny, d = 1./b, h = d;
+    for(int n=1; n<1000; ++n)
+      {
+	const double an = -n*(n-a);
+	b += 2.;
+	d = an*d+b;
+	if(std::fabs(d) < tiny) d = tiny;
+	c = b+an/c;
+	if(std::fabs(c) < tiny) c = tiny;
+	d = 1./d;
+	const double delta = d*c;
+	h *= delta;
+	if(std::fabs(delta-1.) < eps)
+	  break;
+      }
+    return 1.-std::exp(log_prefactor)*h;
+  }
+}
+
+namespace R
+{
+  double pchisq(double x, double df, int lower_tail, int log_p)
+  {
+    const double p = regularizedGammaP(df/2., x/2.);
+    const double result = lower_tail ? p : 1.-p;
+    return log_p ? std::log(result) : result;
+  }
+
+  double qnorm(double p, double mu, double sigma, int lower_tail, int log_p)
+  {
+    if(log_p)
+      p = std::exp(p);
+    if(!lower_tail)
+      p = 1.-p;
+    if(p <= 0.)
+      return -std::numeric_limits<double>::infinity();
+    if(p >= 1.)
+      return std::numeric_limits<double>::infinity();
+
+    // Rational approximation (P. J. Acklam) refined by one Halley step
+    static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+				1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+				6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+				-2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+				3.754408661907416e+00};
+    const double p_low = 0.02425;
+
+    double z;
+    if(p < p_low)
+      {
+	const double q = std::sqrt(-2.*std::log(p));
+	z = (((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5]) / ((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1.);
+      }
+    else if(p <= 1.-p_low)
+      {
+	const double q = p-0.5, r = q*q;
+	z = (((((a[0]*r+a[1])*r+a[2])*r+a[3])*r+a[4])*r+a[5])*q / (((((b[0]*r+b[1])*r+b[2])*r+b[3])*r+b[4])*r+1.);
+      }
+    else
+      {
+	const double q = std::sqrt(-2.*std::log(1.-p));
+	z = -(((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5]) / ((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1.);
+      }
+
+    const double e = 0.5*std::erfc(-z/std::sqrt(2.))-p;
+    const double u = e*std::sqrt(2.*M_PI)*std::exp(z*z/2.);
+    z = z-u/(1.+z*u/2.);
+
+    return mu+sigma*z;
+  }
+}
@@ -0,0 +1,15 @@
+#ifndef __FDAPDE_SHIM_PRINT_H__
+#define __FDAPDE_SHIM_PRINT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void Rprintf(const char * format, ...);
+void REprintf(const char * format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef __FDAPDE_SHIM_RCPP_H__
+#define __FDAPDE_SHIM_RCPP_H__
+
+// Only the R headers and the distribution functions of Rmath (R:: namespace) are used from Rcpp
+#include "R.h"
+#include "Rinternals.h"
+
+namespace R
+{
+  double pchisq(double x, double df, int lower_tail, int log_p);
+  double qnorm(double p, double mu, double sigma, int lower_tail, int log_p);
+}
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __FDAPDE_SHIM_RDEFINES_H__
+#define __FDAPDE_SHIM_RDEFINES_H__
+
+#include "Rinternals.h"
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef __FDAPDE_SHIM_RINTERNALS_H__
+#define __FDAPDE_SHIM_RINTERNALS_H__
+
+// Minimal replacement of the R API used by the library, to build it without R (see R_Shim.cpp).
+// Only the subset of the API that appears in src/ is provided.
+
+#include <stddef.h>
+#include "R_ext/Print.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SEXPREC * SEXP;
+typedef unsigned int SEXPTYPE;
+typedef int R_len_t;
+typedef ptrdiff_t R_xlen_t;
+
+#define NILSXP		0
+#define SYMSXP		1
+#define LGLSXP		10
+#define INTSXP		13
+#define REALSXP		14
+#define STRSXP		16
+#define VECSXP		19
+#define EXTPTRSXP	22
+
+extern SEXP R_NilValue;
+extern SEXP R_DimSymbol;
+extern double R_NaReal;
+
+SEXPTYPE TYPEOF(SEXP x);
+int * INTEGER(SEXP x);
+int * LOGICAL(SEXP x);
+double * REAL(SEXP x);
+SEXP VECTOR_ELT(SEXP x, R_xlen_t i);
+SEXP SET_VECTOR_ELT(SEXP x, R_xlen_t i, SEXP v);
+SEXP STRING_ELT(SEXP x, R_xlen_t i);
+void SET_STRING_ELT(SEXP x, R_xlen_t i, SEXP v);
+const char * CHAR(SEXP x);
+R_xlen_t XLENGTH(SEXP x);
+R_len_t Rf_length(SEXP x);
+
+SEXP Rf_allocVector(SEXPTYPE type, R_xlen_t length);
+SEXP Rf_allocMatrix(SEXPTYPE type, int nrow, int ncol);
+SEXP Rf_getAttrib(SEXP x, SEXP name);
+SEXP Rf_setAttrib(SEXP x, SEXP name, SEXP value);
+SEXP Rf_mkChar(const char * s);
+SEXP Rf_mkString(const char * s);
+SEXP Rf_ScalarInteger(int x);
+SEXP Rf_ScalarReal(double x);
+SEXP Rf_ScalarLogical(int x);
+SEXP Rf_install(const char * name);
+
+SEXP Rf_protect(SEXP x);
+void Rf_unprotect(int n);
+#define PROTECT(s)	Rf_protect(s)
+#define UNPROTECT(n)	Rf_unprotect(n)
+
+typedef void (*R_CFinalizer_t)(SEXP);
+SEXP R_MakeExternalPtr(void * p, SEXP tag, SEXP prot);
+void * R_ExternalPtrAddr(SEXP s);
+void R_ClearExternalPtr(SEXP s);
+void R_RegisterCFinalizerEx(SEXP s, R_CFinalizer_t fun, int onexit);
+
+// Without R there is no top level to jump back to: the message is printed and the program is aborted
+void Rf_error(const char * format, ...) __attribute__((noreturn));
+
+int R_IsNA(double x);
+#define NA_REAL		R_NaReal
+#define ISNA(x)		R_IsNA(x)
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
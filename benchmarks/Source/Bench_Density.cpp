@@ -0,0 +1,156 @@
+#include "../Include/Bench_Utilities.h"
+// Same order of DE_Skeleton.h, the headers of Density_Estimation are not self-contained
+#include "../../src/Density_Estimation/Include/Data_Problem.h"
+#include "../../src/Density_Estimation/Include/Functional_Problem.h"
+#include "../../src/Density_Estimation/Include/Optimization_Algorithm.h"
+#include "../../src/Density_Estimation/Include/Optimization_Algorithm_Factory.h"
+#include "../../src/Density_Estimation/Include/FE_Density_Estimation.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+  template<UInt mydim, UInt ndim>
+  void bench_density_impl(SyntheticMesh & m, const BenchConfig & config, BenchReport & report)
+  {
+    const UInt n = config.n_density_data;
+    std::vector<Real> points = sample_points(m, n, config.seed);
+    const RNumericMatrix locations(points.data(), n, ndim);
+    std::vector<Point<ndim>> data;
+    data.reserve(n);
+    for(UInt i=0; i<n; ++i)
+      data.emplace_back(i, locations);
+
+    // Default options of DE.FEM, with a single lambda and a bounded number of iterations
+    const std::vector<Real> lambda = {0.1};
+    const std::vector<Real> stepProposals = {0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 1e-7, 1e-8, 1e-9};
+
+    // Lambdas and folds of the cross-validation scenario
+    const std::vector<Real> lambda_cv = {0.1, 0.03, 0.01};
+    const UInt nfolds = 4;
+
+    // density_estimation: fit only; density_ci: fit and confidence bands; density_newton_cg: fit by truncated Newton and backtracking;
+    // density_cv: right cross-validation of lambda, then fit
+    struct DensityScenario{ std::string name; bool inference; std::string direction, step, preprocess; };
+    const std::vector<DensityScenario> scenarios = {{"density_estimation", false, "BFGS", "Fixed_Step", "NoCrossValidation"},
+						    {"density_ci", true, "BFGS", "Fixed_Step", "NoCrossValidation"},
+						    {"density_newton_cg", false, "NewtonCG", "Backtracking_Method", "NoCrossValidation"},
+						    {"density_cv", false, "BFGS", "Fixed_Step", "RightCV"}};
+    for(const DensityScenario & sc : scenarios)
+      {
+	const std::string & scenario = sc.name;
+	const bool inference = sc.inference;
+	const bool cv = sc.preprocess != "NoCrossValidation";
+	if(!config.enabled("density", scenario))
+	  continue;
+
+	const DEData<ndim> deData(data, 1, std::sqrt(Real(n)), VectorXr(), 0.1, 500, cv ? lambda_cv : lambda, cv ? nfolds : 0,
+				  config.n_density_iter, stepProposals, 1e-4, 0., false, 2, inference);
+
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    report.start();
+	    DataProblem<1, mydim, ndim> dataProblem(deData, m.nodes.data(), m.num_nodes, m.sides.data(), m.num_sides, m.elements.data(),
+						    m.num_elements, m.neighbors.data());
+	    FunctionalProblem<1, mydim, ndim> functionalProblem(dataProblem);
+	    std::shared_ptr<MinimizationAlgorithm<1, mydim, ndim>> minimizationAlgo =
+	      MinimizationAlgorithm_factory<1, mydim, ndim>::createStepSolver(dataProblem, functionalProblem, sc.direction, sc.step);
+	    FEDE<1, mydim, ndim> fede(dataProblem, functionalProblem, minimizationAlgo, sc.preprocess);
+	    fede.apply();
+	    report.stop(scenario, n, rep, inference ? Real((fede.getCI_U_g() - fede.getCI_L_g()).sum()) : fede.getDensity_g().sum());
+	  }
+      }
+
+    // density_heat_cv: initial density chosen by cross-validation among the steps of the discretized heat diffusion (DE.heat.FEM)
+    if(config.enabled("density", "density_heat_cv"))
+      {
+	const DEData<ndim> deData(data, 1, std::sqrt(Real(n)), VectorXr(), 0.1, 500, lambda, 0, config.n_density_iter, stepProposals,
+				  1e-4, 0., false, 2, false);
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    report.start();
+	    DataProblem<1, mydim, ndim> dataProblem(deData, m.nodes.data(), m.num_nodes, m.sides.data(), m.num_sides, m.elements.data(),
+						    m.num_elements, m.neighbors.data());
+	    FunctionalProblem<1, mydim, ndim> functionalProblem(dataProblem);
+	    Heat_CV<1, mydim, ndim> densityInit(dataProblem, functionalProblem, 5);
+	    report.stop("density_heat_cv", n, rep, densityInit.chooseInitialization(0)->sum());
+	  }
+      }
+
+    // Space-time problem (defaults of DE.FEM.time), with 20 times more data, uniform in time on [0,1], a time mesh with 10 intervals
+    // and a spatial mesh with 4 times fewer cells on each side (the space penalty of DataProblem_time is assembled as a full product).
+    // density_time_setup: construction of the space-time data problem; density_time_functional: 100 evaluations of the functional
+    // and of its gradient
+    if(config.enabled("density", "density_time_setup") || config.enabled("density", "density_time_functional"))
+      {
+	const UInt n_time = 20*n;
+	SyntheticMesh coarse = build_mesh(m.domain, std::max<UInt>(m.mydim == 3 ? config.scale_3d/4 : config.scale/4, 2));
+	report.setMesh(coarse);
+
+	std::vector<Real> points_time = sample_points(coarse, n_time, config.seed);
+	const RNumericMatrix locations_time(points_time.data(), n_time, ndim);
+	std::vector<Point<ndim>> data_space;
+	data_space.reserve(n_time);
+	for(UInt i=0; i<n_time; ++i)
+	  data_space.emplace_back(i, locations_time);
+
+	std::mt19937 generator(config.seed+1);
+	std::uniform_real_distribution<Real> time_distribution(0., 1.);
+	std::vector<Real> data_time(n_time);
+	for(Real & t : data_time)
+	  t = time_distribution(generator);
+	std::vector<Real> mesh_time(11);
+	for(std::size_t i=0; i<mesh_time.size(); ++i)
+	  mesh_time[i] = i/10.;
+
+	const DEData<ndim> deData(data_space, 1, std::sqrt(Real(n_time)), VectorXr(), 0.1, 10, lambda, 0, config.n_density_iter,
+				  stepProposals, 1e-4, 0., false, 2, false);
+	const DEData_time deData_time(data_time, lambda);
+
+	for(UInt rep=0; rep<config.reps && config.enabled("density", "density_time_setup"); ++rep)
+	  {
+	    report.start();
+	    DataProblem_time<1, mydim, ndim> dataProblem(deData, deData_time, coarse.nodes.data(), coarse.num_nodes, coarse.sides.data(),
+							 coarse.num_sides, coarse.elements.data(), coarse.num_elements, coarse.neighbors.data(), mesh_time, false, false, false);
+	    report.stop("density_time_setup", n_time, rep,
+			Real((dataProblem.getUpsilon()*VectorXr::LinSpaced(dataProblem.getUpsilon().cols(), 0., 1.)).sum()));
+	  }
+
+	if(config.enabled("density", "density_time_functional"))
+	  {
+	    DataProblem_time<1, mydim, ndim> dataProblem(deData, deData_time, coarse.nodes.data(), coarse.num_nodes, coarse.sides.data(),
+							 coarse.num_sides, coarse.elements.data(), coarse.num_elements, coarse.neighbors.data(), mesh_time, false, false, false);
+	    FunctionalProblem_time<1, mydim, ndim> functionalProblem(dataProblem);
+	    const auto & Upsilon = dataProblem.getUpsilon();
+	    const VectorXr upsilon_sum = Upsilon.transpose()*VectorXr::Ones(Upsilon.rows());
+	    const VectorXr g = VectorXr::LinSpaced(Upsilon.cols(), -1., 1.);
+	    for(UInt rep=0; rep<config.reps; ++rep)
+	      {
+		report.start();
+		Real checksum = 0.;
+		for(UInt k=0; k<100; ++k)
+		  {
+		    Real loss;
+		    VectorXr grad;
+		    std::tie(loss, grad, std::ignore, std::ignore, std::ignore) =
+		      functionalProblem.computeFunctional_g(g, lambda[0], lambda[0], upsilon_sum, Upsilon.rows());
+		    checksum += loss + grad.sum();
+		  }
+		report.stop("density_time_functional", n_time, rep, checksum);
+	      }
+	  }
+	report.setMesh(m);
+      }
+  }
+}
+
+void bench_density(SyntheticMesh & mesh, const BenchConfig & config, BenchReport & report)
+{
+  if(mesh.mydim==2 && mesh.ndim==2)
+    bench_density_impl<2, 2>(mesh, config, report);
+  else if(mesh.mydim==2 && mesh.ndim==3)
+    bench_density_impl<2, 3>(mesh, config, report);
+  else if(mesh.mydim==3 && mesh.ndim==3)
+    bench_density_impl<3, 3>(mesh, config, report);
+}
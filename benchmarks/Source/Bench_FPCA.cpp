@@ -0,0 +1,61 @@
+#include "../Include/Bench_Utilities.h"
+#include "../../src/FPCA/Include/FPCA_Data.h"
+#include "../../src/FPCA/Include/Mixed_FE_FPCA.h"
+#include "../../src/FPCA/Include/Mixed_FE_FPCA_Factory.h"
+#include "../../src/Mesh/Include/Mesh.h"
+#include <cmath>
+#include <random>
+
+namespace
+{
+  template<UInt mydim, UInt ndim>
+  void bench_fpca_impl(SyntheticMesh & m, const BenchConfig & config, BenchReport & report)
+  {
+    if(!config.enabled("fpca", "fpca"))
+      return;
+
+    // Curves made of three smooth components with random scores, plus noise
+    const UInt n = config.locations(m.num_nodes);
+    std::vector<Real> points = sample_points(m, n, config.seed);
+    MatrixXr datamatrix(config.n_curves, n);
+    std::mt19937 generator(config.seed+2);
+    std::normal_distribution<Real> normal(0., 1.);
+    for(UInt k=0; k<config.n_curves; ++k)
+      {
+	const Real scores[3] = {3*normal(generator), 2*normal(generator), normal(generator)};
+	for(UInt i=0; i<n; ++i)
+	  {
+	    const Real x = points[i], y = points[i+n];
+	    datamatrix(k,i) = scores[0]*std::sin(M_PI*x)*std::sin(M_PI*y) + scores[1]*std::cos(2*M_PI*x)
+			      + scores[2]*std::cos(2*M_PI*y) + 0.1*normal(generator);
+	  }
+      }
+
+    MatrixXi incidence;
+    FPCAData fpcaData(points.data(), n, ndim, datamatrix, 1, incidence, {1e-2}, config.n_components, 0, 2);
+    MeshHandler<1, mydim, ndim> mesh(m.nodes.data(), m.num_nodes, m.sides.data(), m.num_sides, m.elements.data(), m.num_elements,
+				     m.neighbors.data(), 2);
+
+    for(UInt rep=0; rep<config.reps; ++rep)
+      {
+	report.start();
+	std::unique_ptr<MixedFEFPCABase> fpca = MixedFEFPCAfactory::createFPCAsolver("NoValidation", fpcaData);
+	fpca->template SetAndFixParameters<1, mydim, ndim>(mesh);
+	fpca->apply();
+	Real checksum = 0.;
+	for(const VectorXr & loadings : fpca->getLoadingsMat())
+	  checksum += loadings.cwiseAbs().sum();
+	report.stop("fpca", n, rep, checksum);
+      }
+  }
+}
+
+void bench_fpca(SyntheticMesh & mesh, const BenchConfig & config, BenchReport & report)
+{
+  if(mesh.mydim==2 && mesh.ndim==2)
+    bench_fpca_impl<2, 2>(mesh, config, report);
+  else if(mesh.mydim==2 && mesh.ndim==3)
+    bench_fpca_impl<2, 3>(mesh, config, report);
+  else if(mesh.mydim==3 && mesh.ndim==3)
+    bench_fpca_impl<3, 3>(mesh, config, report);
+}
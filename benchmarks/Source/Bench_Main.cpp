@@ -0,0 +1,128 @@
+//! Standalone benchmarks of the fdaPDE library, built without R (see benchmarks/README.md)
+/*!
+  Usage: fdaPDE_bench [options], the timings are written as CSV (one line for each repetition of each scenario).
+  The messages of the library are written to stderr.
+*/
+
+#include "../Include/Bench_Utilities.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+  void print_usage(void)
+  {
+    std::cerr << "Usage: fdaPDE_bench [options]\n"
+	      << "  --domains LIST       comma separated domains among 2D, 2.5D, 3D [all]\n"
+	      << "  --scenarios LIST     comma separated scenarios or groups (mesh, regression, density, fpca) [all]\n"
+	      << "  --scale N            cells on each side of the 2D and 2.5D meshes [32]\n"
+	      << "  --scale-3d N         cells on each side of the 3D mesh [12]\n"
+	      << "  --reps N             repetitions of each scenario [3]\n"
+	      << "  --locations N        observation and query points, 0 for as many as the nodes [1000]\n"
+	      << "  --lambdas N          size of the lambda grid of the GCV sweep [10]\n"
+	      << "  --realizations N     realizations of the stochastic GCV [100]\n"
+	      << "  --flips N            flips of the sign-flip test [1000]\n"
+	      << "  --mc-error X         error probability of the early stopping of the sign-flip tests, 0 for all the flips [0]\n"
+	      << "  --density-data N     points of the density estimation problem [1000]\n"
+	      << "  --density-iter N     maximum iterations of the density estimation optimizer [50]\n"
+	      << "  --curves N           curves of the FPCA problem [50]\n"
+	      << "  --components N       principal components of the FPCA problem [3]\n"
+	      << "  --seed N             seed of the synthetic data [42]\n"
+	      << "  --output FILE        CSV output file [stdout]\n";
+  }
+
+  std::vector<std::string> split(const std::string & list)
+  {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while(std::getline(stream, item, ','))
+      if(!item.empty())
+	items.push_back(item);
+    return items;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  BenchConfig config;
+  std::vector<std::string> domains = {"2D", "2.5D", "3D"};
+  std::string output;
+
+  for(int i=1; i<argc; ++i)
+    {
+      const std::string option = argv[i];
+      if(option == "--help" || option == "-h")
+	{
+	  print_usage();
+	  return 0;
+	}
+      if(i+1 >= argc)
+	{
+	  std::cerr << "ERROR: missing value for " << option << "\n";
+	  print_usage();
+	  return 1;
+	}
+
+      const std::string value = argv[++i];
+      if(option == "--domains")
+	domains = split(value);
+      else if(option == "--scenarios")
+	{
+	  const std::vector<std::string> scenarios = split(value);
+	  config.scenarios.insert(scenarios.begin(), scenarios.end());
+	}
+      else if(option == "--scale") config.scale = std::stoi(value);
+      else if(option == "--scale-3d") config.scale_3d = std::stoi(value);
+      else if(option == "--reps") config.reps = std::stoi(value);
+      else if(option == "--locations") config.n_locations = std::stoi(value);
+      else if(option == "--lambdas") config.n_lambdas = std::stoi(value);
+      else if(option == "--realizations") config.n_realizations = std::stoi(value);
+      else if(option == "--flips") config.n_flips = std::stoi(value);
+      else if(option == "--mc-error") config.mc_error = std::stod(value);
+      else if(option == "--density-data") config.n_density_data = std::stoi(value);
+      else if(option == "--density-iter") config.n_density_iter = std::stoi(value);
+      else if(option == "--curves") config.n_curves = std::stoi(value);
+      else if(option == "--components") config.n_components = std::stoi(value);
+      else if(option == "--seed") config.seed = std::stoi(value);
+      else if(option == "--output") output = value;
+      else
+	{
+	  std::cerr << "ERROR: unknown option " << option << "\n";
+	  print_usage();
+	  return 1;
+	}
+    }
+
+  std::ofstream file;
+  if(!output.empty())
+    {
+      file.open(output);
+      if(!file)
+	{
+	  std::cerr << "ERROR: " << output << " could not be opened\n";
+	  return 1;
+	}
+    }
+  BenchReport report(output.empty() ? std::cout : file);
+
+  for(const std::string & domain : domains)
+    {
+      if(domain != "2D" && domain != "2.5D" && domain != "3D")
+	{
+	  std::cerr << "ERROR: unknown domain " << domain << "\n";
+	  return 1;
+	}
+
+      SyntheticMesh mesh = build_mesh(domain, domain == "3D" ? config.scale_3d : config.scale);
+      report.setMesh(mesh);
+
+      bench_mesh(mesh, config, report);
+      bench_regression(mesh, config, report);
+      bench_density(mesh, config, report);
+      bench_fpca(mesh, config, report);
+    }
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+#include "../Include/Bench_Utilities.h"
+#include "../../src/FE_Assemblers_Solvers/Include/Finite_Element.h"
+#include "../../src/FE_Assemblers_Solvers/Include/Matrix_Assembler.h"
+#include "../../src/Mesh/Include/Mesh.h"
+
+namespace
+{
+  template<UInt mydim, UInt ndim>
+  using BenchMesh = MeshHandler<1, mydim, ndim>;
+
+  template<UInt mydim, UInt ndim>
+  std::unique_ptr<BenchMesh<mydim, ndim>> make_mesh(SyntheticMesh & m, UInt search)
+  {
+    return fdaPDE::make_unique<BenchMesh<mydim, ndim>>(m.nodes.data(), m.num_nodes, m.sides.data(), m.num_sides,
+						       m.elements.data(), m.num_elements, m.neighbors.data(), search);
+  }
+
+  //! Sum of the ids of the elements containing the points (-1 for the points not found)
+  template<UInt mydim, UInt ndim>
+  Real locate_all(const BenchMesh<mydim, ndim> & mesh, const RNumericMatrix & locations)
+  {
+    Real checksum = 0.;
+    for(UInt i=0; i<locations.nrows(); ++i)
+      checksum += mesh.findLocation(Point<ndim>(i, locations)).getId();
+    return checksum;
+  }
+
+  template<UInt mydim, UInt ndim>
+  typename std::enable_if<mydim==ndim, void>::type
+  bench_walking(SyntheticMesh & m, const RNumericMatrix & locations, const BenchConfig & config, BenchReport & report)
+  {
+    if(!config.enabled("mesh", "point_location_walking"))
+      return;
+
+    auto mesh = make_mesh<mydim, ndim>(m, 3);
+    for(UInt rep=0; rep<config.reps; ++rep)
+      {
+	report.start();
+	const Real checksum = locate_all<mydim, ndim>(*mesh, locations);
+	report.stop("point_location_walking", locations.nrows(), rep, checksum);
+      }
+  }
+
+  template<UInt mydim, UInt ndim>
+  typename std::enable_if<mydim!=ndim, void>::type
+  bench_walking(SyntheticMesh &, const RNumericMatrix &, const BenchConfig &, BenchReport &)
+  {
+    // The visibility walk is not defined on manifolds
+  }
+
+  template<UInt mydim, UInt ndim>
+  void bench_mesh_impl(SyntheticMesh & m, const BenchConfig & config, BenchReport & report)
+  {
+    const UInt n_points = config.locations(m.num_nodes);
+    std::vector<Real> points = sample_points(m, n_points, config.seed);
+    const RNumericMatrix locations(points.data(), n_points, ndim);
+
+    if(config.enabled("mesh", "tree_build"))
+      for(UInt rep=0; rep<config.reps; ++rep)
+	{
+	  report.start();
+	  auto mesh = make_mesh<mydim, ndim>(m, 2);
+	  report.stop("tree_build", m.num_elements, rep, mesh->getTree().gettreeheader().gettreelev());
+	}
+
+    if(config.enabled("mesh", "point_location_tree"))
+      {
+	auto mesh = make_mesh<mydim, ndim>(m, 2);
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    report.start();
+	    const Real checksum = locate_all<mydim, ndim>(*mesh, locations);
+	    report.stop("point_location_tree", n_points, rep, checksum);
+	  }
+      }
+
+    bench_walking<mydim, ndim>(m, locations, config, report);
+
+    if(config.enabled("mesh", "assembly_mass") || config.enabled("mesh", "assembly_stiff"))
+      {
+	auto mesh = make_mesh<mydim, ndim>(m, 1);
+	FiniteElement<1, mydim, ndim> fe;
+	typedef EOExpr<Mass> ETMass; Mass EMass; ETMass mass(EMass);
+	typedef EOExpr<Stiff> ETStiff; Stiff EStiff; ETStiff stiff(EStiff);
+
+	for(UInt rep=0; rep<config.reps && config.enabled("mesh", "assembly_mass"); ++rep)
+	  {
+	    SpMat R0;
+	    report.start();
+	    Assembler::operKernel(mass, *mesh, fe, R0);
+	    report.stop("assembly_mass", m.num_elements, rep, R0.sum());
+	  }
+
+	for(UInt rep=0; rep<config.reps && config.enabled("mesh", "assembly_stiff"); ++rep)
+	  {
+	    SpMat R1;
+	    report.start();
+	    Assembler::operKernel(stiff, *mesh, fe, R1);
+	    report.stop("assembly_stiff", m.num_elements, rep, R1.norm());
+	  }
+      }
+  }
+}
+
+void bench_mesh(SyntheticMesh & mesh, const BenchConfig & config, BenchReport & report)
+{
+  if(mesh.mydim==2 && mesh.ndim==2)
+    bench_mesh_impl<2, 2>(mesh, config, report);
+  else if(mesh.mydim==2 && mesh.ndim==3)
+    bench_mesh_impl<2, 3>(mesh, config, report);
+  else if(mesh.mydim==3 && mesh.ndim==3)
+    bench_mesh_impl<3, 3>(mesh, config, report);
+}
@@ -0,0 +1,334 @@
+#include "../Include/Bench_Utilities.h"
+#include "../../src/Skeletons/Include/Regression_Skeleton.h"
+#include "../../src/Inference/Include/Inference_Data.h"
+#include "../../src/Lambda_Optimization/Include/Optimization_Data.h"
+#include "../../src/Mesh/Include/Mesh.h"
+#include "../../src/Regression/Include/Mixed_FE_Regression.h"
+#include "../../src/Regression/Include/Regression_Data.h"
+#include <cmath>
+#include <random>
+
+namespace
+{
+  //! Data of a synthetic regression problem: a smooth field, two covariates (the second without effect) and gaussian noise
+  struct RegressionProblem
+  {
+    std::vector<Real> points;
+    VectorXr observations;
+    MatrixXr covariates;
+    VectorXr weights;
+    std::vector<UInt> bc_indices;
+    std::vector<Real> bc_values;
+    MatrixXi incidence;
+  };
+
+  RegressionProblem make_problem(const SyntheticMesh & m, UInt n, UInt seed)
+  {
+    RegressionProblem problem;
+    problem.points = sample_points(m, n, seed);
+    problem.observations.resize(n);
+    problem.covariates.resize(n, 2);
+
+    std::mt19937 generator(seed+1);
+    std::normal_distribution<Real> normal(0., 1.);
+    for(UInt i=0; i<n; ++i)
+      {
+	const Real x = problem.points[i], y = problem.points[i+n];
+	const Real z = (m.ndim == 3) ? problem.points[i+2*n] : 0.;
+	problem.covariates(i,0) = normal(generator);
+	problem.covariates(i,1) = normal(generator);
+	problem.observations[i] = std::sin(2*M_PI*x)*std::cos(2*M_PI*y)*std::cos(M_PI*z)
+				  + problem.covariates(i,0) + 0.1*normal(generator);
+      }
+    return problem;
+  }
+
+  OptimizationData make_optimization(const std::vector<Real> & lambdas, bool gcv, const BenchConfig & config)
+  {
+    OptimizationData optimizationData;
+    optimizationData.set_lambda_S(lambdas);
+    if(gcv)
+      {
+	optimizationData.set_loss_function("GCV");
+	optimizationData.set_DOF_evaluation("stochastic");
+	optimizationData.set_nrealizations(config.n_realizations);
+	optimizationData.set_seed(config.seed);
+      }
+    return optimizationData;
+  }
+
+  template<UInt mydim, UInt ndim>
+  void bench_regression_impl(SyntheticMesh & m, const BenchConfig & config, BenchReport & report)
+  {
+    const UInt n = config.locations(m.num_nodes);
+    RegressionProblem problem = make_problem(m, n, config.seed);
+    RegressionData regressionData(problem.points.data(), n, ndim, problem.observations, 1, problem.covariates, problem.weights,
+				  problem.bc_indices, problem.bc_values, problem.incidence, false, 2);
+    MeshHandler<1, mydim, ndim> mesh(m.nodes.data(), m.num_nodes, m.sides.data(), m.num_sides, m.elements.data(), m.num_elements,
+				     m.neighbors.data(), 2);
+    const std::vector<Real> lambda = {1e-2};
+
+    // Psi, R0 and R1
+    for(UInt rep=0; rep<config.reps && config.enabled("regression", "regression_preapply"); ++rep)
+      {
+	OptimizationData optimizationData = make_optimization(lambda, false, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	report.start();
+	regression.preapply(mesh);
+	report.stop("regression_preapply", n, rep, regression.getpsi_()->sum());
+      }
+
+    // Factorization of the system and solution for a single lambda
+    for(UInt rep=0; rep<config.reps && config.enabled("regression", "factorization"); ++rep)
+      {
+	OptimizationData optimizationData = make_optimization(lambda, false, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	regression.preapply(mesh);
+	report.start();
+	std::pair<MatrixXr, output_Data<1>> solution = regression_solution_selection<RegressionData>(regressionData, optimizationData, regression);
+	report.stop("factorization", n, rep, solution.first.topRows(m.num_nodes).norm());
+      }
+
+    // Grid of lambdas selected through the stochastic GCV
+    std::vector<Real> lambdas(config.n_lambdas);
+    for(UInt i=0; i<config.n_lambdas; ++i)
+      lambdas[i] = std::pow(10., -5.+4.*i/std::max(1, config.n_lambdas-1));
+
+    for(UInt rep=0; rep<config.reps && config.enabled("regression", "gcv_sweep"); ++rep)
+      {
+	OptimizationData optimizationData = make_optimization(lambdas, true, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	regression.preapply(mesh);
+	report.start();
+	std::pair<MatrixXr, output_Data<1>> solution = regression_solution_selection<RegressionData>(regressionData, optimizationData, regression);
+	report.stop("gcv_sweep", n, rep, solution.second.GCV_opt);
+      }
+
+    // Eigen sign-flip test on the coefficients of the covariates, on an already fitted model
+    if(config.enabled("regression", "sign_flip"))
+      {
+	OptimizationData optimizationData = make_optimization(lambda, false, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	regression.preapply(mesh);
+	std::pair<MatrixXr, output_Data<1>> solution = regression_solution_selection<RegressionData>(regressionData, optimizationData, regression);
+
+	InferenceData inferenceData;
+	inferenceData.set_definition(true);
+	inferenceData.set_test_type({"one-at-the-time"});
+	inferenceData.set_interval_type({"not-defined"});
+	inferenceData.set_implementation_type({"eigen-sign-flip"});
+	inferenceData.set_component_type({"parametric"});
+	inferenceData.set_enhanced_inference({false});
+	inferenceData.set_coeff_inference(MatrixXr::Identity(2, 2));
+	inferenceData.set_beta_0(VectorXr::Zero(2));
+	inferenceData.set_inference_quantile(VectorXr::Constant(1, 1.96));
+	inferenceData.set_n_Flip(config.n_flips);
+	inferenceData.set_seed_Flip(config.seed);
+	inferenceData.set_mc_Error(config.mc_error);
+
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    MatrixXv inference_Output;
+	    report.start();
+	    regression_inference_selection<RegressionData, 1, mydim, ndim>(mesh, regressionData, optimizationData, inferenceData, regression, solution, inference_Output);
+	    report.stop("sign_flip", n, rep, inference_Output(0,0).sum());
+	  }
+      }
+
+    // Eigen sign-flip test on the nonparametric component in the observed locations, on an already fitted model
+    if(config.enabled("regression", "sign_flip_f"))
+      {
+	OptimizationData optimizationData = make_optimization(lambda, false, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	regression.preapply(mesh);
+	std::pair<MatrixXr, output_Data<1>> solution = regression_solution_selection<RegressionData>(regressionData, optimizationData, regression);
+
+	std::vector<UInt> locs_index(n);
+	for(UInt i=0; i<n; ++i)
+	  locs_index[i] = i;
+
+	InferenceData inferenceData;
+	inferenceData.set_definition(true);
+	inferenceData.set_test_type({"simultaneous"});
+	inferenceData.set_interval_type({"not-defined"});
+	inferenceData.set_implementation_type({"eigen-sign-flip"});
+	inferenceData.set_component_type({"nonparametric"});
+	inferenceData.set_enhanced_inference({false});
+	inferenceData.set_coeff_inference(MatrixXr::Identity(2, 2));
+	inferenceData.set_beta_0(VectorXr::Zero(2));
+	inferenceData.set_locs_index_inference(locs_index);
+	inferenceData.set_locs_are_nodes_inference(false);
+	// null hypothesis: the fitted field itself, z_hat - W*beta_hat
+	inferenceData.set_f_0(solution.second.z_hat.col(0) - (*regressionData.getCovariates())*solution.second.betas(0));
+	inferenceData.set_inference_quantile(VectorXr::Constant(1, 1.96));
+	inferenceData.set_n_Flip(config.n_flips);
+	inferenceData.set_seed_Flip(config.seed);
+	inferenceData.set_mc_Error(config.mc_error);
+
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    MatrixXv inference_Output;
+	    report.start();
+	    regression_inference_selection<RegressionData, 1, mydim, ndim>(mesh, regressionData, optimizationData, inferenceData, regression, solution, inference_Output);
+	    report.stop("sign_flip_f", n, rep, inference_Output(1,0)(0));
+	  }
+      }
+
+    // Eigen sign-flip confidence intervals on the coefficients of the covariates, on an already fitted model
+    if(config.enabled("regression", "sign_flip_ci"))
+      {
+	OptimizationData optimizationData = make_optimization(lambda, false, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	regression.preapply(mesh);
+	std::pair<MatrixXr, output_Data<1>> solution = regression_solution_selection<RegressionData>(regressionData, optimizationData, regression);
+
+	InferenceData inferenceData;
+	inferenceData.set_definition(true);
+	inferenceData.set_test_type({"not-defined"});
+	inferenceData.set_interval_type({"one-at-the-time"});
+	inferenceData.set_implementation_type({"eigen-sign-flip"});
+	inferenceData.set_component_type({"parametric"});
+	inferenceData.set_enhanced_inference({false});
+	inferenceData.set_coeff_inference(MatrixXr::Identity(2, 2));
+	inferenceData.set_beta_0(VectorXr::Zero(2));
+	inferenceData.set_inference_quantile(VectorXr::Constant(1, 1.96));
+	inferenceData.set_inference_Alpha(VectorXr::Constant(1, 0.05));
+	inferenceData.set_n_Flip(config.n_flips);
+	inferenceData.set_seed_Flip(config.seed);
+
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    MatrixXv inference_Output;
+	    report.start();
+	    regression_inference_selection<RegressionData, 1, mydim, ndim>(mesh, regressionData, optimizationData, inferenceData, regression, solution, inference_Output);
+	    report.stop("sign_flip_ci", n, rep, inference_Output(0,1)(0) + inference_Output(0,1)(2) + inference_Output(0,2)(0) + inference_Output(0,2)(2));
+	  }
+      }
+
+    // Speckman tests and confidence intervals on the coefficients of the covariates, on an already fitted model
+    if(config.enabled("regression", "speckman"))
+      {
+	OptimizationData optimizationData = make_optimization(lambda, false, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	regression.preapply(mesh);
+	std::pair<MatrixXr, output_Data<1>> solution = regression_solution_selection<RegressionData>(regressionData, optimizationData, regression);
+
+	InferenceData inferenceData;
+	inferenceData.set_definition(true);
+	inferenceData.set_test_type({"one-at-the-time"});
+	inferenceData.set_interval_type({"one-at-the-time"});
+	inferenceData.set_implementation_type({"speckman"});
+	inferenceData.set_component_type({"parametric"});
+	inferenceData.set_enhanced_inference({false});
+	inferenceData.set_coeff_inference(MatrixXr::Identity(2, 2));
+	inferenceData.set_beta_0(VectorXr::Zero(2));
+	inferenceData.set_inference_quantile(VectorXr::Constant(1, 1.96));
+	inferenceData.set_inference_Alpha(VectorXr::Constant(1, 0.05));
+
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    MatrixXv inference_Output;
+	    report.start();
+	    regression_inference_selection<RegressionData, 1, mydim, ndim>(mesh, regressionData, optimizationData, inferenceData, regression, solution, inference_Output);
+	    report.stop("speckman", n, rep, inference_Output(0,0).sum() + inference_Output(0,1)(0) + inference_Output(0,1)(2) + inference_Output(0,2)(0) + inference_Output(0,2)(2));
+	  }
+      }
+
+    // Wald and eigen-sign-flip confidence intervals on the nonparametric component in the observed locations, required together on an already fitted model
+    if(config.enabled("regression", "wald_esf_f_ci"))
+      {
+	OptimizationData optimizationData = make_optimization(lambda, false, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	regression.preapply(mesh);
+	std::pair<MatrixXr, output_Data<1>> solution = regression_solution_selection<RegressionData>(regressionData, optimizationData, regression);
+
+	const UInt n_loc = std::min(n, 200);
+	std::vector<UInt> locs_index(n_loc);
+	for(UInt i=0; i<n_loc; ++i)
+	  locs_index[i] = i;
+
+	InferenceData inferenceData;
+	inferenceData.set_definition(true);
+	inferenceData.set_test_type({"not-defined", "not-defined"});
+	inferenceData.set_interval_type({"one-at-the-time", "one-at-the-time"});
+	inferenceData.set_implementation_type({"wald", "eigen-sign-flip"});
+	inferenceData.set_component_type({"nonparametric", "nonparametric"});
+	inferenceData.set_enhanced_inference({false, false});
+	inferenceData.set_coeff_inference(MatrixXr::Identity(2, 2));
+	inferenceData.set_beta_0(VectorXr::Zero(2));
+	inferenceData.set_locs_index_inference(locs_index);
+	inferenceData.set_locs_are_nodes_inference(false);
+	inferenceData.set_inference_quantile(VectorXr::Constant(2, 1.96));
+	inferenceData.set_inference_Alpha(VectorXr::Constant(2, 0.05));
+	inferenceData.set_n_Flip(config.n_flips);
+	inferenceData.set_seed_Flip(config.seed);
+
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    MatrixXv inference_Output;
+	    report.start();
+	    regression_inference_selection<RegressionData, 1, mydim, ndim>(mesh, regressionData, optimizationData, inferenceData, regression, solution, inference_Output);
+	    // widths of the intervals, the ones of eigen-sign-flip only where the search has converged
+	    Real width = 0;
+	    for(UInt i=0; i<n_loc; ++i)
+	      for(UInt row : {1, 3})
+		if(std::abs(inference_Output(row,i+1)(0)) < 1e20 && std::abs(inference_Output(row,i+1)(2)) < 1e20)
+		  width += inference_Output(row,i+1)(2) - inference_Output(row,i+1)(0);
+	    report.stop("wald_esf_f_ci", n, rep, width);
+	  }
+      }
+
+    // Wald confidence intervals on the nonparametric component in many arbitrary points, on an already fitted model
+    if(config.enabled("regression", "wald_f_ci"))
+      {
+	OptimizationData optimizationData = make_optimization(lambda, false, config);
+	MixedFERegression<RegressionData> regression(regressionData, optimizationData, m.num_nodes);
+	regression.preapply(mesh);
+	std::pair<MatrixXr, output_Data<1>> solution = regression_solution_selection<RegressionData>(regressionData, optimizationData, regression);
+
+	const UInt n_loc = 10*n;
+	const std::vector<Real> loc_points = sample_points(m, n_loc, config.seed+2);
+	MatrixXr locations(n_loc, ndim);
+	for(UInt i=0; i<n_loc; ++i)
+	  for(UInt d=0; d<ndim; ++d)
+	    locations(i,d) = loc_points[i+d*n_loc];
+
+	InferenceData inferenceData;
+	inferenceData.set_definition(true);
+	inferenceData.set_test_type({"not-defined"});
+	inferenceData.set_interval_type({"one-at-the-time"});
+	inferenceData.set_implementation_type({"wald"});
+	inferenceData.set_component_type({"nonparametric"});
+	inferenceData.set_exact_inference("exact");
+	inferenceData.set_enhanced_inference({false});
+	inferenceData.set_coeff_inference(MatrixXr::Identity(2, 2));
+	inferenceData.set_beta_0(VectorXr::Zero(2));
+	inferenceData.set_locs_inference(locations);
+	inferenceData.set_locs_index_inference({-1});
+	inferenceData.set_locs_are_nodes_inference(false);
+	inferenceData.set_inference_quantile(VectorXr::Constant(1, 1.96));
+	inferenceData.set_inference_Alpha(VectorXr::Constant(1, 0.05));
+
+	for(UInt rep=0; rep<config.reps; ++rep)
+	  {
+	    MatrixXv inference_Output;
+	    report.start();
+	    regression_inference_selection<RegressionData, 1, mydim, ndim>(mesh, regressionData, optimizationData, inferenceData, regression, solution, inference_Output);
+	    Real width = 0;
+	    for(UInt i=0; i<n_loc; ++i)
+	      width += inference_Output(1,i+1)(2) - inference_Output(1,i+1)(0);
+	    report.stop("wald_f_ci", n_loc, rep, width);
+	  }
+      }
+  }
+}
+
+void bench_regression(SyntheticMesh & mesh, const BenchConfig & config, BenchReport & report)
+{
+  if(mesh.mydim==2 && mesh.ndim==2)
+    bench_regression_impl<2, 2>(mesh, config, report);
+  else if(mesh.mydim==2 && mesh.ndim==3)
+    bench_regression_impl<2, 3>(mesh, config, report);
+  else if(mesh.mydim==3 && mesh.ndim==3)
+    bench_regression_impl<3, 3>(mesh, config, report);
+}
@@ -0,0 +1,231 @@
+#include "../Include/Bench_Utilities.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sys/resource.h>
+
+namespace
+{
+  //! Fills sides and neighbors of a simplicial mesh from its elements, matching the faces opposite to each vertex
+  void build_connectivity(SyntheticMesh & mesh)
+  {
+    const UInt nvertices = mesh.mydim+1;
+    const UInt ne = mesh.num_elements;
+    std::map<std::array<UInt, 3>, std::pair<UInt, UInt>> faces;	// face -> first element and its local vertex
+
+    mesh.neighbors.assign(ne*nvertices, -1);
+    std::vector<std::array<UInt, 3>> sides;
+    for(UInt e=0; e<ne; ++e)
+      for(UInt k=0; k<nvertices; ++k)
+	{
+	  std::array<UInt, 3> face = {-1, -1, -1};
+	  for(UInt j=0, l=0; j<nvertices; ++j)
+	    if(j != k)
+	      face[l++] = mesh.elements[e+ne*j];
+	  std::sort(face.begin(), face.begin()+mesh.mydim);
+
+	  auto it = faces.find(face);
+	  if(it == faces.end())
+	    {
+	      faces.emplace(face, std::make_pair(e, k));
+	      sides.push_back(face);
+	    }
+	  else
+	    {
+	      mesh.neighbors[e+ne*k] = it->second.first;
+	      mesh.neighbors[it->second.first+ne*it->second.second] = e;
+	    }
+	}
+
+    mesh.num_sides = sides.size();
+    mesh.sides.resize(mesh.num_sides*mesh.mydim);
+    for(UInt i=0; i<mesh.num_sides; ++i)
+      for(UInt j=0; j<mesh.mydim; ++j)
+	mesh.sides[i+mesh.num_sides*j] = sides[i][j];
+  }
+}
+
+SyntheticMesh build_square_mesh(UInt n)
+{
+  SyntheticMesh mesh;
+  mesh.domain = "2D";
+  mesh.mydim = 2;
+  mesh.ndim = 2;
+  mesh.num_nodes = (n+1)*(n+1);
+  mesh.num_elements = 2*n*n;
+
+  mesh.nodes.resize(2*mesh.num_nodes);
+  for(UInt j=0; j<=n; ++j)
+    for(UInt i=0; i<=n; ++i)
+      {
+	mesh.nodes[i+(n+1)*j] = Real(i)/n;
+	mesh.nodes[i+(n+1)*j+mesh.num_nodes] = Real(j)/n;
+      }
+
+  const UInt ne = mesh.num_elements;
+  mesh.elements.resize(3*ne);
+  UInt e = 0;
+  for(UInt j=0; j<n; ++j)
+    for(UInt i=0; i<n; ++i)
+      {
+	const UInt v00 = i+(n+1)*j, v10 = v00+1, v01 = v00+n+1, v11 = v01+1;
+	// Counterclockwise, as the triangulations built by R
+	const UInt triangles[2][3] = {{v00, v10, v11}, {v00, v11, v01}};
+	for(const auto & t : triangles)
+	  {
+	    for(UInt k=0; k<3; ++k)
+	      mesh.elements[e+ne*k] = t[k];
+	    ++e;
+	  }
+      }
+
+  build_connectivity(mesh);
+  return mesh;
+}
+
+SyntheticMesh build_surface_mesh(UInt n)
+{
+  SyntheticMesh square = build_square_mesh(n);
+
+  SyntheticMesh mesh = square;
+  mesh.domain = "2.5D";
+  mesh.ndim = 3;
+  mesh.nodes.resize(3*mesh.num_nodes);
+  for(UInt i=0; i<mesh.num_nodes; ++i)
+    {
+      const Real x = square.nodes[i], y = square.nodes[i+mesh.num_nodes];
+      mesh.nodes[i+2*mesh.num_nodes] = std::sin(M_PI*x)*std::sin(M_PI*y)/4;
+    }
+  return mesh;
+}
+
+SyntheticMesh build_cube_mesh(UInt n)
+{
+  SyntheticMesh mesh;
+  mesh.domain = "3D";
+  mesh.mydim = 3;
+  mesh.ndim = 3;
+  mesh.num_nodes = (n+1)*(n+1)*(n+1);
+  mesh.num_elements = 6*n*n*n;
+
+  auto node_id = [n](UInt i, UInt j, UInt k) {return i+(n+1)*(j+(n+1)*k);};
+
+  mesh.nodes.resize(3*mesh.num_nodes);
+  for(UInt k=0; k<=n; ++k)
+    for(UInt j=0; j<=n; ++j)
+      for(UInt i=0; i<=n; ++i)
+	{
+	  const UInt id = node_id(i, j, k);
+	  mesh.nodes[id] = Real(i)/n;
+	  mesh.nodes[id+mesh.num_nodes] = Real(j)/n;
+	  mesh.nodes[id+2*mesh.num_nodes] = Real(k)/n;
+	}
+
+  // Each tetrahedron goes from the lowest to the highest corner of the cell moving along the axes in one of the 6 orders
+  const UInt orders[6][3] = {{0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0}};
+  const UInt ne = mesh.num_elements;
+  mesh.elements.resize(4*ne);
+  UInt e = 0;
+  for(UInt k=0; k<n; ++k)
+    for(UInt j=0; j<n; ++j)
+      for(UInt i=0; i<n; ++i)
+	for(const auto & order : orders)
+	  {
+	    UInt corner[3] = {i, j, k};
+	    mesh.elements[e] = node_id(corner[0], corner[1], corner[2]);
+	    for(UInt v=0; v<3; ++v)
+	      {
+		++corner[order[v]];
+		mesh.elements[e+ne*(v+1)] = node_id(corner[0], corner[1], corner[2]);
+	      }
+	    ++e;
+	  }
+
+  build_connectivity(mesh);
+  return mesh;
+}
+
+SyntheticMesh build_mesh(const std::string & domain, UInt n)
+{
+  if(domain == "2.5D")
+    return build_surface_mesh(n);
+  else if(domain == "3D")
+    return build_cube_mesh(n);
+  return build_square_mesh(n);
+}
+
+std::vector<Real> sample_points(const SyntheticMesh & mesh, UInt num_points, UInt seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<UInt> element_distribution(0, mesh.num_elements-1);
+  std::exponential_distribution<Real> weight_distribution(1.);
+
+  const UInt nvertices = mesh.mydim+1;
+  std::vector<Real> points(num_points*mesh.ndim, 0.);
+  std::vector<Real> weights(nvertices);
+  for(UInt i=0; i<num_points; ++i)
+    {
+      // Uniform barycentric coordinates: normalized exponential weights
+      const UInt e = element_distribution(generator);
+      Real total = 0.;
+      for(Real & w : weights)
+	total += (w = weight_distribution(generator));
+
+      for(UInt v=0; v<nvertices; ++v)
+	{
+	  const UInt node = mesh.elements[e+mesh.num_elements*v];
+	  for(UInt d=0; d<mesh.ndim; ++d)
+	    points[i+num_points*d] += weights[v]/total*mesh.nodes[node+mesh.num_nodes*d];
+	}
+    }
+  return points;
+}
+
+long peak_rss_kb(void)
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while(std::getline(status, line))
+    {
+      if(line.compare(0, 6, "VmHWM:") == 0)
+	return std::stol(line.substr(6));
+    }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __MACH__
+  return usage.ru_maxrss/1024;	// bytes on OS X
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+void reset_peak_rss(void)
+{
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if(clear_refs)
+    clear_refs << "5";
+}
+
+BenchReport::BenchReport(std::ostream & out): out_(out)
+{
+  out_ << "scenario,domain,nodes,elements,n_data,rep,seconds,peak_rss_kb,checksum" << std::endl;
+}
+
+void BenchReport::start(void)
+{
+  reset_peak_rss();
+  timer_.start();
+}
+
+void BenchReport::stop(const std::string & scenario, UInt n_data, UInt rep, Real checksum)
+{
+  const timespec elapsed = timer_.stop();
+  const Real seconds = elapsed.tv_sec + elapsed.tv_nsec*1e-9;
+  out_ << scenario << ',' << domain_ << ',' << num_nodes_ << ',' << num_elements_ << ',' << n_data << ',' << rep << ','
+       << std::fixed << std::setprecision(6) << seconds << ',' << peak_rss_kb() << ','
+       << std::scientific << std::setprecision(10) << checksum << std::defaultfloat << std::endl;
+}
@@ -7,6 +7,8 @@
 #include <tuple>
 #include <utility>
 #include <numeric>
+#include <algorithm>
+#include <array>
 //#include <omp.h>
 #include "../../FdaPDE.h"
 #include "DE_Data.h"
@@ -27,28 +29,64 @@ protected:
     static constexpr UInt EL_NNODES = how_many_nodes(ORDER,mydim);
     DEData<ndim> deData_;
     MeshHandler<ORDER, mydim, ndim> mesh_;
-    SpMat R0_, R1_, GlobalPsi_;
-    MatrixXr P_;
+    SpMat R0_, R1_;
+    // Factorization of the mass matrix: the penalty matrix P = R1^T R0^-1 R1 is dense, hence it is only applied as an operator.
+    Eigen::SparseLU<SpMat> R0dec_;
     Eigen::Matrix<Real, Integrator::NNODES, EL_NNODES> PsiQuad_;
+    // Contiguous copy of the connectivity: the ids of the nodes of element e are elementNodes_[e*EL_NNODES+i], its measure is elementMeasures_[e].
+    std::vector<UInt> elementNodes_;
+    VectorXr elementMeasures_;
+    // Number of elements whose quadrature is evaluated together in the integration kernels.
+    static constexpr UInt EL_BATCH = 64;
+    // Data aggregated by location: the datum i lies at the location dataLocation_[i]; the location l lies in the element
+    // locationElements_[l] (NVAL if outside the domain), where the basis functions take the values locationBasis_[l*EL_NNODES+j],
+    // and it is shared by locationWeights_[l] data.
+    std::vector<UInt> dataLocation_, locationElements_;
+    std::vector<Real> locationBasis_;
+    VectorXr locationWeights_;
+    // Matrix which evaluates the basis functions at the distinct locations and its weighted column sums, i.e. Psi^T*1 for all the data.
+    SpMat LocationPsi_;
+    VectorXr dataPsiSum_;
 
     //! A method to compute the finite element matrices.
     void fillFEMatrices();
+    //! A method to copy the connectivity and the measures of the elements into contiguous arrays.
+    void fillConnectivity();
     //! A method to compute the matrix which evaluates the basis function at the quadrature EL_NNODES.
     void fillPsiQuad();
+    //! A method to project and clean the data and to fill the matrices of the problem (common part of the constructors).
+    void initialize(bool isTime);
+    //! A method to merge the data with identical coordinates and to locate each distinct location in the mesh once. If removeOutside
+    //! is true, the data which are not in the domain are removed.
+    void locateData(bool removeOutside);
+    //! A method to remove the located data whose flag in keep is false, together with the locations left without data:
+    //! the remaining data are not located again.
+    void removeData(const std::vector<bool>& keep);
+    //! A method to compute the weights of the distinct locations, the matrix which evaluates the basis functions there and its weighted column sums.
+    void fillLocationPsi();
+    //! A method to compute the matrix which evaluates the basis functions at the distinct locations in the positions stored in locations.
+    SpMat gatherPsi(const std::vector<UInt>& locations) const;
 
 public:
     //! A constructor: it delegates DEData and MeshHandler constructors.
     DataProblem(SEXP Rdata, SEXP Rorder, SEXP Rscaling, SEXP Rfvec, SEXP RheatStep, SEXP RheatIter, SEXP Rlambda, SEXP Rnfolds,
                 SEXP Rnsim, SEXP RstepProposals, SEXP Rtol1, SEXP Rtol2, SEXP Rprint, SEXP Rsearch, SEXP Rmesh, SEXP Rinference,
                 bool isTime = 0);
+    //! A constructor for the use outside R: it takes the data already stored and the arrays of the mesh (see MeshHandler).
+    DataProblem(const DEData<ndim>& deData, Real* const points, UInt num_nodes, UInt* const sides, UInt num_sides,
+                UInt* const elements, UInt num_elements, UInt* const neighbors, bool isTime = 0);
 
     //! A method to compute the integral of a function (over the spatial domain).
     Real FEintegrate(const VectorXr& f) const {return (R0_*f).sum();}
     //! A method to compute the integral of the square of a function (over the spatial domain).
     Real FEintegrate_square(const VectorXr& f) const {return f.dot(R0_*f);}
     //! A method to compute the integral of the exponential of a function (over the spatial domain).
-    Real FEintegrate_exponential(const VectorXr& g) const;
-    //! A method to compute the matrix which evaluates the basis function at the data points.
+    Real FEintegrate_exponential(const VectorXr& g) const {return FEintegrate_exponential(g, nullptr);}
+    //! A method to compute, in a single pass over the elements, the integral of exp(g), its gradient with respect to the coefficients of g
+    //! (if grad is not null) and the product of its Hessian with v (if v and Hv are not null).
+    Real FEintegrate_exponential(const VectorXr& g, VectorXr* grad, const VectorXr* v = nullptr, VectorXr* Hv = nullptr) const;
+    //! A method to compute the matrix which evaluates the basis function at the data points in the positions stored in indices.
+    //! The rows are gathered from the located data, without searching the mesh again.
     SpMat computePsi(const std::vector<UInt>& indices) const;
 
     // Getters
@@ -104,20 +142,30 @@ public:
     Point<ndim> getPoint(Id id) const {return mesh_.getPoint(id);}
     //! A method returning an element. It calls the same method of MeshHandler class.
     Element<EL_NNODES,mydim,ndim> getElement(Id id) const {return mesh_.getElement(id);}
+    //! A method returning a pointer to the EL_NNODES ids of the nodes of an element, stored contiguously.
+    const UInt* getElementNodes(UInt id) const {return &elementNodes_[id*EL_NNODES];}
+    //! A method returning the measure of an element.
+    Real getElementMeasure(UInt id) const {return elementMeasures_[id];}
+    //! A method returning the id of the element in which the i-th datum is located (as found once by locateData).
+    UInt getDataElement(UInt i) const {return locationElements_[dataLocation_[i]];}
     //! A method returning the element in which the point in input is located. It calls the same method of MeshHandler class.
     Element<EL_NNODES,mydim,ndim> findLocation(const Point<ndim>& point) const {return mesh_.findLocation(point);}
 
     // Getters for matrices
-    //! A method returning the penalty matrix.
-    MatrixXr getP() const {return P_;}
+    //! A method to apply the penalty matrix P = R1^T R0^-1 R1 to a vector, in O(nnz) operations without assembling P.
+    VectorXr applyP(const VectorXr& g) const {return R1_.transpose()*R0dec_.solve(R1_*g);}
     //! A method returning the mass matrix.
     SpMat getMass() const {return R0_;}
     //! A method returning the stiffness matrix.
     SpMat getStiffness() const {return R1_;}
     //! A method returning the PsiQuad_ matrix.
     const Eigen::Matrix<Real, Integrator::NNODES, EL_NNODES>& getPsiQuad() const {return PsiQuad_;}
-    //! A method returning the GlobalPsi_ matrix.
-    const SpMat& getGlobalPsi() const {return GlobalPsi_;}
+    //! A method returning the matrix which evaluates the basis functions at the distinct data locations.
+    const SpMat& getLocationPsi() const {return LocationPsi_;}
+    //! A method returning the number of data at each distinct location.
+    const VectorXr& getLocationWeights() const {return locationWeights_;}
+    //! A method returning the sum of the evaluations of the basis functions at all the data, Psi^T*1.
+    const VectorXr& getDataPsiSum() const {return dataPsiSum_;}
 };
 
 
@@ -140,10 +188,13 @@ private:
     std::vector<Real> mesh_time_;
     // Matrix containing evaluations of the spline basis functions at different time instants; time mass matrix.
     SpMat GlobalPhi_, K0_;
+    // For each time interval, the matrix which evaluates the SPLINE_DEGREE+1 B-splines active there at its quadrature nodes.
+    std::vector<MatrixXr> PhiQuad_;
     // Time and space penalty matrices.
     SpMat Pt_, Ps_;
-    // Matrix obtained by computing the Kronecker product of GlobalPhi_ and GlobalPsi_ matrices.
-    SpMat Upsilon_;
+    // Matrix which evaluates the space-time basis functions at the data: its row i is the Kronecker product of the rows of
+    // GlobalPhi_ and of the spatial Psi matrix relative to the i-th datum. It is stored by rows only, to gather the rows of a subset.
+    Eigen::SparseMatrix<Real, Eigen::RowMajor> Upsilon_;
     // Data structure used during the initialization procedure via discretized heat diffusion process.
     std::vector<std::vector<UInt>> data_Heat_;
     // Flags related to penalty matrices.
@@ -151,6 +202,8 @@ private:
 
     //! A method to compute the matrix which evaluates the temporal basis functions at the time instants.
     void fillGlobalPhi();
+    //! A method to compute the PhiQuad_ matrices of all the time intervals.
+    void fillPhiQuads();
     //! A method to compute the time mass matrix.
     void fillTimeMass();
     //! A method to compute the time penalty matrix.
@@ -163,6 +216,11 @@ private:
     void fillPenaltyTime();
     //! A method to generate the data structure used during the initialization procedure via discretized heat diffusion process.
     void setDataHeat();
+    //! A method to clean the data in space and time and to fill the matrices of the problem (common part of the constructors).
+    void initializeTime(bool isTimeDiscrete);
+    //! A method to compute the Upsilon_ matrix, written row by row from the nonzero entries of the spatial basis functions at the
+    //! location of each datum (see locateData) and of the B-splines at its time.
+    void fillUpsilon();
 
 public:
     //! A constructor: it delegates DataProblem, DEData_time and Spline constructors.
@@ -170,6 +228,10 @@ public:
                      SEXP Rlambda_time, SEXP Rnfolds, SEXP Rnsim, SEXP RstepProposals, SEXP Rtol1, SEXP Rtol2, SEXP Rprint,
                      SEXP Rsearch, SEXP Rmesh, const std::vector<Real>& mesh_time, SEXP RisTimeDiscrete,
                      SEXP RflagMass, SEXP RflagLumped, SEXP Rinference, bool isTime = 1);
+    //! A constructor for the use outside R: it takes the data already stored, the arrays of the mesh (see MeshHandler) and the time mesh.
+    DataProblem_time(const DEData<ndim>& deData, const DEData_time& deData_time, Real* const points, UInt num_nodes, UInt* const sides,
+                     UInt num_sides, UInt* const elements, UInt num_elements, UInt* const neighbors, const std::vector<Real>& mesh_time,
+                     bool isTimeDiscrete, bool flagMass, bool flagLumped, bool isTime = 1);
 
     //! A method to compute the integral of a function (over the temporal domain).
     Real FEintegrate_time(const VectorXr& f) const {return (kroneckerProduct(getTimeMass(), this->getMass())*f).sum();}
@@ -177,13 +239,13 @@ public:
     //! A method to compute the matrix which evaluates the temporal basis functions at a given time_node (for the
     //! discretization of the integral of the exponential).
     MatrixXr fillPhiQuad(UInt time_node) const;
+    //! A method to compute, in a single pass over the elements, the integral of exp(g) over the space-time domain and its gradient
+    //! with respect to the coefficients of g (if grad is not null).
+    Real FEintegrate_exponential_time(const VectorXr& g, VectorXr* grad) const;
 
-    //! A method to compute the Upsilon_ matrix as the Kronecker product between GlobalPhi_ and GlobalPsi_.
-    //! In discrete time settings, this method builds Upsilon_indices_ for the efficient extraction of Upsilon_ rows
-    //! (for CV preprocessing).
-    SpMat computeUpsilon(const SpMat& phi, const SpMat& psi) const;
     //! A method to compute the Upsilon_ matrix by considering only locations and times in the positions stored in
-    //! indices. This method is needed for CV preprocessing (only points that are in the considered fold are used).
+    //! indices. This method is needed for CV preprocessing (only points that are in the considered fold are used):
+    //! the rows are copied from Upsilon_.
     SpMat computeUpsilon(const std::vector<UInt>& indices) const;
 
     //! A method returning the matrix needed for the penalizing term in space.
@@ -212,10 +274,12 @@ public:
     SpMat getPt() const {return Pt_;}
     //! A method returning the matrix containing the evaluations of the spline basis functions.
     const SpMat& getGlobalPhi() const {return GlobalPhi_;}
-    //! A method returning the Upsilon_ matrix.
-    const SpMat& getUpsilon() const {return Upsilon_;}
+    //! A method returning the Upsilon_ matrix, stored by rows (the callers needing it by columns convert it).
+    const Eigen::SparseMatrix<Real, Eigen::RowMajor>& getUpsilon() const {return Upsilon_;}
     //! A method returning the time mass matrix.
     SpMat getTimeMass() const {return K0_;}
+    //! A method returning the matrix which evaluates the B-splines active in a time interval at its quadrature nodes.
+    const MatrixXr& getPhiQuad(UInt time_node) const {return PhiQuad_[time_node];}
 
     // Getters for time mesh
     //! A method returning the time mesh.
@@ -8,6 +8,22 @@ DataProblem<ORDER, mydim, ndim>::DataProblem(SEXP Rdata, SEXP Rorder, SEXP Rscal
   deData_(Rdata, Rorder, Rscaling, Rfvec, RheatStep, RheatIter, Rlambda, Rnfolds, Rnsim, RstepProposals, Rtol1, Rtol2, Rprint, Rsearch, Rinference),
   mesh_(Rmesh, INTEGER(Rsearch)[0]){
 
+    initialize(isTime);
+}
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+DataProblem<ORDER, mydim, ndim>::DataProblem(const DEData<ndim>& deData, Real* const points, UInt num_nodes, UInt* const sides,
+                                             UInt num_sides, UInt* const elements, UInt num_elements, UInt* const neighbors,
+                                             bool isTime):
+  deData_(deData), mesh_(points, num_nodes, sides, num_sides, elements, num_elements, neighbors, deData_.getSearch()){
+
+    initialize(isTime);
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+void DataProblem<ORDER, mydim, ndim>::initialize(bool isTime){
+
     std::vector<Point<ndim>>& data = deData_.data();
 
     // PROJECTION
@@ -17,30 +33,120 @@ DataProblem<ORDER, mydim, ndim>::DataProblem(SEXP Rdata, SEXP Rorder, SEXP Rscal
       data = projection.computeProjection();
     }
     
-    // REMOVE POINTS NOT IN THE DOMAIN
-    if(!isTime) {
-        for(auto it = data.begin(); it != data.end(); ){
-            Element<EL_NNODES, mydim, ndim> tri_activated = mesh_.findLocation(data[it - data.begin()]);
-            if(tri_activated.getId() == Identifier::NVAL)
-            {
-                it = data.erase(it);
-                Rprintf("WARNING: an observation is not in the domain. It is removed and the algorithm proceeds.\n");
-            }
-            else {
-                ++it;
-            }
-        }
-    }
-
     // FILL SPACE MATRICES
     fillFEMatrices();
     fillPsiQuad();
+    fillConnectivity();
+
+    // LOCATE THE DATA AND REMOVE POINTS NOT IN THE DOMAIN
+    // (in the space-time case the data are cleaned also in time, hence they are located by DataProblem_time)
+    if(!isTime)
+        locateData(true);
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+void DataProblem<ORDER, mydim, ndim>::locateData(bool removeOutside){
+
+    std::vector<Point<ndim>>& data = deData_.data();
+    const UInt n = data.size();
+
+    // sort the data by coordinates (and then by index), so that the repeated coordinates are adjacent
+    std::vector<UInt> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&data](UInt i, UInt j){
+        return data[i].coord() < data[j].coord() || (data[i].coord() == data[j].coord() && i < j);});
+
+    // number the distinct locations in the order of their first occurrence among the data
+    std::vector<UInt> first(n);
+    for(UInt k = 0; k < n; ++k)
+        first[order[k]] = (k > 0 && data[order[k]].coord() == data[order[k-1]].coord()) ? first[order[k-1]] : order[k];
+
+    dataLocation_.resize(n);
+    std::vector<UInt> representative;
+    for(UInt i = 0; i < n; ++i){
+        if(first[i] == i){
+            dataLocation_[i] = representative.size();
+            representative.push_back(i);
+        }
+        else
+            dataLocation_[i] = dataLocation_[first[i]];
+    }
+
+    // locate each distinct location once and evaluate the basis functions there
+    const UInt nlocations = representative.size();
+    locationElements_.resize(nlocations);
+    locationBasis_.resize(nlocations*EL_NNODES);
+
+    for(UInt l = 0; l < nlocations; ++l){
+        const Point<ndim>& point = data[representative[l]];
+        Element<EL_NNODES, mydim, ndim> tri_activated = mesh_.findLocation(point);
+        locationElements_[l] = tri_activated.getId();
+        if(tri_activated.getId() != Identifier::NVAL){
+            for(UInt node = 0; node < EL_NNODES; ++node)
+                locationBasis_[l*EL_NNODES+node] = tri_activated.evaluate_point(point, Eigen::Matrix<Real,EL_NNODES,1>::Unit(node));
+        }
+    }
+
+    // remove the data which are not in the domain, together with their locations
+    if(removeOutside){
+        std::vector<bool> keep(n);
+        for(UInt i = 0; i < n; ++i)
+            keep[i] = locationElements_[dataLocation_[i]] != Identifier::NVAL;
+        removeData(keep);
+    }
+    else
+        fillLocationPsi();
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+void DataProblem<ORDER, mydim, ndim>::removeData(const std::vector<bool>& keep){
 
-    if(!isTime) {
-        std::vector <UInt> v(deData_.dataSize());
-        std::iota(v.begin(), v.end(), 0);
-        GlobalPsi_ = computePsi(v);
+    std::vector<Point<ndim>>& data = deData_.data();
+    const UInt n = data.size();
+
+    // the kept locations are numbered in the order of their first occurrence among the kept data, as locateData would do
+    std::vector<UInt> newLocation(locationElements_.size(), Identifier::NVAL);
+    std::vector<UInt> keptElements;
+    std::vector<Real> keptBasis;
+    UInt ndata = 0;
+    for(UInt i = 0; i < n; ++i){
+        if(!keep[i]){
+            Rprintf("WARNING: an observation is not in the domain. It is removed and the algorithm proceeds.\n");
+            continue;
+        }
+        const UInt l = dataLocation_[i];
+        if(newLocation[l] == Identifier::NVAL){
+            newLocation[l] = keptElements.size();
+            keptElements.push_back(locationElements_[l]);
+            keptBasis.insert(keptBasis.end(), locationBasis_.begin()+l*EL_NNODES, locationBasis_.begin()+(l+1)*EL_NNODES);
+        }
+        data[ndata] = data[i];
+        dataLocation_[ndata] = newLocation[l];
+        ++ndata;
     }
+    data.resize(ndata);
+    dataLocation_.resize(ndata);
+    locationElements_ = std::move(keptElements);
+    locationBasis_ = std::move(keptBasis);
+
+    fillLocationPsi();
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+void DataProblem<ORDER, mydim, ndim>::fillLocationPsi(){
+
+    // weighted matrix of the distinct locations
+    locationWeights_ = VectorXr::Zero(locationElements_.size());
+    for(UInt l : dataLocation_)
+        locationWeights_[l] += 1;
+
+    std::vector<UInt> locations(locationElements_.size());
+    std::iota(locations.begin(), locations.end(), 0);
+    LocationPsi_ = gatherPsi(locations);
+    dataPsiSum_ = LocationPsi_.transpose()*locationWeights_;
 }
 
 
@@ -54,11 +160,8 @@ void DataProblem<ORDER, mydim, ndim>::fillFEMatrices(){
   Assembler::operKernel(mass, mesh_, fe, R0_);
   Assembler::operKernel(stiff, mesh_, fe, R1_);
 
-  //fill P
-  Eigen::SparseLU<SpMat> solver;
-	solver.compute(R0_);
-	auto X2 = solver.solve(R1_);
-	P_ = R1_.transpose()* X2;
+  //factorize R0, needed to apply P
+  R0dec_.compute(R0_);
 }
 
 
@@ -70,27 +173,93 @@ void DataProblem<ORDER, mydim, ndim>::fillPsiQuad(){
 
 
 template<UInt ORDER, UInt mydim, UInt ndim>
-Real DataProblem<ORDER, mydim, ndim>::FEintegrate_exponential(const VectorXr& g) const{
+void DataProblem<ORDER, mydim, ndim>::fillConnectivity(){
+  const UInt n_el = mesh_.num_elements();
+  elementNodes_.resize(n_el*EL_NNODES);
+  elementMeasures_.resize(n_el);
+
+  for(UInt e=0; e<n_el; ++e){
+    Element<EL_NNODES, mydim, ndim> tri_activated = mesh_.getElement(e);
+    for(UInt i=0; i<EL_NNODES; ++i)
+      elementNodes_[e*EL_NNODES+i] = tri_activated[i].getId();
+    elementMeasures_[e] = tri_activated.getMeasure();
+  }
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+Real DataProblem<ORDER, mydim, ndim>::FEintegrate_exponential(const VectorXr& g, VectorXr* grad, const VectorXr* v, VectorXr* Hv) const{
 
   using EigenMap2WEIGHTS = Eigen::Map<const Eigen::Matrix<Real, Integrator::NNODES, 1> >;
+  using QuadMatrix = Eigen::Matrix<Real, Integrator::NNODES, Eigen::Dynamic>;
+  using NodeMatrix = Eigen::Matrix<Real, EL_NNODES, Eigen::Dynamic>;
+
+  const UInt n_el = mesh_.num_elements();
+  const bool with_grad = grad != nullptr;
+  const bool with_Hv = v != nullptr && Hv != nullptr;
 
-  Real total_sum = 0.;
+  // The contributions of the elements are computed in parallel, a batch of EL_BATCH elements at a time (so that the exponential
+  // is evaluated on a whole matrix of quadrature nodes), and summed afterwards in the order of the elements: the result is
+  // deterministic, independent of the thread count.
+  VectorXr el_int(n_el);
+  MatrixXr el_grad(EL_NNODES, with_grad ? n_el : 0);
+  MatrixXr el_Hv(EL_NNODES, with_Hv ? n_el : 0);
 
-  for(UInt triangle=0; triangle<mesh_.num_elements(); ++triangle){
+  const long int n_batches = (n_el + EL_BATCH - 1)/EL_BATCH;
 
-    Element<EL_NNODES, mydim, ndim> tri_activated = mesh_.getElement(triangle);
+  #pragma omp parallel for schedule(static)
+  for(long int b=0; b<n_batches; ++b){
+    const UInt first = b*EL_BATCH;
+    const UInt n_cur = std::min(EL_BATCH, n_el-first);
 
 // (3) -------------------------------------------------
-    Eigen::Matrix<Real,EL_NNODES,1> sub_g;
-    for (UInt i=0; i<EL_NNODES; i++){
-      sub_g[i]=g[tri_activated[i].getId()];
+    NodeMatrix sub_g(EL_NNODES, n_cur);
+    for(UInt e=0; e<n_cur; ++e){
+      const UInt* nodes = getElementNodes(first+e);
+      for(UInt i=0; i<EL_NNODES; ++i)
+        sub_g(i,e) = g[nodes[i]];
     }
 
 // (4) -------------------------------------------------
-    Eigen::Matrix<Real,Integrator::NNODES,1> expg = (PsiQuad_*sub_g).array().exp();
+    // weighted exp(g) at the quadrature nodes of each element of the batch
+    QuadMatrix wexpg = EigenMap2WEIGHTS(&Integrator::WEIGHTS[0]).asDiagonal() * QuadMatrix((PsiQuad_*sub_g).array().exp());
+    const auto measures = elementMeasures_.segment(first, n_cur);
+
+    el_int.segment(first, n_cur) = wexpg.colwise().sum().transpose().cwiseProduct(measures);
+
+    if(with_grad)
+      el_grad.middleCols(first, n_cur) = (PsiQuad_.transpose()*wexpg)*measures.asDiagonal();
+
+    if(with_Hv){
+      NodeMatrix sub_v(EL_NNODES, n_cur);
+      for(UInt e=0; e<n_cur; ++e){
+        const UInt* nodes = getElementNodes(first+e);
+        for(UInt i=0; i<EL_NNODES; ++i)
+          sub_v(i,e) = (*v)[nodes[i]];
+      }
+      el_Hv.middleCols(first, n_cur) = (PsiQuad_.transpose()*wexpg.cwiseProduct(PsiQuad_*sub_v))*measures.asDiagonal();
+    }
+  }
 
-    total_sum+=expg.dot(EigenMap2WEIGHTS(&Integrator::WEIGHTS[0]))*tri_activated.getMeasure();
+  // deterministic reduction
+  Real total_sum = el_int.sum();
 
+  if(with_grad){
+    *grad = VectorXr::Zero(mesh_.num_nodes());
+    for(UInt e=0; e<n_el; ++e){
+      const UInt* nodes = getElementNodes(e);
+      for(UInt i=0; i<EL_NNODES; ++i)
+        (*grad)[nodes[i]] += el_grad(i,e);
+    }
+  }
+
+  if(with_Hv){
+    *Hv = VectorXr::Zero(mesh_.num_nodes());
+    for(UInt e=0; e<n_el; ++e){
+      const UInt* nodes = getElementNodes(e);
+      for(UInt i=0; i<EL_NNODES; ++i)
+        (*Hv)[nodes[i]] += el_Hv(i,e);
+    }
   }
 
   return total_sum;
@@ -101,31 +270,40 @@ template<UInt ORDER, UInt mydim, UInt ndim>
 SpMat
 DataProblem<ORDER, mydim, ndim>::computePsi(const std::vector<UInt>& indices) const{
 
+    std::vector<UInt> locations(indices.size());
+    for(std::size_t i = 0; i < indices.size(); ++i)
+        locations[i] = dataLocation_[indices[i]];
+
+    return gatherPsi(locations);
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+SpMat
+DataProblem<ORDER, mydim, ndim>::gatherPsi(const std::vector<UInt>& locations) const{
+
     static constexpr Real eps = std::numeric_limits<Real>::epsilon(), tolerance = 100 * eps;
 
     UInt nnodes = mesh_.num_nodes();
-    UInt nlocations = indices.size();
+    UInt nlocations = locations.size();
 	SpMat psi(nlocations, nnodes);
 
 	std::vector<coeff> triplets;
 	triplets.reserve(EL_NNODES*nlocations);
 
-	for(auto it = indices.cbegin(); it != indices.cend(); ++it)
+	for(UInt i = 0; i < nlocations; ++i)
 	{
-        Element<EL_NNODES, mydim, ndim> tri_activated = mesh_.findLocation(deData_.data(*it));
+        const UInt l = locations[i];
 
-		if(tri_activated.getId() == Identifier::NVAL)
+		if(locationElements_[l] == Identifier::NVAL)
 		{
 			Rprintf("WARNING: the following observation is not in the domain\n");
-            //operator<<(std::cout, deData_.data(*it));
 		}
         else
         {
+            const UInt* nodes = getElementNodes(locationElements_[l]);
 			for(UInt node = 0; node < EL_NNODES ; ++node)
-			{
-				Real evaluator = tri_activated.evaluate_point(deData_.data(*it), Eigen::Matrix<Real,EL_NNODES,1>::Unit(node));
-				triplets.emplace_back(it-indices.cbegin(), tri_activated[node].getId(), evaluator);
-			}
+				triplets.emplace_back(i, nodes[node], locationBasis_[l*EL_NNODES+node]);
 		}
 	}
 
@@ -154,32 +332,48 @@ DataProblem_time<ORDER, mydim, ndim>::DataProblem_time(SEXP Rdata, SEXP Rdata_ti
     flagMass_ = INTEGER(RflagMass)[0];
     flagLumped_ = INTEGER(RflagLumped)[0];
 
+    initializeTime(static_cast<bool> (INTEGER(RisTimeDiscrete)[0]));
+}
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+DataProblem_time<ORDER, mydim, ndim>::DataProblem_time(const DEData<ndim>& deData, const DEData_time& deData_time, Real* const points,
+                                                       UInt num_nodes, UInt* const sides, UInt num_sides, UInt* const elements,
+                                                       UInt num_elements, UInt* const neighbors, const std::vector<Real>& mesh_time,
+                                                       bool isTimeDiscrete, bool flagMass, bool flagLumped, bool isTime):
+  DataProblem<ORDER, mydim, ndim>(deData, points, num_nodes, sides, num_sides, elements, num_elements, neighbors, isTime),
+  deData_time_(deData_time), spline_(mesh_time), mesh_time_(mesh_time), flagMass_(flagMass), flagLumped_(flagLumped){
+
+    initializeTime(isTimeDiscrete);
+}
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+void DataProblem_time<ORDER, mydim, ndim>::initializeTime(bool isTimeDiscrete){
+
     std::vector<Point<ndim>>& data_ = this->deData_.data();
     std::vector<Real>& data_time_ = deData_time_.data();
     const Real t_min = mesh_time_.front();
     const Real t_max = mesh_time_.back();
 
-    // REMOVE POINTS NOT IN THE DOMAIN
-    for (auto it = data_.begin(); it != data_.end();) {
-        Element<DataProblem<ORDER, mydim, ndim>::EL_NNODES, mydim, ndim> tri_activated = this->mesh_.findLocation(data_[it - data_.begin()]);
-        if (tri_activated.getId() == Identifier::NVAL || (data_time_[it - data_.begin()] < t_min || data_time_[it - data_.begin()] > t_max)) {
-            data_time_.erase(data_time_.begin() + (it - data_.begin()));
-            it = data_.erase(it);
-            Rprintf("WARNING: an observation is not in the domain. It is removed and the algorithm proceeds.\n");
-        } else {
-            ++it;
-        }
+    // LOCATE THE DATA AND REMOVE POINTS NOT IN THE DOMAIN
+    // (the located data are compacted with the same mask as the times, they are not located again)
+    this->locateData(false);
+    std::vector<bool> keep(data_.size());
+    std::size_t ndata = 0;
+    for (std::size_t i = 0; i < data_.size(); ++i) {
+        keep[i] = this->getDataElement(i) != Identifier::NVAL && data_time_[i] >= t_min && data_time_[i] <= t_max;
+        if (keep[i])
+            data_time_[ndata++] = data_time_[i];
     }
 
-    Rprintf("WARNING: %zu observations used in the algorithm.\n", data_.size());
+    if (ndata < data_.size()) {
+        data_time_.resize(ndata);
+        this->removeData(keep);
+    }
 
-    // FILL SPACE MATRIX
-    std::vector <UInt> v(this->deData_.dataSize());
-    std::iota(v.begin(), v.end(), 0);
-    this->GlobalPsi_ = this->computePsi(v);
+    Rprintf("WARNING: %zu observations used in the algorithm.\n", data_.size());
 
     // DISCRETE TIME DATA
-    if(static_cast<bool> (INTEGER(RisTimeDiscrete)[0])) {
+    if(isTimeDiscrete) {
         deData_time_.setTimes2Locations();
         //deData_time_.printTimes2Locations(std::cout);
     }
@@ -190,6 +384,7 @@ DataProblem_time<ORDER, mydim, ndim>::DataProblem_time(SEXP Rdata, SEXP Rdata_ti
 
     // FILL TIME MATRICES
     fillGlobalPhi();
+    fillPhiQuads();
     fillTimeMass();
     fillTimeSecondDerivative();
 
@@ -198,7 +393,7 @@ DataProblem_time<ORDER, mydim, ndim>::DataProblem_time(SEXP Rdata, SEXP Rdata_ti
     fillPenaltyTime();
 
     // ASSEMBLE SPACE-TIME MATRICES
-    Upsilon_ = computeUpsilon(GlobalPhi_, this->GlobalPsi_);
+    fillUpsilon();
 }
 
 template<UInt ORDER, UInt mydim, UInt ndim>
@@ -238,6 +433,14 @@ void DataProblem_time<ORDER, mydim, ndim>::fillTimeSecondDerivative(void)
     Assembler::operKernel(spline_, Pt_);
 }
 
+template<UInt ORDER, UInt mydim, UInt ndim>
+void DataProblem_time<ORDER, mydim, ndim>::fillPhiQuads()
+{
+    PhiQuad_.resize(getNumNodes_time()-1);
+    for(std::size_t time_node = 0; time_node < PhiQuad_.size(); ++time_node)
+        PhiQuad_[time_node] = fillPhiQuad(time_node);
+}
+
 template<UInt ORDER, UInt mydim, UInt ndim>
 SpMat DataProblem_time<ORDER, mydim, ndim>::makeLumped(const SpMat& mass) const
 {
@@ -319,66 +522,140 @@ MatrixXr DataProblem_time<ORDER, mydim, ndim>::fillPhiQuad(UInt time_node) const
 
 
 template<UInt ORDER, UInt mydim, UInt ndim>
-SpMat DataProblem_time<ORDER, mydim, ndim>::computeUpsilon(const SpMat& phi, const SpMat& psi) const
+Real DataProblem_time<ORDER, mydim, ndim>::FEintegrate_exponential_time(const VectorXr& g, VectorXr* grad) const
+{
+    static constexpr UInt EL_NNODES = DataProblem<ORDER, mydim, ndim>::EL_NNODES;
+    using EigenMap2WEIGHTS = Eigen::Map<const Eigen::Matrix<Real, Integrator::NNODES, 1> >;
+    using EigenMap2WEIGHTS_t = Eigen::Map<const Eigen::Matrix<Real, Integrator_t::NNODES, 1> >;
+    using QuadMatrix = Eigen::Matrix<Real, Integrator::NNODES, Integrator_t::NNODES>;
+
+    const UInt N = this->getNumNodes();
+    const UInt M = getSplineNumber();
+    const UInt n_el = this->getNumElements();
+    const UInt n_int = getNumNodes_time()-1;
+    const bool with_grad = grad != nullptr;
+
+    // Each element is processed for all the time intervals at once: the values of g at the spatial quadrature nodes are computed for
+    // all the B-splines by a single product, then each interval contracts the SPLINE_DEGREE+1 columns of its active B-splines with
+    // PhiQuad_. The contributions of the elements are computed in parallel and summed afterwards in the order of the elements: the
+    // result does not depend on the number of threads.
+    VectorXr el_int(n_el);
+    MatrixXr el_grad(EL_NNODES*M, with_grad ? n_el : 0);
+
+    #pragma omp parallel for schedule(static)
+    for(long int e = 0; e < n_el; ++e) {
+        const UInt* nodes = this->getElementNodes(e);
+
+        MatrixXr sub_g(EL_NNODES, M);
+        for(UInt m = 0; m < M; ++m)
+            for(UInt i = 0; i < EL_NNODES; ++i)
+                sub_g(i,m) = g[nodes[i] + N*m];
+
+        // g at the spatial quadrature nodes, for each B-spline
+        const MatrixXr psi_g = this->PsiQuad_ * sub_g;
+        MatrixXr sub_grad = MatrixXr::Zero(EL_NNODES, with_grad ? M : 0);
+
+        Real integral = 0.;
+        for(UInt t = 0; t < n_int; ++t) {
+            const Real factor = this->getElementMeasure(e) * (mesh_time_[t+1]-mesh_time_[t])/2;
+            // weighted exp(g) at the space-time quadrature nodes of the element and of the interval
+            const QuadMatrix wexpg = factor * EigenMap2WEIGHTS(&Integrator::WEIGHTS[0]).asDiagonal() *
+                                     QuadMatrix((psi_g.middleCols(t, SPLINE_DEGREE+1) * PhiQuad_[t].transpose()).array().exp()) *
+                                     EigenMap2WEIGHTS_t(&Integrator_t::WEIGHTS[0]).asDiagonal();
+            integral += wexpg.sum();
+
+            if(with_grad)
+                sub_grad.middleCols(t, SPLINE_DEGREE+1) += this->PsiQuad_.transpose() * wexpg * PhiQuad_[t];
+        }
+
+        el_int[e] = integral;
+        if(with_grad)
+            el_grad.col(e) = Eigen::Map<const VectorXr>(sub_grad.data(), EL_NNODES*M);
+    }
+
+    // deterministic reduction
+    if(with_grad) {
+        *grad = VectorXr::Zero(N*M);
+        for(UInt e = 0; e < n_el; ++e) {
+            const UInt* nodes = this->getElementNodes(e);
+            for(UInt m = 0; m < M; ++m)
+                for(UInt i = 0; i < EL_NNODES; ++i)
+                    (*grad)[nodes[i] + N*m] += el_grad(i + EL_NNODES*m, e);
+        }
+    }
+
+    return el_int.sum();
+}
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+void DataProblem_time<ORDER, mydim, ndim>::fillUpsilon()
 {
     static constexpr Real eps = std::numeric_limits<Real>::epsilon(), tolerance = 100 * eps;
+    static constexpr UInt EL_NNODES = DataProblem<ORDER, mydim, ndim>::EL_NNODES;
 
-    const UInt phi_r = phi.rows();
-    const UInt phi_c = phi.cols();
-    const UInt psi_c = psi.cols();
+    const UInt n = deData_time_.dataSize();
+    const UInt N = this->getNumNodes();
 
-    if ((deData_time_.getNTimes() != deData_time_.dataSize()) && (this->Print())) {
+    if ((deData_time_.getNTimes() != n) && (this->Print())) {
         //Rprintf("WARNING: %d temporal duplicates.\n", deData_time_.dataSize() - deData_time_.getNTimes());
         Rprintf("%d distinct time instants.\n", deData_time_.getNTimes());
     }
 
-    std::vector<coeff> Upsilon_tripletList;
-    Upsilon_tripletList.reserve(deData_time_.dataSize() * phi_c * psi_c);
-
-    if(deData_time_.getNTimes() != deData_time_.dataSize()) // time duplicates: phi_r < psi_r
-    {
-        for(UInt i = 0; i < phi_r; ++i) {
-            const std::vector<UInt>& v = deData_time_.getTimes2Locations(i);
-            for(UInt j : v) {
-                SpMat localKProd_(1, phi_c * psi_c);
-                localKProd_ = kroneckerProduct(phi.row(i), psi.row(j));
-                for (UInt idx = 0; idx < localKProd_.outerSize(); ++idx)
-                    Upsilon_tripletList.emplace_back(j,idx,localKProd_.coeff(0, idx));
-            }
-        }
+    // row of GlobalPhi_ relative to each datum
+    std::vector<UInt> time_index(n);
+    if(deData_time_.getNTimes() != n) { // time duplicates
+        for(UInt i = 0; i < deData_time_.getNTimes(); ++i)
+            for(UInt j : deData_time_.getTimes2Locations(i))
+                time_index[j] = i;
     }
-    else // NO time duplicates: phi_r = psi_r = #observations
-    {
-        for(UInt i = 0; i < phi_r; ++i) {
-            SpMat localKProd_(1, phi_c * psi_c);
-            localKProd_ = kroneckerProduct(phi.row(i), psi.row(i));
-            for (UInt idx = 0; idx < localKProd_.outerSize(); ++idx)
-                Upsilon_tripletList.emplace_back(i,idx,localKProd_.coeff(0, idx));
-        }
+    else
+        std::iota(time_index.begin(), time_index.end(), 0);
+
+    const Eigen::SparseMatrix<Real, Eigen::RowMajor> phi = GlobalPhi_;
+
+    // the entry (i, m*N+k) is phi(time_index[i], m) * psi(i, k): the columns of each row are generated in increasing order,
+    // so that the matrix is written directly in compressed row format
+    Upsilon_.resize(n, phi.cols() * N);
+    Upsilon_.reserve(n * (SPLINE_DEGREE+1) * EL_NNODES);
+
+    std::array<std::pair<UInt, Real>, EL_NNODES> psi_row;
+    for(UInt i = 0; i < n; ++i) {
+        const UInt* nodes = this->getElementNodes(this->getDataElement(i));
+        const Real* values = &this->locationBasis_[this->dataLocation_[i]*EL_NNODES];
+        for(UInt node = 0; node < EL_NNODES; ++node)
+            psi_row[node] = std::make_pair(nodes[node], values[node]);
+        std::sort(psi_row.begin(), psi_row.end());
+
+        Upsilon_.startVec(i);
+        for(Eigen::SparseMatrix<Real, Eigen::RowMajor>::InnerIterator it(phi, time_index[i]); it; ++it)
+            for(const auto& entry : psi_row)
+                Upsilon_.insertBack(i, it.col() * N + entry.first) = it.value() * entry.second;
     }
+    Upsilon_.finalize();
 
-    SpMat upsilon(deData_time_.dataSize(), phi_c * psi_c);
-    upsilon.setFromTriplets(Upsilon_tripletList.begin(), Upsilon_tripletList.end());
-
-    upsilon.prune(tolerance);
-    upsilon.makeCompressed();
-
-    return upsilon;
+    Upsilon_.prune(tolerance);
+    Upsilon_.makeCompressed();
 }
 
 template<UInt ORDER, UInt mydim, UInt ndim>
 SpMat DataProblem_time<ORDER, mydim, ndim>::computeUpsilon(const std::vector<UInt>& indices) const
 {
-    static constexpr Real eps = std::numeric_limits<Real>::epsilon(), tolerance = 100 * eps;
+    const int* outer = Upsilon_.outerIndexPtr();
+
+    UInt nnz = 0;
+    for(UInt j : indices)
+        nnz += outer[j+1] - outer[j];
 
+    // copy of the selected rows (already pruned) of Upsilon_
     Eigen::SparseMatrix<Real, Eigen::RowMajor> upsilon(indices.size(), Upsilon_.cols());
+    upsilon.reserve(nnz);
 
-    for(UInt i = 0; i < indices.size(); ++i) {
-        upsilon.row(i) = Upsilon_.row(indices[i]);
+    for(std::size_t i = 0; i < indices.size(); ++i) {
+        upsilon.startVec(i);
+        for(Eigen::SparseMatrix<Real, Eigen::RowMajor>::InnerIterator it(Upsilon_, indices[i]); it; ++it)
+            upsilon.insertBack(i, it.col()) = it.value();
     }
-
-    upsilon.prune(tolerance);
-    upsilon.makeCompressed();
+    upsilon.finalize();
 
     return upsilon;
 
@@ -44,6 +44,10 @@ public:
 */
 template<UInt ORDER, UInt mydim, UInt ndim>
 class HeatProcess : public DensityInitialization<ORDER, mydim, ndim>{
+public:
+    // Sparse matrix stored by rows, to apply the diffusion one node at a time
+    using SpMatRow = Eigen::SparseMatrix<Real, Eigen::RowMajor>;
+
 protected:
     static constexpr UInt EL_NNODES = DensityInitialization<ORDER, mydim, ndim>::EL_NNODES;
     // A member to access functional methods
@@ -52,6 +56,8 @@ protected:
     std::vector<VectorXr> init_proposals_;
     // patch_areas_: for each mesh node it saves the sum of the area of each triangle that has that node
     VectorXr patch_areas_;
+    // neighbours_mean_: the row k (stored in CSR format) computes the mean over the neighbours of node k
+    SpMatRow neighbours_mean_;
     //  Parameters useful for the initialization of the density
     UInt niter_;
     Real alpha_;
@@ -62,13 +68,11 @@ protected:
     // Penalization term for each possible initial density
     VectorXr penTerm_;
 
-    //! A method to compute the density exploting only the data.
-    VectorXr computeDensityOnlyData();
+    //! A method to compute the density exploting only the data in the positions stored in data_index.
+    VectorXr computeDensityOnlyData(const std::vector<UInt>& data_index) const;
     //! A method that provides a set of starting densities.
     void computeStartingDensities();
 
-    std::vector<UInt> data_index_;
-
 public:
     //! A Constructor.
     HeatProcess(const DataProblem<ORDER, mydim, ndim>& dp,
@@ -78,6 +82,11 @@ public:
     const VectorXr* chooseInitialization(Real lambda) const override;
     //! A method to compute the patch_areas_.
     static VectorXr computePatchAreas(const MeshHandler<ORDER, mydim, ndim>& mesh);
+    //! A method to compute the neighbours_mean_ matrix, built once from the connectivity of the mesh.
+    static SpMatRow computeNeighboursMean(const MeshHandler<ORDER, mydim, ndim>& mesh);
+    //! A method to perform a step of the discretized heat diffusion process on each column of x: the result is stored in x_new.
+    //! The rows are processed in parallel.
+    static void diffusionStep(const SpMatRow& neighbours_mean, Real alpha, const MatrixXr& x, MatrixXr& x_new);
 };
 
 
@@ -145,12 +154,15 @@ template<UInt ORDER, UInt mydim, UInt ndim>
 class HeatProcess_time : public DensityInitialization_time<ORDER, mydim, ndim>{
 protected:
     static constexpr UInt EL_NNODES = DensityInitialization_time<ORDER, mydim, ndim>::EL_NNODES;
+    using SpMatRow = typename HeatProcess<ORDER, mydim, ndim>::SpMatRow;
     // A member to access functional methods
     const FunctionalProblem_time<ORDER, mydim, ndim>& funcProblem_;
     // A vector of vectors containing all the possible initial densities given by the heat diffusion process
     std::vector<VectorXr> init_proposals_;
     // patch_areas_: for each mesh node it saves the sum of the area of each triangle that has that node
     VectorXr patch_areas_;
+    // neighbours_mean_: the row k (stored in CSR format) computes the mean over the neighbours of node k
+    SpMatRow neighbours_mean_;
     //  Parameters useful for the initialization of the density
     UInt niter_;
     Real alpha_;
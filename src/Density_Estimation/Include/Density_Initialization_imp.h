@@ -1,8 +1,6 @@
 #ifndef __DENSITY_INITIALIZATION_IMP_H__
 #define __DENSITY_INITIALIZATION_IMP_H__
 
-#include <unordered_set>
-
 template<UInt ORDER, UInt mydim, UInt ndim>
 UserInitialization<ORDER, mydim, ndim>::UserInitialization(const DataProblem<ORDER, mydim, ndim>& dp):
   DensityInitialization<ORDER, mydim, ndim>(dp){
@@ -26,15 +24,13 @@ HeatProcess<ORDER, mydim, ndim>::HeatProcess(const DataProblem<ORDER, mydim, ndi
   DensityInitialization<ORDER, mydim, ndim>(dp), funcProblem_(fp){
 
     patch_areas_ = computePatchAreas(dp.getMesh());
+    neighbours_mean_ = computeNeighboursMean(dp.getMesh());
     alpha_=dp.getHeatStep();
     niter_=dp.getHeatIter();
     init_proposals_.resize(niter_);
     llik_.resize(niter_);
     penTerm_.resize(niter_);
 
-    data_index_.resize(this->dataProblem_.dataSize());
-    std::iota(data_index_.begin(),data_index_.end(),0);
-
     computeStartingDensities();
 
 }
@@ -53,15 +49,61 @@ VectorXr HeatProcess<ORDER, mydim, ndim>::computePatchAreas(const MeshHandler<OR
 
 
 template<UInt ORDER, UInt mydim, UInt ndim>
-VectorXr HeatProcess<ORDER, mydim, ndim>::computeDensityOnlyData()
+typename HeatProcess<ORDER, mydim, ndim>::SpMatRow HeatProcess<ORDER, mydim, ndim>::computeNeighboursMean(const MeshHandler<ORDER, mydim, ndim>& mesh){
+    // two nodes are neighbours if they share an element: the pattern of each row is the set of the neighbours of the node
+    std::vector<Eigen::Triplet<Real>> triplets;
+    triplets.reserve(mesh.num_elements()*EL_NNODES*(EL_NNODES-1));
+    for(UInt t=0; t<mesh.num_elements(); ++t){
+        Element<EL_NNODES, mydim, ndim> current_element = mesh.getElement(t);
+        for(UInt i=0; i<EL_NNODES; ++i)
+            for(UInt j=0; j<EL_NNODES; ++j)
+                if(i != j)
+                    triplets.emplace_back(current_element[i].id(), current_element[j].id(), 1.);
+    }
+
+    SpMatRow neighbours_mean(mesh.num_nodes(), mesh.num_nodes());
+    neighbours_mean.setFromTriplets(triplets.begin(), triplets.end());
+    neighbours_mean.makeCompressed();
+
+    // the duplicated entries are summed: each neighbour is then weighted by the inverse of the number of neighbours
+    for(UInt k=0; k<neighbours_mean.outerSize(); ++k){
+        const Real weight = 1./(neighbours_mean.outerIndexPtr()[k+1] - neighbours_mean.outerIndexPtr()[k]);
+        for(typename SpMatRow::InnerIterator it(neighbours_mean, k); it; ++it)
+            it.valueRef() = weight;
+    }
+
+    return neighbours_mean;
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+void HeatProcess<ORDER, mydim, ndim>::diffusionStep(const SpMatRow& neighbours_mean, Real alpha, const MatrixXr& x, MatrixXr& x_new){
+    const long int N = x.rows();
+    const UInt ncols = x.cols();
+    x_new.resize(N, ncols);
+
+    #pragma omp parallel for schedule(static)
+    for(long int k=0; k<N; ++k){
+        for(UInt c=0; c<ncols; ++c){
+            Real mean = 0.;
+            for(typename SpMatRow::InnerIterator it(neighbours_mean, k); it; ++it)
+                mean += it.value()*x(it.col(), c);
+            x_new(k,c) = x(k,c) + alpha*(mean - x(k,c));
+        }
+    }
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+VectorXr HeatProcess<ORDER, mydim, ndim>::computeDensityOnlyData(const std::vector<UInt>& data_index) const
 {
 
     VectorXr x = VectorXr::Zero(this->dataProblem_.getNumNodes());
 
-    for(UInt i : data_index_) {
-        Element<EL_NNODES, mydim, ndim> current_element = this->dataProblem_.findLocation(this->dataProblem_.data(i));
-        for(const auto& node : current_element)
-            x[node.id()] += 1;
+    for(UInt i : data_index) {
+        const UInt* nodes = this->dataProblem_.getElementNodes(this->dataProblem_.getDataElement(i));
+        for(UInt node = 0; node < EL_NNODES; ++node)
+            x[nodes[node]] += 1;
     }
 
     x.array() /= patch_areas_.array();
@@ -75,34 +117,15 @@ template<UInt ORDER, UInt mydim, UInt ndim>
 void HeatProcess<ORDER, mydim, ndim>::computeStartingDensities()
 {
 
-	VectorXr x = computeDensityOnlyData();
+	std::vector<UInt> data_index(this->dataProblem_.dataSize());
+	std::iota(data_index.begin(), data_index.end(), 0);
 
-	std::vector<std::unordered_set<UInt>> neighbours_nodes(this->dataProblem_.getNumNodes());
-	// It saves in the i-th position the set of the neighbor nodes ids that have node i
-
-	for(UInt t = 0; t < this->dataProblem_.getNumElements(); ++t) {
-		Element<EL_NNODES, mydim, ndim> current_element = this->dataProblem_.getElement(t);
-		for(UInt i = 0; i < EL_NNODES; ++i) {
-			for(UInt j = i+1; j < EL_NNODES; ++j) {
-					neighbours_nodes[current_element[i].id()].insert(current_element[j].id());
-					neighbours_nodes[current_element[j].id()].insert(current_element[i].id());
-			}
-		}
-	}
+	MatrixXr x = computeDensityOnlyData(data_index), x_new;
 
 	for(UInt j = 0; j < niter_; ++j) {
-		VectorXr x_new(this->dataProblem_.getNumNodes());
-		for(UInt k = 0; k < this->dataProblem_.getNumNodes(); ++k) {
-			Real mean = 0.;
-			for(UInt elem : neighbours_nodes[k]){
-				mean += x[elem];
-			}
-			mean /= neighbours_nodes[k].size();
-
-			x_new[k] = x[k] + alpha_*(mean - x[k]);
-		}
+		diffusionStep(neighbours_mean_, alpha_, x, x_new);
 
-		init_proposals_[j] = x_new.array() + epsilon_;  // Modify initial density
+		init_proposals_[j] = x_new.col(0).array() + epsilon_;  // Modify initial density
 
         std::tie(llik_[j], penTerm_[j]) = funcProblem_.computeLlikPen_f(init_proposals_[j]);
 
@@ -153,6 +176,10 @@ void Heat_CV<ORDER, mydim, ndim>::perform_init_cv()
       K_folds_[length + i/K] = i;
     }
 
+    // The training densities of all the folds are the columns of x, diffused together
+    MatrixXr x(this->dataProblem_.getNumNodes(), K), x_new;
+    std::vector<SpMat> Psi_valid(K);
+
     // Cycle on the folds
     for (UInt i = 0; i < K; ++i) {
 
@@ -167,28 +194,25 @@ void Heat_CV<ORDER, mydim, ndim>::perform_init_cv()
             std::copy(K_folds_.cbegin()+ (N % K) + i*(N/K), K_folds_.cbegin()+ (N % K) + (i+1)*(N/K), std::back_inserter(x_valid));
         }
 
-        // Train
-        this->data_index_ = x_train;
-        this-> computeStartingDensities();
+        x.col(i) = this->computeDensityOnlyData(x_train);
+        Psi_valid[i] = this->dataProblem_.computePsi(x_valid);
+    }
 
-        // Error
-        SpMat Psi_valid = this->dataProblem_.computePsi(x_valid);
+    // Train and error
+    for(UInt j = 0; j < this->niter_; ++j) {
+        this->diffusionStep(this->neighbours_mean_, this->alpha_, x, x_new);
 
-        for(UInt j = 0; j < this->niter_; ++j) {
-            cv_errors_[j] += this->error_(Psi_valid, this->init_proposals_[j]);
-        }
+        for (UInt i = 0; i < K; ++i)
+            cv_errors_[j] += this->error_(Psi_valid[i], x_new.col(i).array() + this->epsilon_);
 
+        x.swap(x_new);
     }
 
     init_best_ = std::distance(cv_errors_.cbegin(), std::min_element(cv_errors_.cbegin(), cv_errors_.cend()));
 
     Rprintf("The initialization selected is the number %d\n", init_best_);
 
-    // Total
-    this->data_index_.resize(this->dataProblem_.dataSize());
-    std::iota(this->data_index_.begin(),this->data_index_.end(),0);
-
-    this-> computeStartingDensities();
+    // The proposals on all the data have been computed by the HeatProcess constructor
 
 }
 
@@ -231,6 +255,7 @@ HeatProcess_time<ORDER, mydim, ndim>::HeatProcess_time(const DataProblem_time<OR
   DensityInitialization_time<ORDER, mydim, ndim>(dp), funcProblem_(fp){
 
     patch_areas_ = HeatProcess<ORDER,mydim,ndim>::computePatchAreas(dp.getMesh());
+    neighbours_mean_ = HeatProcess<ORDER,mydim,ndim>::computeNeighboursMean(dp.getMesh());
     alpha_ = dp.getHeatStep();
     niter_ = dp.getHeatIter();
     init_proposals_.resize(niter_);
@@ -256,10 +281,9 @@ VectorXr HeatProcess_time<ORDER, mydim, ndim>::computeDensityOnlyData(UInt num_b
     const std::vector<UInt>&  data_index_ = this->dataProblem_.getDataIndex_Heat(num_basis);
     if (data_index_.size()!=0) {
         for (UInt i : data_index_) {
-            Element<EL_NNODES, mydim, ndim> current_element = this->dataProblem_.findLocation(
-                    this->dataProblem_.data(i));
-            for (const auto &node : current_element)
-                x[node.id()] += 1;
+            const UInt* nodes = this->dataProblem_.getElementNodes(this->dataProblem_.getDataElement(i));
+            for (UInt node = 0; node < EL_NNODES; ++node)
+                x[nodes[node]] += 1;
         }
     }
 
@@ -276,42 +300,15 @@ void HeatProcess_time<ORDER, mydim, ndim>::computeStartingDensities()
     const UInt M = this->dataProblem_.getSplineNumber();
     const UInt N = this->dataProblem_.getNumNodes();
 
-    VectorXr x = VectorXr::Zero(N*M);
-    //VectorXr x_local;
-    for (int num_basis = 0; num_basis < M; ++num_basis) {
-        VectorXr x_local = computeDensityOnlyData(num_basis);
-        for (int i = 0; i < N; ++i) {
-            x[i+N*num_basis] = x_local[i];
-        }
-    }
-
-    std::vector<std::unordered_set<UInt>> neighbours_nodes(this->dataProblem_.getNumNodes());
-    // It saves in the i-th position the set of the neighbour nodes ids that have node i
-
-    for(UInt t = 0; t < this->dataProblem_.getNumElements(); ++t) {
-        Element<EL_NNODES, mydim, ndim> current_element = this->dataProblem_.getElement(t);
-        for(UInt i = 0; i < EL_NNODES; ++i){
-            for(UInt j = i+1; j < EL_NNODES; ++j){
-                neighbours_nodes[current_element[i].id()].insert(current_element[j].id());
-                neighbours_nodes[current_element[j].id()].insert(current_element[i].id());
-            }
-        }
-    }
+    // The densities of the B-splines are the columns of x (i.e. x[i+N*num_basis] in the space-time vector), diffused together
+    MatrixXr x(N, M), x_new;
+    for (UInt num_basis = 0; num_basis < M; ++num_basis)
+        x.col(num_basis) = computeDensityOnlyData(num_basis);
 
     for(UInt j = 0; j < niter_; ++j) {
-        VectorXr x_new(N*M);
-        for (int num_basis = 0; num_basis < M; ++num_basis) {
-            for(UInt k = 0; k < this->dataProblem_.getNumNodes(); ++k) {
-                Real mean = 0.;
-                for(UInt elem : neighbours_nodes[k]){
-                    mean += x[elem+N*num_basis];
-                }
-                mean /= neighbours_nodes[k].size();
-                x_new[k+N*num_basis] = x[k+N*num_basis] + alpha_*(mean - x[k+N*num_basis]);
-            }
-        }
+        HeatProcess<ORDER,mydim,ndim>::diffusionStep(neighbours_mean_, alpha_, x, x_new);
 
-        init_proposals_[j] = x_new.array() + epsilon_;  // Modify initial density
+        init_proposals_[j] = Eigen::Map<const VectorXr>(x_new.data(), N*M).array() + epsilon_;  // Modify initial density
 
         std::tie(llik_[j], penSterm_[j], penTterm_[j]) = funcProblem_.computeLlikPen_f(init_proposals_[j]);
 
@@ -2,6 +2,7 @@
 #define __DESCENT_DIRECTION_H__
 
 #include "../../Global_Utilities/Include/Make_Unique.h"
+#include "../../Global_Utilities/Include/Instrumentation.h"
 
 // This file contains the direction search technique useful for the optimization algorithm of the Density Estimation problem
 
@@ -26,6 +27,9 @@ class DirectionBase{
     virtual VectorXr computeDirection(const VectorXr& g, const VectorXr& grad) = 0;
     //! A pure virtual method to reset all the old parameters.
     virtual void resetParameters() = 0;
+    //! A method to set the penalization parameter and the number of data of the current
+    //! minimization. Only the directions built on the Hessian of the functional need them: by default it does nothing.
+    virtual void setProblem(Real, UInt) {}
 };
 
 
@@ -143,5 +147,49 @@ public:
 
 };
 
+//! @brief A class for computing the truncated Newton direction, by preconditioned conjugate gradient.
+/*! The Newton system H*d = -grad, H = n*int3(g) + 2*lambda*P being the Hessian of the functional, is solved approximately by
+ * preconditioned conjugate gradient, using only products of H with vectors (see FunctionalProblem::computeHessianProduct), so that H
+ * is never assembled. The iterations stop when the relative residual falls below min(0.5, sqrt(|grad|)) (so that the direction becomes
+ * the exact Newton one close to the minimum), after maxIter_ iterations or on a direction of non-positive curvature.
+ * The preconditioner is the sparse matrix n*diag(int2(g)) + 2*lambda*R1^T*D0^-1*R1, obtained by lumping both the mass matrix in the
+ * penalty (D0) and the Hessian of the integral term (int2 are its row sums); it is factorized at each direction, on the pattern
+ * computed once in setProblem. This class only handles the spatial problem.
+*/
+template<UInt ORDER, UInt mydim, UInt ndim>
+class DirectionNewtonCG : public DirectionBase<ORDER, mydim, ndim>{
+private:
+    // A member to access the finite element matrices
+    const DataProblem<ORDER, mydim, ndim>& dataProblem_;
+    // Maximum number of conjugate gradient iterations for each direction
+    UInt maxIter_;
+    // Penalization parameter and number of data of the current minimization
+    Real lambda_;
+    UInt n_;
+    // Penalty part of the preconditioner, 2*lambda*R1^T*D0^-1*R1, and its factorization
+    SpMat penaltyPrec_;
+    Eigen::SimplicialLDLT<SpMat> precDec_;
+    // Flag to warn only once per minimization when the preconditioner cannot be factorized
+    bool precWarned_;
+
+public:
+    //! A constructor.
+    DirectionNewtonCG(const FunctionalProblem<ORDER, mydim, ndim>& fp, const DataProblem<ORDER, mydim, ndim>& dp, UInt maxIter):
+            DirectionBase<ORDER, mydim, ndim>(fp), dataProblem_(dp), maxIter_(maxIter), lambda_(0), n_(0), precWarned_(false){};
+    //! A copy constructor: it just creates a DirectionNewtonCG object with the same features of rhs, the preconditioner being rebuilt by setProblem.
+    DirectionNewtonCG(const DirectionNewtonCG<ORDER, mydim, ndim>& rhs):
+            DirectionBase<ORDER, mydim, ndim>(rhs), dataProblem_(rhs.dataProblem_), maxIter_(rhs.maxIter_), lambda_(0), n_(0), precWarned_(false){};
+    //! Clone method overridden.
+    std::unique_ptr<DirectionBase<ORDER, mydim, ndim>> clone() const override;
+    //! A method to compute the truncated Newton direction. If the preconditioner cannot be factorized the conjugate gradient is not
+    //! preconditioned: a warning is printed and the directions are counted in the instrumentation counter "newton_unpreconditioned".
+    VectorXr computeDirection(const VectorXr& g, const VectorXr& grad) override;
+    //! A method to reset all the old parameters. In the Newton method they aren't.
+    void resetParameters() override {};
+    //! A method to set the penalization parameter and the data: it builds the penalty part of the preconditioner.
+    void setProblem(Real lambda, UInt n) override;
+
+};
+
 #include "Descent_Direction_imp.h"
 #endif
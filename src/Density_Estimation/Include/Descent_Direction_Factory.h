@@ -34,6 +34,8 @@ class DescentDirection_factory
             return fdaPDE::make_unique<DirectionLBFGS<ORDER, mydim, ndim>>(fp, 5);
         else if (d=="L-BFGS10")
             return fdaPDE::make_unique<DirectionLBFGS<ORDER, mydim, ndim>>(fp, 10);
+        else if (d=="NewtonCG")
+            return fdaPDE::make_unique<DirectionNewtonCG<ORDER, mydim, ndim>>(fp, dp, 50);
 		else{
 
 			Rprintf("Unknown direction option - using gradient direction");
@@ -270,4 +270,92 @@ void DirectionLBFGS<ORDER, mydim, ndim, T>::resetParameters(){
 
 }
 
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+std::unique_ptr<DirectionBase<ORDER, mydim, ndim>> DirectionNewtonCG<ORDER, mydim, ndim>::clone() const {
+
+    return fdaPDE::make_unique<DirectionNewtonCG<ORDER, mydim, ndim>>(*this);
+
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+void DirectionNewtonCG<ORDER, mydim, ndim>::setProblem(Real lambda, UInt n){
+
+    lambda_ = lambda;
+    n_ = n;
+
+    // lumped mass matrix
+    const SpMat R0 = dataProblem_.getMass();
+    const SpMat R1 = dataProblem_.getStiffness();
+    const VectorXr D0_inv = (R0*VectorXr::Ones(R0.cols())).cwiseInverse();
+
+    // the pattern of R1^T*D0^-1*R1 contains the diagonal, where n*int2(g) is added at each direction
+    penaltyPrec_ = 2*lambda_*(R1.transpose()*D0_inv.asDiagonal()*R1);
+    penaltyPrec_.makeCompressed();
+    precDec_.analyzePattern(penaltyPrec_);
+    precWarned_ = false;
+
+}
+
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+VectorXr DirectionNewtonCG<ORDER, mydim, ndim>::computeDirection(const VectorXr& g, const VectorXr& grad){
+
+    // Preconditioner at g
+    VectorXr int2;
+    dataProblem_.FEintegrate_exponential(g, &int2);
+    SpMat M = penaltyPrec_;
+    for(UInt k = 0; k < M.outerSize(); ++k)
+        for(SpMat::InnerIterator it(M, k); it; ++it)
+            if(it.row() == it.col())
+                it.valueRef() += n_*int2[k];
+    precDec_.factorize(M);
+    const bool preconditioned = precDec_.info() == Eigen::Success;
+    if(!preconditioned){
+        Instrumentation::get().addCount("newton_unpreconditioned");
+        if(!precWarned_){
+            Rprintf("WARNING: the preconditioner of the Newton direction cannot be factorized, the conjugate gradient proceeds without it.\n");
+            precWarned_ = true;
+        }
+    }
+
+    auto applyPrec = [&](const VectorXr& r) -> VectorXr { return preconditioned ? VectorXr(precDec_.solve(r)) : r; };
+
+    // Truncated preconditioned conjugate gradient on H*d = -grad
+    const Real grad_norm = grad.norm();
+    const Real tol = std::min(0.5, std::sqrt(grad_norm))*grad_norm;
+
+    VectorXr d = VectorXr::Zero(grad.size());
+    VectorXr r = -grad;
+    VectorXr z = applyPrec(r);
+    VectorXr p = z;
+    Real rz = r.dot(z);
+
+    for(UInt i = 0; i < maxIter_; ++i){
+        const VectorXr Hp = this->funcProblem_.computeHessianProduct(g, lambda_, n_, p);
+        const Real pHp = p.dot(Hp);
+
+        // non-positive curvature: keep the direction found so far (the preconditioned gradient at the first iteration)
+        if(pHp <= 0){
+            if(i == 0) d = p;
+            break;
+        }
+
+        const Real alpha = rz/pHp;
+        d += alpha*p;
+        r -= alpha*Hp;
+
+        if(r.norm() <= tol) break;
+
+        z = applyPrec(r);
+        const Real rz_new = r.dot(z);
+        p = z + (rz_new/rz)*p;
+        rz = rz_new;
+    }
+
+    return d;
+
+}
+
 #endif
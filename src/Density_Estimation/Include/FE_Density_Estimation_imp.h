@@ -27,7 +27,7 @@ void FEDE<ORDER, mydim, ndim>::apply()
     // final minimization descent
     Rprintf("##### FINAL STEP #####\n");
 
-    gcoeff_ = minAlgo_->apply_core(dataProblem_.getGlobalPsi(), bestLambda_, gInit);
+    gcoeff_ = minAlgo_->apply_core(dataProblem_.getDataPsiSum(), dataProblem_.dataSize(), bestLambda_, gInit);
 
     if(dataProblem_.Inference()){
         // CI computation
@@ -70,7 +70,7 @@ void FEDE_time<ORDER, mydim, ndim>::apply()
     // final minimization descent
     Rprintf("##### FINAL STEP #####\n");
 
-    gcoeff_ = minAlgo_->apply_core(dataProblem_.getUpsilon(), bestLambda_S, bestLambda_T, gInit);
+    gcoeff_ = minAlgo_->apply_core(SpMat(dataProblem_.getUpsilon()), bestLambda_S, bestLambda_T, gInit);
 
     if(dataProblem_.Inference()){
         // CI computation
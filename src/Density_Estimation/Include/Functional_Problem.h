@@ -2,6 +2,7 @@
 #define __FUNCTIONAL_PROBLEM_H__
 
 #include "Data_Problem.h"
+#include "../../FE_Assemblers_Solvers/Include/Selected_Inversion.h"
 
 // This file implements the functional of the Density Estimation problem
 
@@ -17,14 +18,19 @@ class FunctionalProblem{
 
     //! A method to compute the integrals of the functional.
     std::pair<Real, VectorXr> computeIntegrals(const VectorXr& g) const;
-    //! A method to compute the laplacian of the log-likelihood
-    MatrixXr computellikLaplacian(const VectorXr& g) const;
+    //! A method to compute the laplacian of the log-likelihood, as a sparse matrix with the pattern of the mass matrix
+    SpMat computellikLaplacian(const VectorXr& g) const;
 
   public:
     //! A constructor
     FunctionalProblem(const DataProblem<ORDER, mydim, ndim>& dp): dataProblem_(dp){};
     //! A method to compute the functional for the g-function. Output: loss, gradient, llik, penterm.
     std::tuple<Real, VectorXr, Real, Real> computeFunctional_g(const VectorXr& g, Real lambda, const SpMat& Psi) const;
+    //! A method to compute the functional for the g-function, given the n data only through psi_sum = Psi^T*1, on which the
+    //! log-likelihood depends linearly: the cost does not depend on n. Output: loss, gradient, llik, penterm.
+    std::tuple<Real, VectorXr, Real, Real> computeFunctional_g(const VectorXr& g, Real lambda, const VectorXr& psi_sum, UInt n) const;
+    //! A method to compute the product of the Hessian of the functional for the g-function (n data) with a vector, without assembling it.
+    VectorXr computeHessianProduct(const VectorXr& g, Real lambda, UInt n, const VectorXr& v) const;
     //! A method to compute the log-likelihood and the penalization term for the f-function.
     std::pair<Real,Real> computeLlikPen_f(const VectorXr& f) const;
     //! A method to compute the covariance of the Gaussian approximation for the Confidence Bounds
@@ -57,6 +63,10 @@ public:
     //! A method to compute the functional for the g-function. Output: loss, gradient, llik, penterms.
     std::tuple<Real, VectorXr, Real, Real, Real> computeFunctional_g(const VectorXr& g, Real lambda, Real lambda_T,
                                                                      const SpMat& Upsilon) const;
+    //! A method to compute the functional for the g-function, given the n data only through upsilon_sum = Upsilon^T*1.
+    //! Output: loss, gradient, llik, penterms.
+    std::tuple<Real, VectorXr, Real, Real, Real> computeFunctional_g(const VectorXr& g, Real lambda, Real lambda_T,
+                                                                     const VectorXr& upsilon_sum, UInt n) const;
     //! A method to compute for the Confidence Bounds obtained thanks to the Gaussian approximation.
     std::pair<VectorXr, VectorXr> computeCovariance_CI(const VectorXr& g, Real lambda_S, Real lambda_T) const;
     //! A method to compute the log-likelihood and the penalization terms for the f-function.
@@ -5,53 +5,39 @@ template<UInt ORDER, UInt mydim, UInt ndim>
 std::pair<Real,VectorXr>
 FunctionalProblem<ORDER, mydim, ndim>::computeIntegrals(const VectorXr& g) const{
 
-	using EigenMap2WEIGHTS = Eigen::Map<const Eigen::Matrix<Real, Integrator::NNODES, 1> >;
+  // int1 = integral of exp(g), int2 = its gradient, both computed by the fused kernel of the data problem
+	VectorXr int2;
+	Real int1 = dataProblem_.FEintegrate_exponential(g, &int2);
 
-  // Initialization
-	Real int1 = 0.;
-	VectorXr int2 = VectorXr::Zero(dataProblem_.getNumNodes());
-
-	for(UInt triangle=0; triangle<dataProblem_.getNumElements(); triangle++){
-
-		Element<EL_NNODES, mydim, ndim> tri_activated = dataProblem_.getElement(triangle);
-// (1) -------------------------------------------------
-
-    Eigen::Matrix<Real,EL_NNODES,1> sub_g;
-    for (UInt i=0; i<EL_NNODES; i++){
-      sub_g[i]=g[tri_activated[i].getId()];
-    }
-// (2) -------------------------------------------------
-		Eigen::Matrix<Real,Integrator::NNODES,1> expg = (dataProblem_.getPsiQuad()*sub_g).array().exp();
+	return std::pair<Real, VectorXr> (int1, int2);
+}
 
-    Eigen::Matrix<Real,EL_NNODES,1> sub_int2;
 
-    int1+=expg.dot(EigenMap2WEIGHTS(&Integrator::WEIGHTS[0]))*tri_activated.getMeasure();
-  	sub_int2 = dataProblem_.getPsiQuad().transpose() * expg.cwiseProduct(EigenMap2WEIGHTS(&Integrator::WEIGHTS[0]))*tri_activated.getMeasure();
+template<UInt ORDER, UInt mydim, UInt ndim>
+std::tuple<Real, VectorXr, Real, Real>
+FunctionalProblem<ORDER, mydim, ndim>::computeFunctional_g(const VectorXr& g, Real lambda, const SpMat& Psi) const{
 
-  	for (UInt i=0; i<EL_NNODES; i++){
-  		int2[tri_activated[i].getId()]+= sub_int2[i];
-  	}
-	}
+  return computeFunctional_g(g, lambda, VectorXr(Psi.transpose()*VectorXr::Ones(Psi.rows())), Psi.rows());
 
-	return std::pair<Real, VectorXr> (int1, int2);
 }
 
 
 template<UInt ORDER, UInt mydim, UInt ndim>
 std::tuple<Real, VectorXr, Real, Real>
-FunctionalProblem<ORDER, mydim, ndim>::computeFunctional_g(const VectorXr& g, Real lambda, const SpMat& Psi) const{
+FunctionalProblem<ORDER, mydim, ndim>::computeFunctional_g(const VectorXr& g, Real lambda, const VectorXr& psi_sum, UInt n) const{
 
   Real int1;
   VectorXr int2;
   std::tie(int1,int2) = computeIntegrals(g);
 
-  const UInt n = Psi.rows();
-  const Real llik = -(Psi*g).sum() + n*int1;
-  const Real pen = g.dot(dataProblem_.getP()*g);
+  // sum_i (Psi*g)_i = (Psi^T*1)^T*g
+  const Real llik = -psi_sum.dot(g) + n*int1;
+  const VectorXr Pg = dataProblem_.applyP(g);
+  const Real pen = g.dot(Pg);
 
-	VectorXr grad1 = - VectorXr::Constant(n,1).transpose()*Psi;
+	VectorXr grad1 = - psi_sum;
 	VectorXr grad2 =  n*int2;
-	VectorXr grad3 = 2*g.transpose()*dataProblem_.getP();
+	VectorXr grad3 = 2*Pg;
 
 	VectorXr grad = grad1 + grad2 + lambda*grad3;
 
@@ -60,48 +46,67 @@ FunctionalProblem<ORDER, mydim, ndim>::computeFunctional_g(const VectorXr& g, Re
 }
 
 
+template<UInt ORDER, UInt mydim, UInt ndim>
+VectorXr
+FunctionalProblem<ORDER, mydim, ndim>::computeHessianProduct(const VectorXr& g, Real lambda, UInt n, const VectorXr& v) const{
+
+  // H = n*int3 + 2*lambda*P, int3 being the Hessian of the integral of exp(g)
+  VectorXr int3v;
+  dataProblem_.FEintegrate_exponential(g, nullptr, &v, &int3v);
+
+  return n*int3v + 2*lambda*dataProblem_.applyP(v);
+}
+
+
 template<UInt ORDER, UInt mydim, UInt ndim>
 std::pair<Real,Real>
 FunctionalProblem<ORDER, mydim, ndim>::computeLlikPen_f(const VectorXr& f) const{
 
-  Real llik = - (dataProblem_.getGlobalPsi()*f).array().log().sum() +
+  // the data sharing a location contribute with the same term, weighted by their number
+  Real llik = - dataProblem_.getLocationWeights().dot(VectorXr((dataProblem_.getLocationPsi()*f).array().log())) +
                   dataProblem_.dataSize()*dataProblem_.FEintegrate(f);
   VectorXr tmp = f.array().log();
-  Real pen = tmp.dot(dataProblem_.getP()*tmp);
+  Real pen = tmp.dot(dataProblem_.applyP(tmp));
 
   return std::pair<Real, Real>(llik,pen);
 }
 
 template<UInt ORDER, UInt mydim, UInt ndim>
-MatrixXr
+SpMat
 FunctionalProblem<ORDER, mydim, ndim>::computellikLaplacian(const VectorXr& g) const {
     using EigenMap2WEIGHTS = Eigen::Map<const Eigen::Matrix<Real, Integrator::NNODES, 1>>;
 
-    MatrixXr int3 = MatrixXr::Zero(dataProblem_.getNumNodes(),dataProblem_.getNumNodes());
+    // int3 has the sparsity pattern of the mass matrix: the contributions of the elements are collected as triplets (summed by setFromTriplets)
+    const UInt n_el = dataProblem_.getNumElements();
+    std::vector<coeff> triplets;
+    triplets.reserve(n_el*EL_NNODES*EL_NNODES);
 
-    for(UInt triangle = 0; triangle < dataProblem_.getNumElements(); triangle++){
+    for(UInt triangle = 0; triangle < n_el; triangle++){
 
-        Element<EL_NNODES, mydim, ndim> tri_activated = dataProblem_.getElement(triangle);
+        const UInt* nodes = dataProblem_.getElementNodes(triangle);
 
         Eigen::Matrix<Real,EL_NNODES,1> sub_g;
         for (UInt i = 0; i < EL_NNODES; i++){
-            sub_g[i] = g[tri_activated[i].getId()];
+            sub_g[i] = g[nodes[i]];
         }
 
         Eigen::Matrix<Real, Integrator::NNODES, 1> expg = (dataProblem_.getPsiQuad()*sub_g).array().exp();
         Eigen::Matrix<Real, Integrator::NNODES, 1> sub_expg = expg.cwiseProduct(EigenMap2WEIGHTS(&Integrator::WEIGHTS[0]));
         Eigen::Matrix<Real, EL_NNODES, EL_NNODES> sub_int3;
 
-        sub_int3 = dataProblem_.getPsiQuad().transpose() * sub_expg.asDiagonal() * dataProblem_.getPsiQuad()  * tri_activated.getMeasure();
+        sub_int3 = dataProblem_.getPsiQuad().transpose() * sub_expg.asDiagonal() * dataProblem_.getPsiQuad()  * dataProblem_.getElementMeasure(triangle);
 
         for (UInt i = 0; i < EL_NNODES; i++){
             for(UInt j = 0; j < EL_NNODES; j++){
-                int3(tri_activated[i].getId(),tri_activated[j].getId()) += sub_int3(i,j);
+                triplets.emplace_back(nodes[i], nodes[j], sub_int3(i,j));
             }
         }
 
     }
 
+    SpMat int3(dataProblem_.getNumNodes(), dataProblem_.getNumNodes());
+    int3.setFromTriplets(triplets.begin(), triplets.end());
+
     return int3;
 }
 
@@ -109,11 +114,42 @@ template<UInt ORDER, UInt mydim, UInt ndim>
 std::pair<VectorXr, VectorXr>
 FunctionalProblem<ORDER, mydim, ndim>::computeCovariance_CI(const VectorXr& g, Real lambda) const {
     const Real n = dataProblem_.dataSize();
-    MatrixXr int3 = computellikLaplacian(g);
+    const UInt N = dataProblem_.getNumNodes();
     const Real scaling = dataProblem_.getScaling();
-    MatrixXr gamma = int3 + 2*lambda/scaling*dataProblem_.getP();
-    MatrixXr gamma_inv = (2/n) * gamma.inverse();
-    VectorXr v_g = gamma_inv.diagonal();
+
+    // gamma = int3 + 2*lambda/scaling*P, with P = R1^T R0^-1 R1 dense, is the Schur complement of the sparse quasi-definite matrix
+    //   K = [ int3  c*R1^T ]
+    //       [ c*R1   -R0   ],  c = sqrt(2*lambda/scaling),
+    // hence the diagonal of gamma^-1 is the first block of the diagonal of K^-1, given by the selected inversion of its sparse factorization.
+    const Real c = std::sqrt(2*lambda/scaling);
+    const SpMat int3 = computellikLaplacian(g);
+    const SpMat& R0 = dataProblem_.getMass();
+    const SpMat& R1 = dataProblem_.getStiffness();
+
+    std::vector<coeff> triplets;
+    triplets.reserve(int3.nonZeros() + 2*R1.nonZeros() + R0.nonZeros());
+    for (UInt k = 0; k < int3.outerSize(); ++k)
+        for (SpMat::InnerIterator it(int3, k); it; ++it)
+            triplets.emplace_back(it.row(), it.col(), it.value());
+    for (UInt k = 0; k < R1.outerSize(); ++k)
+        for (SpMat::InnerIterator it(R1, k); it; ++it){
+            triplets.emplace_back(N + it.row(), it.col(), c*it.value());
+            triplets.emplace_back(it.col(), N + it.row(), c*it.value());
+        }
+    for (UInt k = 0; k < R0.outerSize(); ++k)
+        for (SpMat::InnerIterator it(R0, k); it; ++it)
+            triplets.emplace_back(N + it.row(), N + it.col(), -it.value());
+
+    SpMat K(2*N, 2*N);
+    K.setFromTriplets(triplets.begin(), triplets.end());
+
+    VectorXr K_inv_diag;
+    if(!inverseDiagonal(K, K_inv_diag)){
+        Rprintf("WARNING: the factorization of the Hessian failed, the confidence bounds are not computed.\n");
+        K_inv_diag = VectorXr::Constant(2*N, std::numeric_limits<Real>::quiet_NaN());
+    }
+
+    VectorXr v_g = (2/n) * K_inv_diag.head(N);
     VectorXr g_L = VectorXr::Zero(g.size());
     VectorXr g_U = VectorXr::Zero(g.size());
     for (UInt i = 0; i < v_g.size() ; ++i) {
@@ -132,50 +168,10 @@ FunctionalProblem<ORDER, mydim, ndim>::computeCovariance_CI(const VectorXr& g, R
 template<UInt ORDER, UInt mydim, UInt ndim>
 std::pair<Real, VectorXr>
 FunctionalProblem_time<ORDER, mydim, ndim>::computeIntegrals(const VectorXr& g) const{
-    // Kronecker product of the Gauss quadrature rules weights
-    VectorXr weights_kronecker;
-    weights_kronecker.resize(Integrator::NNODES * Integrator_t::NNODES);
-    UInt k = 0;
-    for (UInt i = 0;  i < Integrator_t::NNODES; ++i) {
-        for (UInt j = 0;  j < Integrator::NNODES; ++j){
-            weights_kronecker[k] = Integrator::WEIGHTS[j]*Integrator_t::WEIGHTS[i];
-            ++k;
-        }
-    }
-
-    // Initialization
-    Real int1 = 0.;
-    VectorXr int2 = VectorXr::Zero(dataProblem_time_.getNumNodes()*dataProblem_time_.getSplineNumber());
-    const MatrixXr& PsiQuad = dataProblem_time_.getPsiQuad(); // PsiQuad is the same matrix at any time interval
-    for (int time_step = 0; time_step < dataProblem_time_.getNumNodes_time()-1;  ++time_step) {
-        MatrixXr PhiQuad = dataProblem_time_.fillPhiQuad(time_step); //PhiQuad changes at each time interval
-        MatrixXr Phi_kronecker_Psi = kroneckerProduct_Matrix(PhiQuad, PsiQuad);
-        for(UInt triangle = 0; triangle < dataProblem_time_.getNumElements(); ++triangle) {
-            Element<EL_NNODES, mydim, ndim> tri_activated = dataProblem_time_.getElement(triangle);
-//// (1) -------------------------------------------------
-            VectorXr sub_g;
-            sub_g.resize(Phi_kronecker_Psi.cols());
-            UInt k=0; // Index for sub_g
-            for (int j = time_step; j < time_step+PhiQuad.cols(); ++j) {
-                for (UInt i = 0; i < PsiQuad.cols(); ++i){
-                    sub_g[k++] = g[tri_activated[i].getId() + dataProblem_time_.getNumNodes()*j];
-                }
-            }
+    // int1 = integral of exp(g), int2 = its gradient, both computed by the space-time kernel of the data problem
+    VectorXr int2;
+    Real int1 = dataProblem_time_.FEintegrate_exponential_time(g, &int2);
 
-            VectorXr expg = (Phi_kronecker_Psi*sub_g).array().exp();
-            int1 += expg.dot(weights_kronecker.transpose()) * tri_activated.getMeasure() * (dataProblem_time_.getMesh_time()[time_step+1]-dataProblem_time_.getMesh_time()[time_step])/2;
-//// (2) -------------------------------------------------
-            VectorXr sub_int2;
-            sub_int2 = Phi_kronecker_Psi.transpose() *
-                       expg.cwiseProduct(weights_kronecker) * tri_activated.getMeasure() * (dataProblem_time_.getMesh_time()[time_step+1]-dataProblem_time_.getMesh_time()[time_step])/2;
-            k=0;
-            for (int j = time_step; j < time_step+PhiQuad.cols(); ++j) {
-                for (UInt i = 0; i < PsiQuad.cols(); ++i){
-                    int2[tri_activated[i].getId()+dataProblem_time_.getNumNodes()*j] += sub_int2[k++];
-                }
-            }
-        }
-    }
     return std::pair<Real, VectorXr> (int1, int2);
 }
 
@@ -198,7 +194,7 @@ FunctionalProblem_time<ORDER, mydim, ndim>::computellikLaplacian(const VectorXr&
 
     UInt global_idx = 0; //index that keeps track of the first B-spline basis function active in the current time-interval
     for (int time_step = 0; time_step < dataProblem_time_.getNumNodes_time()-1;  ++time_step) {
-        MatrixXr PhiQuad = dataProblem_time_.fillPhiQuad(time_step); //PhiQuad changes at each time interval
+        const MatrixXr& PhiQuad = dataProblem_time_.getPhiQuad(time_step); //PhiQuad changes at each time interval
         MatrixXr Phi_kronecker_Psi = kroneckerProduct_Matrix(PhiQuad,PsiQuad);
         for (UInt triangle = 0; triangle < dataProblem_time_.getNumElements(); triangle++) {
             Element<EL_NNODES, mydim, ndim> tri_activated = dataProblem_time_.getElement(triangle);
@@ -244,12 +240,20 @@ template<UInt ORDER, UInt mydim, UInt ndim>
 std::tuple<Real, VectorXr, Real, Real, Real>
 FunctionalProblem_time<ORDER, mydim, ndim>::computeFunctional_g(const VectorXr& g, Real lambda_S, Real lambda_T,
                                                                 const SpMat& Upsilon) const {
+
+    return computeFunctional_g(g, lambda_S, lambda_T, VectorXr(Upsilon.transpose()*VectorXr::Ones(Upsilon.rows())), Upsilon.rows());
+}
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+std::tuple<Real, VectorXr, Real, Real, Real>
+FunctionalProblem_time<ORDER, mydim, ndim>::computeFunctional_g(const VectorXr& g, Real lambda_S, Real lambda_T,
+                                                                const VectorXr& upsilon_sum, UInt n) const {
     Real int1 = 0;
     VectorXr int2;
     std::tie(int1,int2) = computeIntegrals(g);
 
-    const UInt n = Upsilon.rows();
-    const Real llik = -(Upsilon*g).sum() + n * int1;
+    // sum_i (Upsilon*g)_i = (Upsilon^T*1)^T*g
+    const Real llik = -upsilon_sum.dot(g) + n * int1;
 
     const SpMat K1 = dataProblem_time_.computePen_s();
     const SpMat K2 = dataProblem_time_.computePen_t();
@@ -257,7 +261,7 @@ FunctionalProblem_time<ORDER, mydim, ndim>::computeFunctional_g(const VectorXr&
     const Real pen_S = g.dot(K1 * g);
     const Real pen_T = g.dot(K2 * g);
 
-    VectorXr grad1 = - VectorXr::Constant(n,1).transpose()*Upsilon;
+    VectorXr grad1 = - upsilon_sum;
     VectorXr grad2 = n * int2;
 
     VectorXr grad3_S = 2*g.transpose() * K1;
@@ -29,8 +29,15 @@ class MinimizationAlgorithm{
     MinimizationAlgorithm(const MinimizationAlgorithm<ORDER, mydim, ndim>& rhs);
     //! A pure virtual clone method.
     virtual std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> clone() const = 0;
-    //! A pure virtual method to perform the minimization task.
-    virtual VectorXr apply_core(const SpMat& Psi, Real lambda, const VectorXr& g) const = 0;
+    //! A method to perform the minimization task on the data whose basis evaluations are the rows of Psi, without printing its failure.
+    VectorXr apply_core(const SpMat& Psi, Real lambda, const VectorXr& g, bool& failed) const
+      {return apply_core(Psi.transpose()*VectorXr::Ones(Psi.rows()), Psi.rows(), lambda, g, failed);}
+    //! A method to perform the minimization task, printing an error if it fails (to be called by the master thread only).
+    VectorXr apply_core(const VectorXr& psi_sum, UInt n, Real lambda, const VectorXr& g) const;
+    //! A pure virtual method to perform the minimization task: the n data enter the functional only through psi_sum = Psi^T*1.
+    //! failed is set to true if the loss function increases for all the step proposals (the null function is then returned). The failure
+    //! is not printed, since the cross-validation tasks run in parallel: the caller reports it from the master thread.
+    virtual VectorXr apply_core(const VectorXr& psi_sum, UInt n, Real lambda, const VectorXr& g, bool& failed) const = 0;
 
 };
 
@@ -49,8 +56,9 @@ class FixedStep : public MinimizationAlgorithm<ORDER, mydim, ndim>{
       MinimizationAlgorithm<ORDER, mydim, ndim>(rhs){};
     //! Clone method overridden.
     std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> clone() const override;
+    using MinimizationAlgorithm<ORDER, mydim, ndim>::apply_core;
     //! A method to perform the minimization algorithm when the step parameter is fixed among all the iterations.
-    VectorXr apply_core(const SpMat& Psi, Real lambda, const VectorXr& g) const override;
+    VectorXr apply_core(const VectorXr& psi_sum, UInt n, Real lambda, const VectorXr& g, bool& failed) const override;
 
 };
 
@@ -64,7 +72,7 @@ class AdaptiveStep : public MinimizationAlgorithm<ORDER, mydim, ndim>{
       MinimizationAlgorithm<ORDER, mydim, ndim>(rhs){};
     //! A pure virtual method to compute the step.
     virtual Real computeStep (const VectorXr& g,  Real loss, const VectorXr& grad, const VectorXr& dir, Real lambda,
-                              const SpMat& Psi) const = 0;
+                              const VectorXr& psi_sum, UInt n) const = 0;
 
   public:
     //! A delegating constructor.
@@ -73,8 +81,9 @@ class AdaptiveStep : public MinimizationAlgorithm<ORDER, mydim, ndim>{
       MinimizationAlgorithm<ORDER, mydim, ndim>(dp, fp, d){};
     //! A pure virtual clone method.
     virtual std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> clone() const override = 0;
+    using MinimizationAlgorithm<ORDER, mydim, ndim>::apply_core;
     //! A method to perform the minimization algorithm when the step is computed for each iteration.
-    VectorXr apply_core(const SpMat& Psi, Real lambda, const VectorXr& g) const override;
+    VectorXr apply_core(const VectorXr& psi_sum, UInt n, Real lambda, const VectorXr& g, bool& failed) const override;
 
 };
 
@@ -85,7 +94,7 @@ class BacktrackingMethod : public AdaptiveStep<ORDER, mydim, ndim>{
   private:
     //! A method to compute the step using the Backtracking Method.
     Real computeStep(const VectorXr& g, Real loss, const VectorXr& grad, const VectorXr& dir, Real lambda,
-                     const SpMat& Psi) const override;
+                     const VectorXr& psi_sum, UInt n) const override;
   public:
     //! A delegating constructor.
     BacktrackingMethod(const DataProblem<ORDER, mydim, ndim>& dp, const FunctionalProblem<ORDER, mydim, ndim>& fp,
@@ -107,7 +116,7 @@ class WolfeMethod : public AdaptiveStep<ORDER, mydim, ndim>{
   private:
     //! A method to compute the step using the Wolfe Method.
     Real computeStep(const VectorXr& g, Real loss, const VectorXr& grad, const VectorXr& dir, Real lambda,
-                     const SpMat& Psi) const override;
+                     const VectorXr& psi_sum, UInt n) const override;
   public:
     //! A delegating constructor.
     WolfeMethod(const DataProblem<ORDER, mydim, ndim>& dp, const FunctionalProblem<ORDER, mydim, ndim>& fp,
@@ -180,7 +189,7 @@ protected:
       MinimizationAlgorithm_time<ORDER, mydim, ndim>(rhs){};
     //! A pure virtual method to compute the step.
     virtual Real computeStep (const VectorXr& g,  Real loss, const VectorXr& grad, const VectorXr& dir, Real lambda_S,
-                              Real lambda_T, const SpMat& Upsilon) const = 0;
+                              Real lambda_T, const VectorXr& upsilon_sum, UInt n) const = 0;
 
 public:
     //! A delegating constructor.
@@ -201,7 +210,7 @@ class BacktrackingMethod_time : public AdaptiveStep_time<ORDER, mydim, ndim>{
 private:
     //! A method to compute the step using the Backtracking Method.
     Real computeStep(const VectorXr& g, Real loss, const VectorXr& grad, const VectorXr& dir, Real lambda_S, Real lambda_T,
-                     const SpMat& Upsilon) const override;
+                     const VectorXr& upsilon_sum, UInt n) const override;
 public:
     //! A delegating constructor.
     BacktrackingMethod_time(const DataProblem_time<ORDER, mydim, ndim>& dp,
@@ -224,7 +233,7 @@ class WolfeMethod_time : public AdaptiveStep_time<ORDER, mydim, ndim>{
 private:
     //! A method to compute the step using the Wolfe Method.
     Real computeStep(const VectorXr& g, Real loss, const VectorXr& grad, const VectorXr& dir, Real lambda_S, Real lambda_T,
-                     const SpMat& Upsilon) const override;
+                     const VectorXr& upsilon_sum, UInt n) const override;
 public:
     //! A delegating constructor.
     WolfeMethod_time(const DataProblem_time<ORDER, mydim, ndim>& dp,
@@ -24,6 +24,22 @@ MinimizationAlgorithm<ORDER, mydim, ndim>::MinimizationAlgorithm(const Minimizat
 };
 
 
+template<UInt ORDER, UInt mydim, UInt ndim>
+VectorXr MinimizationAlgorithm<ORDER, mydim, ndim>::apply_core(const VectorXr& psi_sum, UInt n, Real lambda, const VectorXr& g) const
+{
+
+    bool failed = false;
+    VectorXr sol = apply_core(psi_sum, n, lambda, g, failed);
+
+    if(failed){
+        Rprintf("ERROR: The loss function increases: not good. Try decreasing the optimization parameter.\n");
+    }
+
+    return sol;
+
+}
+
+
 template<UInt ORDER, UInt mydim, UInt ndim>
 std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> FixedStep<ORDER, mydim, ndim>::clone() const
 {
@@ -34,9 +50,11 @@ std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> FixedStep<ORDER, mydi
 
 
 template<UInt ORDER, UInt mydim, UInt ndim>
-VectorXr FixedStep<ORDER,mydim,ndim>::apply_core(const SpMat& Psi, Real lambda, const VectorXr& g) const
+VectorXr FixedStep<ORDER,mydim,ndim>::apply_core(const VectorXr& psi_sum, UInt n, Real lambda, const VectorXr& g, bool& failed) const
 {
 
+    failed = false;
+
     // Termination criteria variables
     const Real toll1 = this->dataProblem_.getTol1(), toll2 = this->dataProblem_.getTol2();
     Real norm_grad, dloss = toll1+1, dllik = toll1+1, dpen = toll1+1;
@@ -49,12 +67,14 @@ VectorXr FixedStep<ORDER,mydim,ndim>::apply_core(const SpMat& Psi, Real lambda,
     Real loss, loss_old, llik, llik_old, pen, pen_old;
     UInt i;
 
+    this->direction_->setProblem(lambda, n);
+
     for(UInt e = 0; e < this->dataProblem_.getNstepProposals(); ++e)
     {
         // Start always with the initial point
         g_curr = g;
 
-        std::tie(loss, grad, llik, pen) = this->funcProblem_.computeFunctional_g(g_curr, lambda, Psi);
+        std::tie(loss, grad, llik, pen) = this->funcProblem_.computeFunctional_g(g_curr, lambda, psi_sum, n);
         norm_grad = std::sqrt(grad.dot(grad));
 
         if(this->dataProblem_.Print()){
@@ -75,7 +95,7 @@ VectorXr FixedStep<ORDER,mydim,ndim>::apply_core(const SpMat& Psi, Real lambda,
             g_curr = g_curr + this->dataProblem_.getStepProposals(e)*d;
 
             // Update termination criteria variables
-            std::tie(loss, grad, llik, pen) = this->funcProblem_.computeFunctional_g(g_curr, lambda, Psi);
+            std::tie(loss, grad, llik, pen) = this->funcProblem_.computeFunctional_g(g_curr, lambda, psi_sum, n);
             dloss = std::abs((loss - loss_old)/loss_old);
             dllik = std::abs((llik - llik_old)/llik_old);
             dpen = std::abs((pen - pen_old)/pen_old);
@@ -117,18 +137,20 @@ VectorXr FixedStep<ORDER,mydim,ndim>::apply_core(const SpMat& Psi, Real lambda,
         }
     }
 
-    // If you arrive here you don't have a good gradient parameter
-    Rprintf("ERROR: The loss function increases: not good. Try decreasing the optimization parameter.\n");
-    //std::abort();
+    // If you arrive here you don't have a good gradient parameter: the failure is reported by the caller
+    failed = true;
     return VectorXr::Constant(g.size(),0);
 
 }
 
 
 template<UInt ORDER, UInt mydim, UInt ndim>
-VectorXr AdaptiveStep<ORDER,mydim,ndim>::apply_core(const SpMat& Psi, Real lambda, const VectorXr& g) const
+VectorXr AdaptiveStep<ORDER,mydim,ndim>::apply_core(const VectorXr& psi_sum, UInt n, Real lambda, const VectorXr& g, bool& failed) const
 {
 
+    // The step is always acceptable: the minimization does not fail
+    failed = false;
+
     // Termination criteria variables
     const Real toll1 = this->dataProblem_.getTol1(), toll2 = this->dataProblem_.getTol2();
     Real norm_grad, dloss = toll1+1, dllik = toll1+1, dpen = toll1+1;
@@ -141,7 +163,9 @@ VectorXr AdaptiveStep<ORDER,mydim,ndim>::apply_core(const SpMat& Psi, Real lambd
     Real loss, loss_old, llik, llik_old, pen, pen_old, step;
     UInt i;
 
-    std::tie(loss, grad, llik, pen) = this->funcProblem_.computeFunctional_g(g_curr, lambda, Psi);
+    this->direction_->setProblem(lambda, n);
+
+    std::tie(loss, grad, llik, pen) = this->funcProblem_.computeFunctional_g(g_curr, lambda, psi_sum, n);
     norm_grad = std::sqrt(grad.dot(grad));
 
     if(this->dataProblem_.Print()) {
@@ -159,13 +183,13 @@ VectorXr AdaptiveStep<ORDER,mydim,ndim>::apply_core(const SpMat& Psi, Real lambd
         d = this->direction_->computeDirection(g_curr, grad);
 
         // Compute a step
-        step = computeStep(g_curr, loss, grad, d, lambda, Psi);
+        step = computeStep(g_curr, loss, grad, d, lambda, psi_sum, n);
 
         // Update the point
         g_curr = g_curr + step*d;
 
         // Update termination criteria variables
-        std::tie(loss, grad, llik, pen) = this->funcProblem_.computeFunctional_g(g_curr, lambda, Psi);
+        std::tie(loss, grad, llik, pen) = this->funcProblem_.computeFunctional_g(g_curr, lambda, psi_sum, n);
         dloss = std::abs((loss - loss_old)/loss_old);
         dllik = std::abs((llik - llik_old)/llik_old);
         dpen = std::abs((pen - pen_old)/pen_old);
@@ -202,7 +226,7 @@ VectorXr AdaptiveStep<ORDER,mydim,ndim>::apply_core(const SpMat& Psi, Real lambd
 
 template<UInt ORDER, UInt mydim, UInt ndim>
 Real BacktrackingMethod<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real loss, const VectorXr& grad,
-                                                       const VectorXr& dir, Real lambda, const SpMat& Psi) const
+                                                       const VectorXr& dir, Real lambda, const VectorXr& psi_sum, UInt n) const
 {
 
     Real ro = 0.5, alpha = 1/ro, c = 0.5;
@@ -222,7 +246,7 @@ Real BacktrackingMethod<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real l
         new_point = g + alpha*dir;
 
         // Functional in the new point
-        std::tie(loss_new, grad_new, llik_new, pen_new) = this->funcProblem_.computeFunctional_g(new_point, lambda, Psi);
+        std::tie(loss_new, grad_new, llik_new, pen_new) = this->funcProblem_.computeFunctional_g(new_point, lambda, psi_sum, n);
 
     } while(loss_new > (loss + slope));
 
@@ -241,7 +265,7 @@ std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> BacktrackingMethod<OR
 
 template<UInt ORDER, UInt mydim, UInt ndim>
 Real WolfeMethod<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real loss, const VectorXr& grad, const VectorXr& dir,
-                                                Real lambda, const SpMat& Psi) const
+                                                Real lambda, const VectorXr& psi_sum, UInt n) const
 {
 
     Real alpha = 1, alphamax = 0, alphamin = 0, c1 = 1e-4, c2 = 0.9;
@@ -256,7 +280,7 @@ Real WolfeMethod<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real loss, co
     new_point = g + alpha*dir;
 
     // Functional in the new point
-    std::tie(loss_new, grad_new, llik_new, pen_new) = this->funcProblem_.computeFunctional_g(new_point, lambda, Psi);
+    std::tie(loss_new, grad_new, llik_new, pen_new) = this->funcProblem_.computeFunctional_g(new_point, lambda, psi_sum, n);
 
     bool again = true;
 
@@ -271,7 +295,7 @@ Real WolfeMethod<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real loss, co
 
             // Try with the new point
             new_point = g + alpha*dir;
-            std::tie(loss_new, grad_new, llik_new, pen_new) = this->funcProblem_.computeFunctional_g(new_point, lambda, Psi);
+            std::tie(loss_new, grad_new, llik_new, pen_new) = this->funcProblem_.computeFunctional_g(new_point, lambda, psi_sum, n);
             slope = c1*alpha*grad_dir;
         }
 
@@ -285,7 +309,7 @@ Real WolfeMethod<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real loss, co
 
             // Try with the new point
             new_point = g + alpha*dir;
-            std::tie(loss_new, grad_new, llik_new, pen_new) = this->funcProblem_.computeFunctional_g(new_point, lambda, Psi);
+            std::tie(loss_new, grad_new, llik_new, pen_new) = this->funcProblem_.computeFunctional_g(new_point, lambda, psi_sum, n);
             slope =  alpha*c1*grad_dir;
         }
     }
@@ -349,11 +373,15 @@ FixedStep_time<ORDER,mydim,ndim>::apply_core(const SpMat& Upsilon, Real lambda_S
     Real loss, loss_old, llik, llik_old, pen_S, pen_T, pen_old_S, pen_old_T;
     UInt i;
 
+    // The data enter the functional only through Upsilon^T*1 and their number: Upsilon is reduced once, instead of at each evaluation
+    const UInt n = Upsilon.rows();
+    const VectorXr upsilon_sum = Upsilon.transpose()*VectorXr::Ones(n);
+
     for(UInt e = 0; e < this->dataProblem_.getNstepProposals(); ++e) {
         // Start always with the initial point
         g_curr = g;
 
-        std::tie(loss, grad, llik, pen_S, pen_T) = this->funcProblem_.computeFunctional_g(g_curr, lambda_S, lambda_T, Upsilon);
+        std::tie(loss, grad, llik, pen_S, pen_T) = this->funcProblem_.computeFunctional_g(g_curr, lambda_S, lambda_T, upsilon_sum, n);
         norm_grad = std::sqrt(grad.dot(grad));
 
         if(this->dataProblem_.Print()){
@@ -375,7 +403,7 @@ FixedStep_time<ORDER,mydim,ndim>::apply_core(const SpMat& Upsilon, Real lambda_S
             g_curr = g_curr + this->dataProblem_.getStepProposals(e)*d;
 
             // Update termination criteria variables
-            std::tie(loss, grad, llik, pen_S, pen_T) = this->funcProblem_.computeFunctional_g(g_curr, lambda_S, lambda_T, Upsilon);
+            std::tie(loss, grad, llik, pen_S, pen_T) = this->funcProblem_.computeFunctional_g(g_curr, lambda_S, lambda_T, upsilon_sum, n);
             dloss = std::abs((loss - loss_old)/loss_old);
             dllik = std::abs((llik - llik_old)/llik_old);
             dpen_S = std::abs((pen_S - pen_old_S)/pen_old_S);
@@ -442,7 +470,11 @@ VectorXr AdaptiveStep_time<ORDER,mydim,ndim>::apply_core(const SpMat& Upsilon, R
     Real loss, loss_old, llik, llik_old, pen_S, pen_T, pen_old_S, pen_old_T, step;
     UInt i;
 
-    std::tie(loss, grad, llik, pen_S, pen_T) = this->funcProblem_.computeFunctional_g(g_curr, lambda_S, lambda_T, Upsilon);
+    // The data enter the functional only through Upsilon^T*1 and their number: Upsilon is reduced once, instead of at each evaluation
+    const UInt n = Upsilon.rows();
+    const VectorXr upsilon_sum = Upsilon.transpose()*VectorXr::Ones(n);
+
+    std::tie(loss, grad, llik, pen_S, pen_T) = this->funcProblem_.computeFunctional_g(g_curr, lambda_S, lambda_T, upsilon_sum, n);
     norm_grad = std::sqrt(grad.dot(grad));
 
     if(this->dataProblem_.Print()) {
@@ -461,13 +493,13 @@ VectorXr AdaptiveStep_time<ORDER,mydim,ndim>::apply_core(const SpMat& Upsilon, R
         d = this->direction_->computeDirection(g_curr, grad);
 
         // Compute a step
-        step = computeStep(g_curr, loss, grad, d, lambda_S, lambda_T, Upsilon);
+        step = computeStep(g_curr, loss, grad, d, lambda_S, lambda_T, upsilon_sum, n);
 
         // Update the point
         g_curr = g_curr + step*d;
 
         // Update termination criteria variables
-        std::tie(loss, grad, llik, pen_S, pen_T) = this->funcProblem_.computeFunctional_g(g_curr, lambda_S, lambda_T, Upsilon);
+        std::tie(loss, grad, llik, pen_S, pen_T) = this->funcProblem_.computeFunctional_g(g_curr, lambda_S, lambda_T, upsilon_sum, n);
         dloss = std::abs((loss - loss_old)/loss_old);
         dllik = std::abs((llik - llik_old)/llik_old);
         dpen_S = std::abs((pen_S - pen_old_S)/pen_old_S);
@@ -506,7 +538,7 @@ template<UInt ORDER, UInt mydim, UInt ndim>
 Real
 BacktrackingMethod_time<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real loss, const VectorXr& grad,
                                                        const VectorXr& dir, Real lambda_S, Real lambda_T,
-                                                       const SpMat& Upsilon) const
+                                                       const VectorXr& upsilon_sum, UInt n) const
 {
 
     Real ro = 0.5, alpha = 1/ro, c = 0.5;
@@ -526,7 +558,7 @@ BacktrackingMethod_time<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real l
         new_point = g + alpha*dir;
 
         // Functional in the new point
-        std::tie(loss_new, grad_new, llik_new, pen_new_S, pen_new_T) = this->funcProblem_.computeFunctional_g(new_point, lambda_S, lambda_T, Upsilon);
+        std::tie(loss_new, grad_new, llik_new, pen_new_S, pen_new_T) = this->funcProblem_.computeFunctional_g(new_point, lambda_S, lambda_T, upsilon_sum, n);
 
     } while(loss_new > (loss + slope));
 
@@ -544,7 +576,7 @@ std::unique_ptr<MinimizationAlgorithm_time<ORDER, mydim, ndim>> BacktrackingMeth
 
 template<UInt ORDER, UInt mydim, UInt ndim>
 Real WolfeMethod_time<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real loss, const VectorXr& grad, const VectorXr& dir,
-                                                     Real lambda_S, Real lambda_T, const SpMat& Upsilon) const
+                                                     Real lambda_S, Real lambda_T, const VectorXr& upsilon_sum, UInt n) const
 {
 
     Real alpha = 1, alphamax = 0, alphamin = 0, c1 = 1e-4, c2 = 0.9;
@@ -560,7 +592,7 @@ Real WolfeMethod_time<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real los
     new_point = g + alpha*dir;
 
     // Functional in the new point
-    std::tie(loss_new, grad_new, llik_new, pen_new_S, pen_new_T) = this->funcProblem_.computeFunctional_g(new_point, lambda_S, lambda_T, Upsilon);
+    std::tie(loss_new, grad_new, llik_new, pen_new_S, pen_new_T) = this->funcProblem_.computeFunctional_g(new_point, lambda_S, lambda_T, upsilon_sum, n);
 
     bool again = true;
 
@@ -575,7 +607,7 @@ Real WolfeMethod_time<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real los
 
             // Try with the new point
             new_point = g + alpha*dir;
-            std::tie(loss_new, grad_new, llik_new, pen_new_S, pen_new_T) = this->funcProblem_.computeFunctional_g(new_point, lambda_S, lambda_T, Upsilon);
+            std::tie(loss_new, grad_new, llik_new, pen_new_S, pen_new_T) = this->funcProblem_.computeFunctional_g(new_point, lambda_S, lambda_T, upsilon_sum, n);
             slope = c1*alpha*grad_dir;
         }
 
@@ -589,7 +621,7 @@ Real WolfeMethod_time<ORDER,mydim,ndim>::computeStep(const VectorXr& g, Real los
 
             // Try with the new point
             new_point = g + alpha*dir;
-            std::tie(loss_new, grad_new, llik_new, pen_new_S, pen_new_T) = this->funcProblem_.computeFunctional_g(new_point, lambda_S, lambda_T, Upsilon);
+            std::tie(loss_new, grad_new, llik_new, pen_new_S, pen_new_T) = this->funcProblem_.computeFunctional_g(new_point, lambda_S, lambda_T, upsilon_sum, n);
             slope =  alpha*c1*grad_dir;
         }
     }
@@ -74,11 +74,23 @@ class CrossValidation : public Preprocess<ORDER, mydim, ndim>{
     std::vector<Real> CV_errors_;
     // It contains the best g-function obtained with cross validation for each lambda
     std::vector<VectorXr> g_sols_;
+    // It contains the error of each fold (rows) for each lambda (columns), summed in the order of the folds into CV_errors_
+    MatrixXr fold_errors_;
+    // It saves the best loss reached, among all the folds, for each lambda, and the fold which reached it
+    std::vector<Real> best_loss_;
+    std::vector<UInt> best_fold_;
 
-    //! A method to perform k-fold cross validation.
+    //! A method to perform k-fold cross validation. The pairs (fold, lambda) are independent tasks, run in parallel (unless Print() is
+    //! true, R output being allowed only from the main thread): their results are collected so that they do not depend on the order of completion,
+    //! and the failures of their minimizations are printed by the main thread after the loop.
     std::pair<VectorXr, Real> performCV();
-    //! A pure virtual method to perform the core task of k-fold cross validation.
-    virtual void performCV_core (UInt fold, const SpMat& Psi_train, const SpMat& Psi_valid) = 0;
+    //! A pure virtual method saying whether the lambda of index lambda_index has to be tried on the fold.
+    virtual bool isTask(UInt fold, UInt lambda_index) const = 0;
+    //! A pure virtual method to perform the core task of k-fold cross validation, for a fold and a lambda. It is called concurrently,
+    //! so it does not print: it returns true if the minimization failed.
+    virtual bool performCV_core (UInt fold, UInt lambda_index, const SpMat& Psi_train, const SpMat& Psi_valid) = 0;
+    //! A method to store the solution of a fold for a lambda, with its validation error and its training loss (thread safe).
+    void storeSolution(UInt fold, UInt lambda_index, const VectorXr& sol, Real error, Real loss);
 
   public:
     //! A constructor.
@@ -99,8 +111,10 @@ class CrossValidation : public Preprocess<ORDER, mydim, ndim>{
 template<UInt ORDER, UInt mydim, UInt ndim>
 class SimplifiedCrossValidation : public CrossValidation<ORDER, mydim, ndim>{
   private:
+    //! Overridden method: each fold has its own lambda.
+    bool isTask(UInt fold, UInt lambda_index) const override {return fold == lambda_index;}
     //! Overridden method to perform simplified cross-validation.
-    void performCV_core (UInt fold, const SpMat& Psi_train, const SpMat& Psi_valid) override;
+    bool performCV_core (UInt fold, UInt lambda_index, const SpMat& Psi_train, const SpMat& Psi_valid) override;
 
   public:
     //! A delegating constructor.
@@ -116,17 +130,17 @@ class SimplifiedCrossValidation : public CrossValidation<ORDER, mydim, ndim>{
 template<UInt ORDER, UInt mydim, UInt ndim>
 class RightCrossValidation : public CrossValidation<ORDER, mydim, ndim>{
   private:
-    // It saves the best loss reached, among all the folds, for each lambda
-    std::vector<Real> best_loss_;
-
+    //! Overridden method: every lambda is tried on every fold.
+    bool isTask(UInt, UInt) const override {return true;}
     //! Overridden method to perform right cross-validation.
-    void performCV_core (UInt fold, const SpMat& Psi_train, const SpMat& Psi_valid) override;
+    bool performCV_core (UInt fold, UInt lambda_index, const SpMat& Psi_train, const SpMat& Psi_valid) override;
 
   public:
-    //! A constructor
+    //! A delegating constructor
     RightCrossValidation(const DataProblem<ORDER, mydim, ndim>& dp,
        const FunctionalProblem<ORDER, mydim, ndim>& fp,
-       std::shared_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> ma);
+       std::shared_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> ma):
+       CrossValidation<ORDER, mydim, ndim>(dp, fp, ma){};
 
 };
 
@@ -45,6 +45,9 @@ CrossValidation<ORDER, mydim, ndim>::CrossValidation(const DataProblem<ORDER, my
     K_folds_.resize(dp.dataSize());
     CV_errors_.resize(dp.getNlambda(), 0);
     g_sols_.resize(dp.getNlambda());
+    fold_errors_ = MatrixXr::Zero(dp.getNfolds(), dp.getNlambda());
+    best_loss_.resize(dp.getNlambda(), std::numeric_limits<Real>::infinity());
+    best_fold_.resize(dp.getNlambda(), dp.getNfolds());
 
 }
 
@@ -61,12 +64,10 @@ std::pair<VectorXr, Real> CrossValidation<ORDER, mydim, ndim>::performCV()
         K_folds_[length + i/K] = i;
     }
 
-    // Cycle on the folds
-    for (UInt i = 0; i < K; ++i){
+    // Training and validation matrices of each fold
+    std::vector<SpMat> Psi_train(K), Psi_valid(K);
 
-        if(this->dataProblem_.Print()) {
-            Rprintf("X_valid is the fold number %d\n", i);
-        }
+    for (UInt i = 0; i < K; ++i){
 
         std::vector<UInt> x_valid, x_train;
 
@@ -79,13 +80,45 @@ std::pair<VectorXr, Real> CrossValidation<ORDER, mydim, ndim>::performCV()
             std::copy(K_folds_.cbegin()+ (N % K) + i*(N/K), K_folds_.cbegin()+ (N % K) + (i+1)*(N/K), std::back_inserter(x_valid));
         }
 
-        SpMat Psi_train = this->dataProblem_.computePsi(x_train);
-        SpMat Psi_valid = this->dataProblem_.computePsi(x_valid);
+        Psi_train[i] = this->dataProblem_.computePsi(x_train);
+        Psi_valid[i] = this->dataProblem_.computePsi(x_valid);
 
-        performCV_core(i, Psi_train, Psi_valid); // It fills g_sols, CV_errors_
+    }
+
+    // Cycle on the pairs (fold, lambda)
+    std::vector<std::pair<UInt, UInt>> tasks;
+    for (UInt i = 0; i < K; ++i)
+        for (UInt l = 0; l < this->dataProblem_.getNlambda(); ++l)
+            if(isTask(i, l))
+                tasks.emplace_back(i, l);
+
+    const bool print = this->dataProblem_.Print();
+    const long int n_tasks = tasks.size();
+    std::vector<char> failed(n_tasks, 0);
+    #pragma omp parallel for schedule(dynamic) if(!print)
+    for (long int t = 0; t < n_tasks; ++t){
+
+        const UInt i = tasks[t].first;
+
+        if(print && (t == 0 || tasks[t-1].first != i)) {
+            Rprintf("X_valid is the fold number %d\n", i);
+        }
+
+        failed[t] = performCV_core(i, tasks[t].second, Psi_train[i], Psi_valid[i]); // It calls storeSolution
 
     }
 
+    // Failures reported by the main thread, in the order of the tasks
+    for (long int t = 0; t < n_tasks; ++t)
+        if(failed[t])
+            Rprintf("ERROR: The loss function increases for fold %d and lambda %f: not good. Try decreasing the optimization parameter.\n",
+                    tasks[t].first, this->dataProblem_.getLambda(tasks[t].second));
+
+    // Errors summed in the order of the folds
+    for (std::size_t l = 0; l < CV_errors_.size(); ++l)
+        for (UInt i = 0; i < K; ++i)
+            CV_errors_[l] += fold_errors_(i, l);
+
     UInt init_best_lambda = std::distance(CV_errors_.cbegin(), std::min_element(CV_errors_.cbegin(), CV_errors_.cend()));
 
     return std::pair<VectorXr, Real> (g_sols_[init_best_lambda], this->dataProblem_.getLambda(init_best_lambda));
@@ -93,6 +126,28 @@ std::pair<VectorXr, Real> CrossValidation<ORDER, mydim, ndim>::performCV()
 }
 
 
+template<UInt ORDER, UInt mydim, UInt ndim>
+void CrossValidation<ORDER, mydim, ndim>::storeSolution(UInt fold, UInt lambda_index, const VectorXr& sol, Real error, Real loss)
+{
+
+    // a nan loss is never preferred; ties are broken by the fold index, so that the result does not depend on the order of the tasks
+    if(std::isnan(loss)) loss = std::numeric_limits<Real>::infinity();
+
+    #pragma omp critical(fdaPDE_density_cv)
+    {
+        fold_errors_(fold, lambda_index) = error;
+
+        if(best_fold_[lambda_index] == this->dataProblem_.getNfolds() || loss < best_loss_[lambda_index] ||
+           (loss == best_loss_[lambda_index] && fold < best_fold_[lambda_index])) {
+            best_loss_[lambda_index] = loss;
+            best_fold_[lambda_index] = fold;
+            g_sols_[lambda_index] = sol;
+        }
+    }
+
+}
+
+
 template<UInt ORDER, UInt mydim, UInt ndim>
 void CrossValidation<ORDER, mydim, ndim>::performPreprocessTask()
 {
@@ -103,57 +158,47 @@ void CrossValidation<ORDER, mydim, ndim>::performPreprocessTask()
 
 
 template<UInt ORDER, UInt mydim, UInt ndim>
-void
-SimplifiedCrossValidation<ORDER, mydim, ndim>::performCV_core(UInt fold, const SpMat& Psi_train, const SpMat& Psi_valid)
+bool
+SimplifiedCrossValidation<ORDER, mydim, ndim>::performCV_core(UInt fold, UInt lambda_index, const SpMat& Psi_train, const SpMat& Psi_valid)
 {
 
     if(this->dataProblem_.Print()) {
-        Rprintf("lambda: %f\n", this->dataProblem_.getLambda(fold));
+        Rprintf("lambda: %f\n", this->dataProblem_.getLambda(lambda_index));
     }
 
-    this->g_sols_[fold] = this->minAlgo_->apply_core(Psi_train, this->dataProblem_.getLambda(fold), (*(this->fInit_[fold])).array().log());
-
-    this->CV_errors_[fold] = this->error_(Psi_valid, this->g_sols_[fold]);
+    // the clone keeps the state of the descent direction private to the task
+    std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> minimizationAlgo = this->minAlgo_->clone();
 
-}
+    bool failed = false;
+    VectorXr sols = minimizationAlgo->apply_core(Psi_train, this->dataProblem_.getLambda(lambda_index), (*(this->fInit_[lambda_index])).array().log(), failed);
 
+    this->storeSolution(fold, lambda_index, sols, this->error_(Psi_valid, sols), 0.);
 
-template<UInt ORDER, UInt mydim, UInt ndim>
-RightCrossValidation<ORDER, mydim, ndim>::RightCrossValidation(const DataProblem<ORDER, mydim, ndim>& dp,
-                                                               const FunctionalProblem<ORDER, mydim, ndim>& fp,
-                                                               std::shared_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> ma):
-  CrossValidation<ORDER, mydim, ndim>(dp, fp, ma){
-
-    best_loss_.resize(this->dataProblem_.getNlambda(), std::numeric_limits<double>::max());
+    return failed;
 
 }
 
 
 template<UInt ORDER, UInt mydim, UInt ndim>
-void RightCrossValidation<ORDER, mydim, ndim>::performCV_core(UInt fold, const SpMat& Psi_train, const SpMat& Psi_valid)
+bool RightCrossValidation<ORDER, mydim, ndim>::performCV_core(UInt fold, UInt lambda_index, const SpMat& Psi_train, const SpMat& Psi_valid)
 {
 
-    for (UInt l = 0; l < this->dataProblem_.getNlambda(); ++l) {
+    std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> minimizationAlgo = this->minAlgo_->clone();
 
-        std::unique_ptr<MinimizationAlgorithm<ORDER, mydim, ndim>> minimizationAlgo = this->minAlgo_->clone();
+    const Real lambda = this->dataProblem_.getLambda(lambda_index);
 
-        if(this->dataProblem_.Print()) {
-            Rprintf("lambda: %f\n", this->dataProblem_.getLambda(l));
-        }
-
-        VectorXr sols;
+    if(this->dataProblem_.Print()) {
+        Rprintf("lambda: %f\n", lambda);
+    }
 
-        sols = minimizationAlgo->apply_core(Psi_train, this->dataProblem_.getLambda(l), (*(this->fInit_[l])).array().log());
+    bool failed = false;
+    VectorXr sols = minimizationAlgo->apply_core(Psi_train, lambda, (*(this->fInit_[lambda_index])).array().log(), failed);
 
-        this->CV_errors_[l] += this->error_(Psi_valid, sols);
+    Real loss = std::get<0>(this->funcProblem_.computeFunctional_g(sols, lambda, Psi_train));
 
-        Real loss = std::get<0>(this->funcProblem_.computeFunctional_g(sols, this->dataProblem_.getLambda(l), Psi_train));
+    this->storeSolution(fold, lambda_index, sols, this->error_(Psi_valid, sols), loss);
 
-        if(loss < best_loss_[l]) {
-            best_loss_[l] = loss;
-            this->g_sols_[l] = sols;
-        }
-    }
+    return failed;
 
 }
 
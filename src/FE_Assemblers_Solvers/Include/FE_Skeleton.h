@@ -4,6 +4,8 @@
 #include "../../FdaPDE.h"
 #include "Projection.h"
 #include "../../Mesh/Include/Mesh.h"
+#include "../../Mesh/Include/Mesh_Archive.h"
+#include "../../Global_Utilities/Include/Binary_Archive.h"
 
 //! This function build the binary-tree object used in the tree search algorithm according to template the parameter.
 /*!
@@ -170,6 +172,55 @@ SEXP Eval_FEM_fd_skeleton(SEXP Rmesh, SEXP Rlocations, SEXP RincidenceMatrix, SE
 
 }
 
+//! This function evaluates a solution stored in a binary archive on given locations according to template parameters.
+/*!
+	This function is called from <eval_FEM_archive>"()" function. The mesh is used in place from the mapped archive.
+
+	\param reader the archive containing mesh, tree (if any) and coefficients of the solution
+	\param Rlocations an R-matrix containing the coordinates of the points where the solution has to be evaluated
+	\param Rfast an R integer to enforce verbose search for Walking Algorithm (can miss location for non convex meshes)
+ */
+template<UInt ORDER, UInt mydim, UInt ndim>
+SEXP Eval_FEM_archive_skeleton(const BinaryArchiveReader & reader, SEXP Rlocations, SEXP Rfast){
+
+    std::unique_ptr<MeshHandler<ORDER, mydim, ndim>> mesh = load_mesh<ORDER, mydim, ndim>(reader);
+    UInt n_coef = 0, n_sol = 0;
+    Real * coef_ptr = reader.getReal(BinaryArchive::Coefficients, n_coef, n_sol);
+
+    if(mesh == nullptr || coef_ptr == nullptr || n_coef != mesh->num_nodes()) {
+        Rprintf("ERROR: the archive does not contain a valid mesh and solution\n");
+        return(NILSXP);
+    }
+
+    RNumericMatrix locations(Rlocations);
+    if(locations.ncols() != ndim) {
+        Rprintf("ERROR: the locations must have %d columns, as the nodes of the archived mesh\n", ndim);
+        return(NILSXP);
+    }
+    UInt n_X = locations.nrows();
+    bool fast = INTEGER(Rfast)[0];
+
+    Evaluator<ORDER, mydim, ndim> evaluator(*mesh);
+    std::vector<bool> isinside(n_X);
+
+    SEXP result;
+    PROTECT(result=Rf_allocMatrix(REALSXP, n_X, n_sol));
+    for (UInt j = 0; j < n_sol; ++j) {
+        RNumericMatrix coef(coef_ptr + n_coef*j, n_coef, 1);
+        RNumericMatrix result_(REAL(result) + n_X*j, n_X, 1);
+        evaluator.eval(locations, coef, fast, result_, isinside);
+
+        for (UInt i = 0; i < n_X; ++i) {
+            if (!(isinside[i])) {
+                result_[i] = NA_REAL;
+            }
+        }
+    }
+
+    UNPROTECT(1);
+    return result;
+}
+
 //! This function evaluates the solution on a set of given points by evaluating the tensorial basis expansion.
 /*!
 	This function is then called from <eval_FEM_time>"()" function.
@@ -0,0 +1,19 @@
+#ifndef __SELECTED_INVERSION_H__
+#define __SELECTED_INVERSION_H__
+
+#include "../../FdaPDE.h"
+
+//! Diagonal of the inverse of a sparse symmetric matrix, computed without forming the inverse
+/*!
+ * The matrix is factorized as P*A*P^t = L*D*L^t, with a fill-reducing permutation P. The entries of Z = (P*A*P^t)^-1 on the sparsity
+ * pattern of L are then computed backwards, column by column, through the Takahashi recurrences
+ *   Z(i,j) = - sum_{k>j} Z(i,k)*L(k,j),   Z(j,j) = 1/D(j) - sum_{k>j} L(k,j)*Z(k,j),
+ * which only involve entries of Z on the same pattern, so that time and memory are of the order of the factorization.
+ * OBS: the matrix has to admit the LDL^t factorization without pivoting, e.g. it is symmetric positive definite or quasi-definite.
+ * \param A the matrix (only its lower triangular part is used)
+ * \param diag output: the diagonal of A^-1
+ * \return false if the factorization fails
+*/
+bool inverseDiagonal(const SpMat & A, VectorXr & diag);
+
+#endif
@@ -57,6 +57,44 @@ SEXP eval_FEM_fd(SEXP Rmesh, SEXP Rlocations, SEXP RincidenceMatrix, SEXP Rcoef,
     return NILSXP;
 }
 
+//! This function evaluates a solution stored in a binary archive (e.g. written by regression_session_save).
+/*!
+	This function is then called from R code. The archive is mapped in memory, mesh and tree are not rebuilt.
+
+	\param Rfilename an R string containing the path of the archive
+	\param Rlocations an R-matrix containing the coordinates of the points where the solution has to be evaluated
+	\param Rfast an R integer to enforce verbose search for Walking Algorithm (can miss location for non convex meshes)
+*/
+SEXP eval_FEM_archive(SEXP Rfilename, SEXP Rlocations, SEXP Rfast){
+
+    BinaryArchiveReader reader(CHAR(STRING_ELT(Rfilename, 0)));
+    UInt nrows = 0, ncols = 0;
+    const UInt * info = reader.isValid() ? reader.getInteger(BinaryArchive::MeshInfo, nrows, ncols) : nullptr;
+    if(info == nullptr || nrows < 3) {
+        Rprintf("ERROR: %s is not a valid archive\n", CHAR(STRING_ELT(Rfilename, 0)));
+        return NILSXP;
+    }
+
+    UInt order = info[0];
+    UInt mydim = info[1];
+    UInt ndim  = info[2];
+
+    if(order==1 && mydim==2 && ndim==2)
+        return Eval_FEM_archive_skeleton<1,2,2>(reader, Rlocations, Rfast);
+    else if(order==2 && mydim==2 && ndim==2)
+        return Eval_FEM_archive_skeleton<2,2,2>(reader, Rlocations, Rfast);
+    else if(order==1 && mydim==2 && ndim==3)
+        return Eval_FEM_archive_skeleton<1,2,3>(reader, Rlocations, Rfast);
+    else if(order==2 && mydim==2 && ndim==3)
+        return Eval_FEM_archive_skeleton<2,2,3>(reader, Rlocations, Rfast);
+    else if(order==1 && mydim==3 && ndim==3)
+        return Eval_FEM_archive_skeleton<1,3,3>(reader, Rlocations, Rfast);
+    else if(order==2 && mydim==3 && ndim==3)
+        return Eval_FEM_archive_skeleton<2,3,3>(reader, Rlocations, Rfast);
+
+    return NILSXP;
+}
+
 //! This function evaluates the solution on a set of given points by evaluating the tensorial basis expansion.
 /*!
 	This function is then called from R code.
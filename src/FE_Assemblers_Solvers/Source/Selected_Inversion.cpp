@@ -0,0 +1,64 @@
+#include "../Include/Selected_Inversion.h"
+#include <vector>
+
+bool inverseDiagonal(const SpMat & A, VectorXr & diag)
+{
+	Eigen::SimplicialLDLT<SpMat> ldlt(A);
+	if(ldlt.info() != Eigen::Success)
+		return false;
+
+	const UInt n = A.rows();
+	const VectorXr & D = ldlt.vectorD();
+
+	// strictly lower part of L in compressed columns, with sorted row indices; Z is stored on the same pattern
+	SpMat L = ldlt.matrixL();
+	std::vector<UInt> start(n+1, 0), rows;
+	std::vector<Real> values;
+	rows.reserve(L.nonZeros());
+	values.reserve(L.nonZeros());
+	for(UInt j=0; j<n; ++j)
+	{
+		for(SpMat::InnerIterator it(L, j); it; ++it)
+			if(it.row() > j)
+			{
+				rows.push_back(it.row());
+				values.push_back(it.value());
+			}
+		start[j+1] = rows.size();
+	}
+
+	std::vector<Real> Z(rows.size(), 0.);
+	VectorXr Zdiag(n);
+
+	for(UInt j=n; j-- > 0; )
+	{
+		const UInt first = start[j], last = start[j+1];
+		// Z(rows[a],j) = - sum_b Z(rows[a],rows[b])*L(rows[b],j): the entries Z(rows[a],rows[b]), rows[a]>rows[b], are read in column rows[b]
+		// of Z, which contains all the rows of column j greater than rows[b] (they form a clique of the filled graph), walking both sorted lists
+		for(UInt b=first; b<last; ++b)
+		{
+			const UInt rb = rows[b];
+			Z[b] -= Zdiag[rb]*values[b];
+			UInt k = start[rb];
+			for(UInt a=b+1; a<last; ++a)
+			{
+				while(rows[k] < rows[a])
+					++k;
+				Z[a] -= Z[k]*values[b];
+				Z[b] -= Z[k]*values[a];
+			}
+		}
+		Real z = 1/D[j];
+		for(UInt a=first; a<last; ++a)
+			z -= values[a]*Z[a];
+		Zdiag[j] = z;
+	}
+
+	// back to the original ordering: A^-1(i,i) = Z(p(i),p(i))
+	const auto & p = ldlt.permutationP().indices();
+	diag.resize(n);
+	for(UInt i=0; i<n; ++i)
+		diag[i] = Zdiag[p[i]];
+
+	return true;
+}
@@ -19,7 +19,7 @@ class  FPCAData{
 		//barycenter information
 		MatrixXr barycenters_; //barycenter information
 		VectorXi element_ids_; //elements id information
-		bool locations_by_barycenter_;
+		bool locations_by_barycenter_{};
 
 		//Design matrix
 		MatrixXr datamatrix_;
@@ -38,8 +38,8 @@ class  FPCAData{
 		UInt nFolds_;
 
 		//Parameters for better GCV timings
-		UInt GCVmethod_;
-		UInt nrealizations_;      // Number of relizations for the stochastic estimation of GCV
+		UInt GCVmethod_ = 2;		// Defaults of FPCA.FEM (stochastic GCV), not set by the constructor without R objects
+		UInt nrealizations_ = 100;      // Number of relizations for the stochastic estimation of GCV
 
 
 		std::vector<UInt> observations_indices_;
@@ -0,0 +1,111 @@
+#ifndef __BINARY_ARCHIVE_H__
+#define __BINARY_ARCHIVE_H__
+
+#include "../../FdaPDE.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//! Versioned binary archive used to store meshes, search trees and fitted models outside of R
+/*!
+  The file is made of:
+  - a header: magic string, format version, byte order mark and number of sections;
+  - a table of sections: tag, scalar type, number of rows and columns and offset of the payload;
+  - the payloads, stored column-major (as R matrices) and aligned to BinaryArchive::alignment bytes.
+  Since every payload is aligned and stored in the layout used by RNumericMatrix, RIntegerMatrix and the
+  compressed Eigen sparse matrices, a mapped file can be used in place, without copies.
+*/
+namespace BinaryArchive
+{
+  constexpr char magic[8] = {'F','D','A','P','D','E','B','A'};
+  constexpr std::uint32_t version = 1;
+  constexpr std::uint32_t byte_order_mark = 0x01020304;
+  constexpr std::uint64_t alignment = 64;
+
+  enum class ScalarType : std::uint32_t {Real = 0, Integer = 1};
+
+  //! Tags of the sections, new tags must be appended to keep older archives readable
+  enum Tag : std::uint32_t
+  {
+    MeshInfo = 1,		//!< Integer: ORDER, mydim, ndim, search
+    MeshNodes,			//!< Real: num_nodes x ndim
+    MeshSides,			//!< Integer: num_sides x mydim
+    MeshElements,		//!< Integer: num_elements x nodes per element
+    MeshNeighbors,		//!< Integer: num_elements x (mydim+1)
+    TreeInfo,			//!< Integer: tree_lev
+    TreeDomain,			//!< Real: 2*ndim x 2, origin and scaling factors of the tree domain
+    TreeIds,			//!< Integer: num_tree_nodes x 1
+    TreeChildren,		//!< Integer: num_tree_nodes x 2, left and right child
+    TreeBoxes,			//!< Real: num_tree_nodes x 2*ndim
+    Coefficients,		//!< Real: num_nodes x number of solutions
+    SystemInfo,			//!< Real: lambda used to build the system matrix
+    SystemOuter,		//!< Integer: (cols+1) x 1, outer index of the compressed system matrix
+    SystemInner,		//!< Integer: nnz x 1, inner index of the compressed system matrix
+    SystemValues		//!< Real: nnz x 1, values of the compressed system matrix
+  };
+}
+
+//! A class that collects the sections of an archive and writes them to file
+class BinaryArchiveWriter
+{
+public:
+  //! A method that adds a section of Reals, the data are copied
+  void addSection(std::uint32_t tag, const Real * data, UInt nrows, UInt ncols);
+  //! A method that adds a section of integers, the data are copied
+  void addSection(std::uint32_t tag, const UInt * data, UInt nrows, UInt ncols);
+  //! A method that writes the archive, it returns false if the file could not be written
+  bool write(const std::string & filename) const;
+
+private:
+  struct Section
+  {
+    std::uint32_t tag;
+    BinaryArchive::ScalarType type;
+    UInt nrows;
+    UInt ncols;
+    std::vector<char> payload;
+  };
+
+  std::vector<Section> sections_;
+};
+
+//! A class that maps an archive in memory (or reads it, where mmap is not available) and gives access to its sections
+class BinaryArchiveReader
+{
+public:
+  //! A constructor, it maps the file; isValid() tells if the file is a readable archive
+  explicit BinaryArchiveReader(const std::string & filename);
+  ~BinaryArchiveReader();
+
+  BinaryArchiveReader(const BinaryArchiveReader &) = delete;
+  BinaryArchiveReader & operator=(const BinaryArchiveReader &) = delete;
+
+  bool isValid(void) const {return valid_;}
+  bool hasSection(std::uint32_t tag) const {return findSection(tag) != nullptr;}
+
+  //! Pointers to the payload inside the mapped file, nullptr if the section is missing, has a different type or is corrupted
+  Real * getReal(std::uint32_t tag, UInt & nrows, UInt & ncols) const;
+  UInt * getInteger(std::uint32_t tag, UInt & nrows, UInt & ncols) const;
+
+private:
+  struct Entry
+  {
+    std::uint32_t tag;
+    std::uint32_t type;
+    std::uint64_t nrows;
+    std::uint64_t ncols;
+    std::uint64_t offset;
+  };
+
+  const Entry * findSection(std::uint32_t tag) const;
+  char * sectionData(const Entry & entry, std::uint64_t scalar_size) const;
+
+  char * data_ = nullptr;
+  std::uint64_t size_ = 0;
+  bool mapped_ = false;
+  std::vector<char> buffer_;	//!< Used when the file cannot be mapped
+  std::vector<Entry> table_;
+  bool valid_ = false;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef __INSTRUMENTATION_H__
+#define __INSTRUMENTATION_H__
+
+#include "../../FdaPDE.h"
+#include "Timing.h"
+#include <string>
+#include <vector>
+
+//! Registry of the time spent in the main phases of a fit and of some counters (number of solves, nonzeros, ...)
+/*!
+  A single registry is shared by the whole library: the R entry points reset it at the beginning of a call and
+  return its content as the last element of the output list. Phases and counters are kept in order of first use.
+  The registry is always compiled: its cost is a clock read per phase and a lookup in a few short vectors, which is
+  negligible with respect to the phases it measures. Updates are serialized, so that it can also be fed from the
+  OpenMP parallel regions (reads are serialized as well); in that case the times of the threads are summed up.
+*/
+class Instrumentation
+{
+public:
+  //! A method returning the registry shared by the library
+  static Instrumentation & get(void);
+
+  //! A method that clears all the phases and the counters
+  void reset(void);
+  //! A method adding seconds to the time spent in a phase and increasing the number of its calls
+  void addTime(const std::string & phase, Real seconds);
+  //! A method adding value to a counter
+  void addCount(const std::string & counter, Real value = 1.);
+  //! A method that overwrites the value of a counter (e.g. the size of the last factorization)
+  void setCount(const std::string & counter, Real value);
+  //! A method that overwrites the value of a counter if value is larger (e.g. the worst error of the calls)
+  void maxCount(const std::string & counter, Real value);
+
+  //! A method returning the time spent in a phase (0 if the phase has never been measured)
+  Real getTime(const std::string & phase) const;
+  //! A method returning the value of a counter (0 if it has never been set)
+  Real getCount(const std::string & counter) const;
+
+  //! A method that converts the registry in an R list: phase names, seconds, number of calls, counter names, counter values
+  SEXP toR(void) const;
+
+private:
+  Instrumentation() = default;
+
+  std::vector<std::string> phase_names_;
+  std::vector<Real> phase_seconds_;
+  std::vector<UInt> phase_calls_;
+  std::vector<std::string> counter_names_;
+  std::vector<Real> counter_values_;
+};
+
+//! RAII timer adding the time spent in its scope to a phase of the registry
+class ScopedPhase
+{
+public:
+  explicit ScopedPhase(const char * phase): phase_(phase) {timer_.start();}
+  ~ScopedPhase() {stop();}
+
+  //! A method that records the phase before the end of the scope (e.g. to report it in the same output it measures)
+  void stop(void)
+  {
+    if(stopped_)
+      return;
+    stopped_ = true;
+    const timespec elapsed = timer_.stop();
+    Instrumentation::get().addTime(phase_, elapsed.tv_sec + elapsed.tv_nsec*1e-9);
+  }
+
+  ScopedPhase(const ScopedPhase &) = delete;
+  ScopedPhase & operator=(const ScopedPhase &) = delete;
+
+private:
+  const char * phase_;
+  timer timer_;
+  bool stopped_ = false;
+};
+
+#endif
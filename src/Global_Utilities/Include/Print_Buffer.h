@@ -0,0 +1,34 @@
+#ifndef __PRINT_BUFFER_H__
+#define __PRINT_BUFFER_H__
+
+#include "../../FdaPDE.h"
+#include <string>
+
+//! RAII object redirecting the messages printed by the calling thread to a string
+/*!
+  R must only be called from the master thread, while some fits (e.g. the datasets of regression_skeleton_batch) are run
+  inside OpenMP parallel regions. The code reachable from those regions prints through fdaPDE::Rprintf_buffered: while a
+  Print_Capture is alive on the calling thread the messages are appended to its string, otherwise they are printed
+  through Rprintf. The captured strings are then printed by the master thread, after the parallel region.
+*/
+class Print_Capture
+{
+public:
+  explicit Print_Capture(std::string & target);
+  ~Print_Capture();
+
+  Print_Capture(const Print_Capture &) = delete;
+  Print_Capture & operator=(const Print_Capture &) = delete;
+
+private:
+  std::string * previous_;
+};
+
+namespace fdaPDE{
+
+//! Same as Rprintf, but the message is appended to the string of the Print_Capture active on the calling thread, if any
+void Rprintf_buffered(const char * format, ...);
+
+}
+
+#endif
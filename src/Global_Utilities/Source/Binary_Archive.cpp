@@ -0,0 +1,203 @@
+#include "../Include/Binary_Archive.h"
+#include <climits>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  constexpr std::uint64_t header_size = sizeof(BinaryArchive::magic) + 2*sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+  std::uint64_t aligned(std::uint64_t offset)
+  {
+    return (offset + BinaryArchive::alignment - 1) / BinaryArchive::alignment * BinaryArchive::alignment;
+  }
+}
+
+void BinaryArchiveWriter::addSection(std::uint32_t tag, const Real * data, UInt nrows, UInt ncols)
+{
+  Section section{tag, BinaryArchive::ScalarType::Real, nrows, ncols, std::vector<char>(sizeof(Real)*nrows*ncols)};
+  if(!section.payload.empty())
+    std::memcpy(section.payload.data(), data, section.payload.size());
+  sections_.push_back(std::move(section));
+}
+
+void BinaryArchiveWriter::addSection(std::uint32_t tag, const UInt * data, UInt nrows, UInt ncols)
+{
+  Section section{tag, BinaryArchive::ScalarType::Integer, nrows, ncols, std::vector<char>(sizeof(UInt)*nrows*ncols)};
+  if(!section.payload.empty())
+    std::memcpy(section.payload.data(), data, section.payload.size());
+  sections_.push_back(std::move(section));
+}
+
+bool BinaryArchiveWriter::write(const std::string & filename) const
+{
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  if(!file)
+    return false;
+
+  const std::uint32_t version = BinaryArchive::version;
+  const std::uint32_t bom = BinaryArchive::byte_order_mark;
+  const std::uint64_t n_sections = sections_.size();
+  file.write(BinaryArchive::magic, sizeof(BinaryArchive::magic));
+  file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+  file.write(reinterpret_cast<const char *>(&bom), sizeof(bom));
+  file.write(reinterpret_cast<const char *>(&n_sections), sizeof(n_sections));
+
+  // Table of sections, the payloads follow it at aligned offsets
+  std::uint64_t offset = aligned(header_size + n_sections*(2*sizeof(std::uint32_t) + 3*sizeof(std::uint64_t)));
+  std::vector<std::uint64_t> offsets(n_sections);
+  for(std::size_t i=0; i<n_sections; ++i)
+    {
+      const Section & section = sections_[i];
+      const std::uint32_t type = static_cast<std::uint32_t>(section.type);
+      const std::uint64_t nrows = section.nrows;
+      const std::uint64_t ncols = section.ncols;
+      offsets[i] = offset;
+      file.write(reinterpret_cast<const char *>(&section.tag), sizeof(section.tag));
+      file.write(reinterpret_cast<const char *>(&type), sizeof(type));
+      file.write(reinterpret_cast<const char *>(&nrows), sizeof(nrows));
+      file.write(reinterpret_cast<const char *>(&ncols), sizeof(ncols));
+      file.write(reinterpret_cast<const char *>(&offsets[i]), sizeof(offsets[i]));
+      offset = aligned(offset + section.payload.size());
+    }
+
+  for(std::size_t i=0; i<n_sections; ++i)
+    {
+      const std::vector<char> padding(offsets[i] - static_cast<std::uint64_t>(file.tellp()), 0);
+      file.write(padding.data(), padding.size());
+      file.write(sections_[i].payload.data(), sections_[i].payload.size());
+    }
+
+  return static_cast<bool>(file);
+}
+
+BinaryArchiveReader::BinaryArchiveReader(const std::string & filename)
+{
+#ifndef _WIN32
+  // Private writable mapping: pages are shared with the page cache until written (RNumericMatrix needs non-const pointers)
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if(fd != -1)
+    {
+      struct stat st;
+      if(fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+	  void * address = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	  if(address != MAP_FAILED)
+	    {
+	      data_ = static_cast<char *>(address);
+	      size_ = st.st_size;
+	      mapped_ = true;
+	    }
+	}
+      close(fd);
+    }
+#endif
+
+  if(!mapped_)
+    {
+      std::ifstream file(filename, std::ios::binary | std::ios::ate);
+      if(!file)
+	return;
+      size_ = file.tellg();
+      buffer_.resize(size_);
+      file.seekg(0);
+      file.read(buffer_.data(), size_);
+      if(!file)
+	return;
+      data_ = buffer_.data();
+    }
+
+  // Check the header
+  if(size_ < header_size || std::memcmp(data_, BinaryArchive::magic, sizeof(BinaryArchive::magic)) != 0)
+    return;
+
+  std::uint32_t version, bom;
+  std::uint64_t n_sections;
+  std::memcpy(&version, data_ + sizeof(BinaryArchive::magic), sizeof(version));
+  std::memcpy(&bom, data_ + sizeof(BinaryArchive::magic) + sizeof(version), sizeof(bom));
+  std::memcpy(&n_sections, data_ + sizeof(BinaryArchive::magic) + sizeof(version) + sizeof(bom), sizeof(n_sections));
+  if(version > BinaryArchive::version || bom != BinaryArchive::byte_order_mark)
+    return;
+
+  static_assert(sizeof(Entry) == 2*sizeof(std::uint32_t) + 3*sizeof(std::uint64_t), "Unexpected padding in the archive table");
+  if(n_sections > (size_ - header_size) / sizeof(Entry))
+    return;
+
+  table_.resize(n_sections);
+  std::memcpy(table_.data(), data_ + header_size, n_sections*sizeof(Entry));
+  valid_ = true;
+}
+
+BinaryArchiveReader::~BinaryArchiveReader()
+{
+#ifndef _WIN32
+  if(mapped_)
+    munmap(data_, size_);
+#endif
+}
+
+const BinaryArchiveReader::Entry * BinaryArchiveReader::findSection(std::uint32_t tag) const
+{
+  for(const Entry & entry : table_)
+    {
+      if(entry.tag == tag)
+	return &entry;
+    }
+  return nullptr;
+}
+
+char * BinaryArchiveReader::sectionData(const Entry & entry, std::uint64_t scalar_size) const
+{
+  // Checked without computing offset + size, which can overflow for a corrupted table
+  const std::uint64_t max_scalars = size_ / scalar_size;
+  if(entry.offset > size_ || (entry.ncols != 0 && entry.nrows > max_scalars / entry.ncols) ||
+     entry.nrows*entry.ncols*scalar_size > size_ - entry.offset)
+    {
+      Rprintf("ERROR: section %u of the archive exceeds the size of the file, the archive is corrupted\n", entry.tag);
+      return nullptr;
+    }
+  // The sizes are returned as UInt and the sections are indexed by UInt
+  if(entry.nrows > INT_MAX || entry.ncols > INT_MAX || entry.nrows*entry.ncols > INT_MAX)
+    {
+      Rprintf("ERROR: section %u of the archive is too large to be indexed\n", entry.tag);
+      return nullptr;
+    }
+  return data_ + entry.offset;
+}
+
+Real * BinaryArchiveReader::getReal(std::uint32_t tag, UInt & nrows, UInt & ncols) const
+{
+  const Entry * entry = findSection(tag);
+  if(entry == nullptr || entry->type != static_cast<std::uint32_t>(BinaryArchive::ScalarType::Real))
+    return nullptr;
+
+  char * data = sectionData(*entry, sizeof(Real));
+  if(data == nullptr)
+    return nullptr;
+
+  nrows = entry->nrows;
+  ncols = entry->ncols;
+  return reinterpret_cast<Real *>(data);
+}
+
+UInt * BinaryArchiveReader::getInteger(std::uint32_t tag, UInt & nrows, UInt & ncols) const
+{
+  const Entry * entry = findSection(tag);
+  if(entry == nullptr || entry->type != static_cast<std::uint32_t>(BinaryArchive::ScalarType::Integer))
+    return nullptr;
+
+  char * data = sectionData(*entry, sizeof(UInt));
+  if(data == nullptr)
+    return nullptr;
+
+  nrows = entry->nrows;
+  ncols = entry->ncols;
+  return reinterpret_cast<UInt *>(data);
+}
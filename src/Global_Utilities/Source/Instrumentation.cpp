@@ -0,0 +1,136 @@
+#include "../Include/Instrumentation.h"
+#include <algorithm>
+
+namespace
+{
+  //! Position of name in names, appended (with a zero value in values) if not present
+  template<typename T>
+  std::size_t find_or_append(std::vector<std::string> & names, std::vector<T> & values, const std::string & name)
+  {
+    const std::size_t index = std::find(names.begin(), names.end(), name) - names.begin();
+    if(index == names.size())
+      {
+	names.push_back(name);
+	values.push_back(T(0));
+      }
+    return index;
+  }
+
+  template<typename T>
+  T find_value(const std::vector<std::string> & names, const std::vector<T> & values, const std::string & name)
+  {
+    const std::size_t index = std::find(names.begin(), names.end(), name) - names.begin();
+    return index == names.size() ? T(0) : values[index];
+  }
+
+  SEXP strings_to_R(const std::vector<std::string> & strings)
+  {
+    SEXP result = PROTECT(Rf_allocVector(STRSXP, strings.size()));
+    for(std::size_t i=0; i<strings.size(); ++i)
+      SET_STRING_ELT(result, i, Rf_mkChar(strings[i].c_str()));
+    UNPROTECT(1);
+    return result;
+  }
+}
+
+Instrumentation & Instrumentation::get(void)
+{
+  static Instrumentation registry;
+  return registry;
+}
+
+void Instrumentation::reset(void)
+{
+  #pragma omp critical(fdaPDE_instrumentation)
+  {
+    phase_names_.clear();
+    phase_seconds_.clear();
+    phase_calls_.clear();
+    counter_names_.clear();
+    counter_values_.clear();
+  }
+}
+
+void Instrumentation::addTime(const std::string & phase, Real seconds)
+{
+  #pragma omp critical(fdaPDE_instrumentation)
+  {
+    const std::size_t index = find_or_append(phase_names_, phase_seconds_, phase);
+    if(index == phase_calls_.size())
+      phase_calls_.push_back(0);
+    phase_seconds_[index] += seconds;
+    ++phase_calls_[index];
+  }
+}
+
+void Instrumentation::addCount(const std::string & counter, Real value)
+{
+  #pragma omp critical(fdaPDE_instrumentation)
+  {
+    const std::size_t index = find_or_append(counter_names_, counter_values_, counter);
+    counter_values_[index] += value;
+  }
+}
+
+void Instrumentation::setCount(const std::string & counter, Real value)
+{
+  #pragma omp critical(fdaPDE_instrumentation)
+  {
+    const std::size_t index = find_or_append(counter_names_, counter_values_, counter);
+    counter_values_[index] = value;
+  }
+}
+
+void Instrumentation::maxCount(const std::string & counter, Real value)
+{
+  #pragma omp critical(fdaPDE_instrumentation)
+  {
+    const std::size_t index = find_or_append(counter_names_, counter_values_, counter);
+    counter_values_[index] = std::max(counter_values_[index], value);
+  }
+}
+
+Real Instrumentation::getTime(const std::string & phase) const
+{
+  Real seconds;
+  #pragma omp critical(fdaPDE_instrumentation)
+  {
+    seconds = find_value(phase_names_, phase_seconds_, phase);
+  }
+  return seconds;
+}
+
+Real Instrumentation::getCount(const std::string & counter) const
+{
+  Real value;
+  #pragma omp critical(fdaPDE_instrumentation)
+  {
+    value = find_value(counter_names_, counter_values_, counter);
+  }
+  return value;
+}
+
+SEXP Instrumentation::toR(void) const
+{
+  SEXP result = PROTECT(Rf_allocVector(VECSXP, 5));
+
+  SET_VECTOR_ELT(result, 0, strings_to_R(phase_names_));
+  SET_VECTOR_ELT(result, 1, Rf_allocVector(REALSXP, phase_seconds_.size()));
+  SET_VECTOR_ELT(result, 2, Rf_allocVector(INTSXP, phase_calls_.size()));
+  Real * rans = REAL(VECTOR_ELT(result, 1));
+  int * rans2 = INTEGER(VECTOR_ELT(result, 2));
+  for(std::size_t i=0; i<phase_names_.size(); ++i)
+    {
+      rans[i] = phase_seconds_[i];
+      rans2[i] = phase_calls_[i];
+    }
+
+  SET_VECTOR_ELT(result, 3, strings_to_R(counter_names_));
+  SET_VECTOR_ELT(result, 4, Rf_allocVector(REALSXP, counter_values_.size()));
+  Real * rans3 = REAL(VECTOR_ELT(result, 4));
+  for(std::size_t i=0; i<counter_values_.size(); ++i)
+    rans3[i] = counter_values_[i];
+
+  UNPROTECT(1);
+  return result;
+}
@@ -0,0 +1,48 @@
+#include "../Include/Print_Buffer.h"
+#include <cstdarg>
+#include <cstdio>
+
+namespace
+{
+  //! String receiving the messages of the calling thread, nullptr if they have to be printed
+  std::string * & captured_output(void)
+  {
+    static thread_local std::string * target = nullptr;
+    return target;
+  }
+}
+
+Print_Capture::Print_Capture(std::string & target): previous_(captured_output())
+{
+  captured_output() = &target;
+}
+
+Print_Capture::~Print_Capture()
+{
+  captured_output() = previous_;
+}
+
+namespace fdaPDE{
+
+void Rprintf_buffered(const char * format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  va_list args_copy;
+  va_copy(args_copy, args);
+  const int length = std::vsnprintf(nullptr, 0, format, args_copy);
+  va_end(args_copy);
+
+  if(length > 0)
+    {
+      std::string message(length, '\0');
+      std::vsnprintf(&message[0], length+1, format, args);
+      if(captured_output())
+	captured_output()->append(message);
+      else
+	Rprintf("%s", message.c_str());
+    }
+  va_end(args);
+}
+
+}
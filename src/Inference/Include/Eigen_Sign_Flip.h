@@ -11,29 +11,60 @@
 #include "Inference_Carrier.h"
 #include "Inverter.h"
 #include "Inference_Base.h"
+#include "Sign_Flip_Engine.h"
+#include "../../Global_Utilities/Include/Instrumentation.h"
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 // *** Eigen_Sign_Flip_Base Class ***
 //! Hypothesis testing and confidence intervals using eigen-sign-flip implementation
 /*!
-  This template class is an abstract base class to perform hypothesis testing and computing confidence intervals using an eigen-sign-flip approach. Beyond all the objects and methods inherited from the abstract base inference class, it stores the matrix Lambda, whose type is given by the template parameter MatrixType which can be either a dense or a sparse matrix depending on the inversion exactness of the MatrixNoCov; it stores the partial residuals under the null hypothesis and a boolean indicating if the matrix Lambda has been computed. It overrides the methods that specify how to compute the p-values and the confidence intervals, according to the eigen-sign-flip apporach. It has a pure virtual method for the computation of Lambda, since it relies on the inversion of MatrixNoCov in an exact or non-exact way (not implemented in this version).
+  This template class is an abstract base class to perform hypothesis testing and computing confidence intervals using an eigen-sign-flip approach. Beyond all the objects and methods inherited from the abstract base inference class, it stores the matrix Lambda, whose type is given by the template parameter MatrixType which can be either a dense or a sparse matrix depending on the inversion exactness of the MatrixNoCov; it stores the eigendecomposition of Lambda, the partial residuals under the null hypothesis, a boolean indicating if the matrix Lambda has been computed and the seed of the sign-flips, which are drawn by the shared Sign_Flip_Engine. It overrides the methods that specify how to compute the p-values and the confidence intervals, according to the eigen-sign-flip apporach. It has a pure virtual method for the computation of Lambda, since it relies on the inversion of MatrixNoCov in an exact or non-exact way.
   \tparam InputHandler the type of regression problem needed to determine the MixedFERegressionBase object type in Inference_Carrier<InputHandler>
-  \tparam MatrixType the type of matrix (MatrixXr or SpMat) used to store diffferent objects related to the smoothers S and Lambda. SpMat type is related to approximated inference computation (not implemented in this version).
+  \tparam MatrixType the type of matrix (MatrixXr or SpMat) used to store diffferent objects related to the smoothers S and Lambda. SpMat type is related to approximated inference computation.
 */
 template<typename InputHandler, typename MatrixType>
 class Eigen_Sign_Flip_Base:public Inference_Base<InputHandler, MatrixType>{
 protected:
   MatrixXr Partial_res_H0; 				//!< Contains: z - W^t * beta_0
   VectorXr Partial_f_res_H0;                            //!< Contains: Q_loc*(z_loc - f_0)
+  Sign_Flip_Projector Q_loc;                            //!< Projector on the orthogonal complement of the covariates in the inference locations, shared by the f p-value and the f CI
+  bool is_Q_loc_computed = false;                       //!< Boolean that tells whether Q_loc has been computed or not
   MatrixType Lambda;   					//!< I - Psi*(Psi^t * Psi + lambda*R)^-1*Psi^t
   bool is_Lambda_computed = false;			//!< Boolean that tells whether Lambda has been computed or not
+  Eigen::SelfAdjointEigenSolver<MatrixXr> Lambda_dec;	//!< Eigendecomposition of Lambda, shared by the tests and the intervals on beta
+  bool is_Lambda_dec_computed = false;			//!< Boolean that tells whether the eigendecomposition of Lambda has been computed or not
   VectorXr Speckman_aux_ranges;                         //!< Speckman auxiliary CI ranges needed for CI method initialization (for beta)
   VectorXr Wald_aux_ranges;                             //!< Wald auxiliary CI ranges needed for CI method initialization (for f) 
   bool is_speckman_aux_computed = false;                //!< Boolean that tells whether Speckman auxiliary ranges have been computed or not
   bool is_wald_aux_computed = false;                    //!< Boolean that tells whether Wald auxiliary ranges have been computed or not
+  std::uint64_t flip_seed;                              //!< Seed of the sign-flips: the user seed or, if it is not given, a random seed drawn once for this implementation
+  mutable std::array<unsigned long int, 2> n_flips_used{};  //!< Number of sign-flips used by the p-values on beta and on f of the current position, 0 if not computed
+  mutable std::array<Real, 2> flips_mc_se{};            //!< Largest Monte Carlo standard error of the p-values on beta and on f of the current position
   virtual void compute_Lambda(void) = 0;		//!< Pure virtual method used to compute Lambda, either in an exact or non-exact way
   void Compute_speckman_aux(void);                      //!< Auxiliary function for beta CI that computes the speckman ranges
   void Compute_wald_aux(void);                          //!< Auxiliary function for f CI that computes the wald ranges
+  void Compute_Q_loc(void);                             //!< Auxiliary function for f p-value and CI that decomposes the covariates in the inference locations
+  void Compute_Lambda_dec(void);                        //!< Auxiliary function for beta p-values and CI that computes the eigendecomposition of Lambda
+  
+  // sign-flips shared by all the tests
+  Sign_Flip_Engine flip_engine(UInt test) const {return Sign_Flip_Engine(flip_seed, 4*this->pos_impl + test, this->inf_car.getInfData()->get_n_Flip());}  //!< Engine of the sign-flips of a test (0: beta p-values, 1: f p-value, 2: beta CI, 3: f CI)
+  std::vector<bool> fixed_components(const VectorXr & Tilder_hat) const;  //!< Components that are not flipped, i.e. the biased ones if enhanced-ESF is required
+  static void flip_operator(const MatrixXr & TildeX, const MatrixXr & Tilder, const std::vector<bool> & fixed, MatrixXr & B, VectorXr & offset);  //!< Writes the statistics diag(TildeX * diag(flip) * Tilder) as offset + B*flip
+  //! Method that counts the sign-flips of a test, stopping as soon as the decisions on its p-values are settled if an early stopping is required (mc_Error > 0)
+  /*!
+    The decision on a p-value estimated on n flips is settled when the significance is out of the Monte Carlo band of the engine, whose error probability is split among
+    the fractions of flips the p-values depend on. The number of flips used and the largest Monte Carlo standard error of the p-values are kept for get_flips_info and recorded in the instrumentation registry.
+    \param component 0 for the p-values on beta, 1 for the p-value on f
+    \param pvalues a function (const MatrixXr & counts, unsigned long int n) returning the p-values estimated from the counts of n flips
+    \param scale the p-values are at most scale times a fraction of flips (2 for the bilateral p-values)
+    \param n_fractions number of fractions of flips the p-values depend on
+    \param n_done number of flips performed
+  */
+  template<typename MatrixB, typename Counter, typename PValues>
+  MatrixXr count_flips(UInt component, const Sign_Flip_Engine & engine, const MatrixB & B, const VectorXr & offset, UInt n_rows, UInt n_cols, Counter counter, PValues pvalues, Real scale, UInt n_fractions, unsigned long int & n_done) const;
   
   // methods that compute pvalues and/or CI on beta and on f respectively
   VectorXr compute_beta_pvalue(void) override;
@@ -41,36 +72,59 @@ protected:
   MatrixXv compute_beta_CI(void) override;
   MatrixXv compute_f_CI(void) override;
   
-  Real compute_CI_aux_beta_pvalue(const VectorXr &, const MatrixXr &, const VectorXr &, const  MatrixXr &) const;  //!< Computes the unilateral p value for a generic beta proposed in the research algorithm for CI 
-  Real compute_CI_aux_f_pvalue(const VectorXr &, const UInt current_index) const;  //!< Computes the unilateral p value for a generic value of f in a given point proposed in the research algorithm for CI  
+  Sign_Flip_Line compute_CI_aux_beta_line(const VectorXr & res_base, const VectorXr & res_slope, const MatrixXr & TildeX_loc, const std::vector<bool> & fixed, const MatrixXr & Tilder_star) const;  //!< Computes the flipped statistics of a beta as affine functions of the value proposed in the research algorithm for CI
+  Sign_Flip_Line compute_CI_aux_f_line(const VectorXr & res_base, const VectorXr & res_slope, const MatrixXr & A, bool eigen_basis) const;  //!< Computes the flipped statistics of f in a given point as affine functions of the value proposed in the research algorithm for CI
     
   
 public:
   // CONSTUCTOR
   Eigen_Sign_Flip_Base()=delete;	//The default constructor is deleted
-  Eigen_Sign_Flip_Base(std::shared_ptr<Inverse_Base<MatrixType>> inverter_, const Inference_Carrier<InputHandler> & inf_car_, UInt pos_impl_):Inference_Base<InputHandler, MatrixType>(inverter_, inf_car_, pos_impl_){}; //Main constructor of the class
+  Eigen_Sign_Flip_Base(Inference_Workspace<InputHandler, MatrixType> & workspace_, UInt pos_impl_):Inference_Base<InputHandler, MatrixType>(workspace_, pos_impl_), flip_seed(Sign_Flip_Engine::make_seed(workspace_.getInf_car().getInfData()->get_seed_Flip())){}; //Main constructor of the class
 
   // DESTRUCTOR
   virtual ~ Eigen_Sign_Flip_Base() {};
+
+  //!< Setter for pos_impl, that discards the auxiliary ranges computed with the quantile of another position and the sign-flips summary of the previous position
+  void setpos_impl (UInt pos_impl_) override;
+
+  //!< Number of sign-flips used and largest Monte Carlo standard error of the p-values on beta, then the same for f (10e20 for a p-value not computed)
+  VectorXr get_flips_info(void) const override;
     
   // GETTERS
-  inline const MatrixXr * getLambdap (void) const {return &this->Lambda;}      	                        //!< Getter of Lambdap \return Lambdap
+  inline const MatrixType * getLambdap (void) const {return &this->Lambda;}    	                        //!< Getter of Lambdap \return Lambdap
   inline const MatrixXr * getPartial_res_H0p (void) const {return &this->Partial_res_H0;}  		//!< Getter of Partial_res_H0p \return Partial_res_H0p
 };
 
 // *** Eigen_Sign_Flip_Exact Class ***
 //! Hypothesis testing using Eigen-Sign-Flip implementation in an exact way 
 /*!
-  This template class derives from the Eigen_Sign_Flip_Base class and it overrides the method that manages the computation of the matrix Lambda, relying on an exact inversion of the MatrixNoCov. 
+  This template class derives from the Eigen_Sign_Flip_Base class and it overrides the method that manages the computation of the matrix Lambda, relying on exact solves of the MatrixNoCov. The inverse of MatrixNoCov, of size 2NM x 2NM in
+  the space-time models, is never formed: the system is solved against the columns of Psi^t*A only, by blocks, so that the memory needed beyond Lambda itself stays proportional to the number of nodes.
 */
 template<typename InputHandler, typename MatrixType>
 class Eigen_Sign_Flip_Exact:public Eigen_Sign_Flip_Base<InputHandler, MatrixType>{
 private: 
+  static constexpr UInt block_size = 256;		//!< Number of columns of Lambda computed at once
   void compute_Lambda(void) override;
 public:
   // CONSTUCTOR
   Eigen_Sign_Flip_Exact()=delete;	//The default constructor is deleted
-  Eigen_Sign_Flip_Exact(std::shared_ptr<Inverse_Base<MatrixType>> inverter_, const Inference_Carrier<InputHandler> & inf_car_, UInt pos_impl_):Eigen_Sign_Flip_Base<InputHandler, MatrixType>(inverter_, inf_car_, pos_impl_){}; 
+  Eigen_Sign_Flip_Exact(Inference_Workspace<InputHandler, MatrixType> & workspace_, UInt pos_impl_):Eigen_Sign_Flip_Base<InputHandler, MatrixType>(workspace_, pos_impl_){}; 
+};
+
+// *** Eigen_Sign_Flip_Non_Exact Class ***
+//! Hypothesis testing using Eigen-Sign-Flip implementation in a non-exact way 
+/*!
+  This template class derives from the Eigen_Sign_Flip_Base class and it overrides the method that manages the computation of the matrix Lambda, relying on the sparse approximate inverse of the upper left block of the MatrixNoCov: Lambda is then a sparse matrix. 
+*/
+template<typename InputHandler, typename MatrixType>
+class Eigen_Sign_Flip_Non_Exact:public Eigen_Sign_Flip_Base<InputHandler, MatrixType>{
+private: 
+  void compute_Lambda(void) override;
+public:
+  // CONSTUCTOR
+  Eigen_Sign_Flip_Non_Exact()=delete;	//The default constructor is deleted
+  Eigen_Sign_Flip_Non_Exact(Inference_Workspace<InputHandler, MatrixType> & workspace_, UInt pos_impl_):Eigen_Sign_Flip_Base<InputHandler, MatrixType>(workspace_, pos_impl_){}; 
 };
 
 
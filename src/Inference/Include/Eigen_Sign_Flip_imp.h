@@ -1,40 +1,40 @@
 #include "Eigen_Sign_Flip.h"
 #include "Inference_Factory.h"
+#include "Sign_Flip_Engine.h"
+#include <algorithm>
 #include <cmath>
-#include <random>
 #include <type_traits>
 #include <vector>
 
 template<typename InputHandler, typename MatrixType>
-void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::Compute_speckman_aux(void){
-    
-  //check if Lambda has been computed
-  if(!is_Lambda_computed){
-    this->compute_Lambda();
+void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::setpos_impl(UInt pos_impl_){
+  // the auxiliary ranges depend on the quantile and on the level of the current position
+  if(pos_impl_ != this->pos_impl){
+    this->is_speckman_aux_computed = false;
+    this->is_wald_aux_computed = false;
   }
+  this->pos_impl = pos_impl_;
+  this->n_flips_used.fill(0);
+  this->flips_mc_se.fill(0);
+}
 
-  // extract W and W^T
-  const MatrixXr * W = this->inf_car.getWp();
-  const MatrixXr W_t = W->transpose();
-  
-  // Decomposition of [W^t * Lambda^2 * W] 
-  Eigen::PartialPivLU<MatrixXr> WLW_dec; 
-  WLW_dec.compute((W_t)*((this->Lambda)*(this->Lambda))*(*W));
-  
-  // get the residuals needed
-  VectorXr eps_hat = (*(this->inf_car.getZp())) - (this->inf_car.getZ_hat());
-  // build squared residuals
-  VectorXr Res2=eps_hat.array()*eps_hat.array();
-  
-  // resize the variance-covariance matrix
-  UInt q = this->inf_car.getq();
-  MatrixXr V;
-  V.resize(q,q);
-  
-  
-  MatrixXr diag = Res2.asDiagonal();
-  
-  V = (WLW_dec).solve((W_t)*(Lambda*Lambda)*Res2.asDiagonal()*(Lambda*Lambda)*(*W)*(WLW_dec).solve(MatrixXr::Identity(q,q))); // V = [(W*Lambda2*W)^-1 * Res2 * (W*Lambda2*W)^-1]
+template<typename InputHandler, typename MatrixType>
+VectorXr Eigen_Sign_Flip_Base<InputHandler, MatrixType>::get_flips_info(void) const{
+  VectorXr info = VectorXr::Constant(4, 10e20);
+  for(UInt component=0; component<2; ++component){
+    if(n_flips_used[component] > 0){
+      info(2*component) = n_flips_used[component];
+      info(2*component+1) = flips_mc_se[component];
+    }
+  }
+  return info;
+}
+
+template<typename InputHandler, typename MatrixType>
+void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::Compute_speckman_aux(void){
+    
+  // get the variance-covariance matrix of the Speckman estimator, shared with the Speckman implementation
+  const MatrixXr & V = this->workspace.getV_Speckman();
 
   // Extract the quantile needed for the computation of upper and lower bounds
   Real quant = this->inf_car.getInfData()->get_inference_quantile()[this->pos_impl];
@@ -65,15 +65,11 @@ void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::Compute_speckman_aux(void){
 template<typename InputHandler, typename MatrixType>
 void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::Compute_wald_aux(void){
 
-  // create or get an already existing Wald inference object 
-  std::shared_ptr<Inference_Base<InputHandler,MatrixType>> wald_obj = Inference_Factory<InputHandler,MatrixType>::create_inference_method("wald", this->inverter, this->inf_car, this->pos_impl);
-  MatrixXv wald_output = wald_obj->compute_inference_output(); 
-  // extract the confidence intervals 
+  // create or get the Wald inference object of this call: if Wald has already been required, its smoothing matrix is reused
+  std::shared_ptr<Inference_Base<InputHandler,MatrixType>> wald_obj = Inference_Factory<InputHandler,MatrixType>::create_inference_method("wald", this->workspace, this->pos_impl);
+  // only the confidence intervals are needed, also the ones for beta if they were originally required as retrieved by pos_impl from inferenceData 
+  MatrixXv wald_CI = wald_obj->compute_CI(); 
   UInt n_loc = this->inf_car.getN_loc(); 
-  UInt p = this->inf_car.getInfData()->get_coeff_inference().rows();
-  UInt result_dim = (p > n_loc) ? p : n_loc; 
-  // this matrix contains the overall CI, also the ones for beta if they were originally required as retrieved by pos_impl from inferenceData 
-  MatrixXv wald_CI = wald_output.rightCols(result_dim);
   // extract the confidence intervals for f
   MatrixXv wald_f_CI = (wald_CI.row(1)).leftCols(n_loc);
   
@@ -91,19 +87,38 @@ void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::Compute_wald_aux(void){
   return;
 }
 
-template<typename InputHandler, typename MatrixType> 
-Real Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_CI_aux_beta_pvalue(const VectorXr & partial_res_H0_CI, const MatrixXr & TildeX, const VectorXr & Tilder_hat, const  MatrixXr & Tilder_star) const {
-  
-  // declare the vector that will store the p-values
-  Real result;
-    
-  // compute the vectors needed for the statistic 
-  VectorXr Tilder = Tilder_star * partial_res_H0_CI;
+template<typename InputHandler, typename MatrixType>
+void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::Compute_Q_loc(void){
+
+  if(this->inf_car.getRegData()->getCovariates()->rows()==0){ // no covariates case: Q_loc is the identity
+    Q_loc.compute(MatrixXr(this->inf_car.getN_loc(), 0));
+  }
+  else{ // covariates case: Q_loc = I - W_loc (W_loc^t W_loc)^-1 W_loc^t
+    Q_loc.compute(this->inf_car.getW_loc());
+  }
+
+  this->is_Q_loc_computed = true;
+
+  return;
+}
 
-  // Initialize observed statistic and sign_flipped statistic
-  MatrixXr stat_temp = TildeX*Tilder;
-  Real stat=stat_temp(0);
-  Real stat_flip=stat;
+template<typename InputHandler, typename MatrixType>
+void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::Compute_Lambda_dec(void){
+  // eigenvectors and eigenvalues of Lambda (dense, also when Lambda is sparse)
+  Lambda_dec.compute(Lambda);
+  this->is_Lambda_dec_computed = true;
+
+  return;
+}
+
+template<typename InputHandler, typename MatrixType>
+std::vector<bool> Eigen_Sign_Flip_Base<InputHandler, MatrixType>::fixed_components(const VectorXr & Tilder_hat) const{
+
+  // no component is fixed if enhanced-ESF is not required
+  std::vector<bool> fixed(Tilder_hat.size(), false);
+  if(this->inf_car.getInfData()->get_enhanced_inference()[this->pos_impl]==false){
+    return fixed;
+  }
 
   UInt n_obs = this->inf_car.getN_obs();
 
@@ -113,284 +128,215 @@ Real Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_CI_aux_beta_pvalue(
   Real Sigma_hat = std::sqrt(SS_res/(n_obs-1));
 
   Real threshold = 10*Sigma_hat; // This threshold is used to determine how many components will not be flipped: we drop those that show large alpha_hat w.r.t. the expected standar error
-  UInt N_Eig_Out=0; // Initialize number of biased components that will be fixed in Enhanced ESF p_value computation
-    
+  UInt N_Eig_Out=0; // It will store the number of biased components that will be kept fixed
 
-  // Random sign-flips
-  std::random_device rd; 
-  std::default_random_engine eng{rd()};
-  std::uniform_int_distribution<> distr{0,1}; // Bernoulli(1/2)
-  Real count_Up = 0;   // Counter for the number of flipped statistics that are larger the observed statistic
-  Real count_Down = 0; // Counter for the number of flipped statistics that are smaller the observed statistic
-    
-  VectorXr Tilder_perm=Tilder;
-    
-  // get the number of flips
-  unsigned long int n_flip=this->inf_car.getInfData()->get_n_Flip();
-
-  for(unsigned long int i=0;i<n_flip;i++){
-    N_Eig_Out=0;
-    for(unsigned long int j=0;j<TildeX.cols();j++){
-      UInt flip;
-      if((this->inf_car.getInfData()->get_enhanced_inference()[this->pos_impl]==true) && (N_Eig_Out<n_obs/2) && (fabs(Tilder_hat(j))>threshold)){ // Enhanced ESF test has been required and component biased
-	flip=1; // Fix the biased component
-	++N_Eig_Out;
+  for(UInt j=0; j<Tilder_hat.size(); ++j){
+    if((N_Eig_Out<n_obs/2) && (fabs(Tilder_hat(j))>threshold)){ // component is biased
+      fixed[j]=true;
+      ++N_Eig_Out;
+    }
+  }
+
+  return fixed;
+}
+
+template<typename InputHandler, typename MatrixType>
+void Eigen_Sign_Flip_Base<InputHandler, MatrixType>::flip_operator(const MatrixXr & TildeX, const MatrixXr & Tilder, const std::vector<bool> & fixed, MatrixXr & B, VectorXr & offset){
+
+  // number of flipped components
+  UInt m = 0;
+  for(UInt j=0; j<TildeX.cols(); ++j){
+    if(fixed.empty() || !fixed[j]){ ++m;}
+  }
+
+  const UInt k = TildeX.rows();
+  B.resize(k, m);
+  offset = VectorXr::Zero(k);
+
+  // the i-th statistic is sum_j TildeX(i,j)*s_j*Tilder(j,i) (or Tilder(j) if Tilder has a single column)
+  for(UInt i=0; i<k; ++i){
+    const UInt col = (Tilder.cols()==1) ? 0 : i;
+    UInt c = 0;
+    for(UInt j=0; j<TildeX.cols(); ++j){
+      const Real value = TildeX(i,j)*Tilder(j,col);
+      if(fixed.empty() || !fixed[j]){
+	B(i,c++) = value;
       }else{
-	flip=2*distr(eng)-1;
+	offset(i) += value;
       }
-      Tilder_perm(j)=Tilder(j)*flip;
-    }
-    MatrixXr stat_flip_temp = TildeX*Tilder_perm; 
-    stat_flip= stat_flip_temp(0);// Flipped statistic
-    if(stat_flip > stat){ ++count_Up;}else{ 
-      if(stat_flip < stat){ ++count_Down;}  
     }
   }
-    
-  Real pval_Up = count_Up/n_flip;     
-  Real pval_Down = count_Down/n_flip; 
 
-  result = std::min(pval_Up, pval_Down); // Selecting the correct unilateral p_value 
+  return;
+}
+
+template<typename InputHandler, typename MatrixType>
+Sign_Flip_Line Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_CI_aux_beta_line(const VectorXr & res_base, const VectorXr & res_slope, const MatrixXr & TildeX_loc, const std::vector<bool> & fixed, const MatrixXr & Tilder_star) const {
+
+  // compute the vectors needed for the statistic: the partial residuals of the value v are res_base + v*res_slope
+  MatrixXr Tilder(Tilder_star.rows(), 2);
+  Tilder.col(0) = Tilder_star * res_base;
+  Tilder.col(1) = Tilder_star * res_slope;
+
+  // observed statistic (base and slope)
+  MatrixXr stat = TildeX_loc*Tilder;
+
+  // Flipped statistics: offset + B*flip, the first row being the base and the second the slope, the biased components being fixed if enhanced ESF test has been required
+  MatrixXr TildeX_line(2, TildeX_loc.cols());
+  TildeX_line << TildeX_loc, TildeX_loc;
+  MatrixXr B;
+  VectorXr offset;
+  flip_operator(TildeX_line, Tilder, fixed, B, offset);
+
+  return Sign_Flip_Line(stat(0,0), stat(0,1), this->flip_engine(2).statistics(B, offset));
 
-  return result;
-  
 };
 
-template<typename InputHandler, typename MatrixType> 
-Real Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_CI_aux_f_pvalue(const VectorXr & partial_res_H0_CI, const UInt current_index) const {
-  // declare the result
-  Real result; 
+template<typename InputHandler, typename MatrixType>
+Sign_Flip_Line Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_CI_aux_f_line(const VectorXr & res_base, const VectorXr & res_slope, const MatrixXr & A, bool eigen_basis) const {
 
-  // get all the necessary matrices from the inf_car
-  const MatrixXr W_loc = this->inf_car.getW_loc();
-  const SpMat Psi_loc = this->inf_car.getPsi_loc();
-  const VectorXr Z_loc = this->inf_car.getZ_loc(); 
-  const UInt n_loc = this->inf_car.getN_loc(); 
-  unsigned long int n_flip=this->inf_car.getInfData()->get_n_Flip();
+  // residuals to be flipped, res_base + v*res_slope for the value v, in the basis of Q_loc for the eigen-sign-flip implementation
+  MatrixXr res(res_base.size(), 2);
+  res.col(0) = res_base;
+  res.col(1) = res_slope;
 
-  // compute Q_loc
-  MatrixXr Q_loc; 
-  Q_loc.resize(n_loc, n_loc);
-  
-  if(this->inf_car.getRegData()->getCovariates()->rows()==0){ // no covariates case
-    Q_loc = MatrixXr::Identity(n_loc, n_loc);
-  }
-  else{ // covariates case
-    MatrixXr WtW_loc = W_loc.transpose() * W_loc; 
-    Q_loc = MatrixXr::Identity(n_loc, n_loc) - W_loc * WtW_loc.ldlt().solve(W_loc.transpose());
+  // the statistic in the current location is A * res
+  MatrixXr A_line(2, A.cols());
+  A_line << A, A;
+
+  if(eigen_basis){ // eigen-sign-flip implementation: A * V and V^t * res
+    res = Q_loc.to_basis(res);
+    A_line = Q_loc.to_basis(A_line.transpose()).transpose();
   }
 
-  // Matrix that groups close location points, needed only when locations are nodes
-  const MatrixXr Group_res = this->inf_car.getGroup_loc();
+  // observed statistic (base and slope, one-at-the-time tests on the nodes)
+  MatrixXr T = A_line.topRows(1) * res;
 
-  // eigen-sign-flip implementation
-  if(this->inf_car.getInfData()->get_implementation_type()[this->pos_impl] == "eigen-sign-flip"){
-    // compute Q_loc decomposition
-    Eigen::SelfAdjointEigenSolver<MatrixXr> Q_dec(Q_loc);
-    
-    MatrixXr V = Q_dec.eigenvectors();
-    
-    if(this->inf_car.getRegData()->getCovariates()->rows()!=0){
-      UInt q = this->inf_car.getq();
-      V = Q_dec.eigenvectors().rightCols(n_loc - q);
-    }
-   
-    // update residuals to be flipped
-    const VectorXr V_partial_res_H0_CI = V.transpose() * partial_res_H0_CI; 
+  // flipped statistics: B*flip
+  MatrixXr B;
+  VectorXr offset;
+  flip_operator(A_line, res, std::vector<bool>(), B, offset);
 
-    // observed statistics
-    VectorXr T; 
- 
-    if(this->inf_car.getInfData()->get_locs_are_nodes_inference()){
-      T = Group_res * V * V_partial_res_H0_CI; 
-    }
-    else{
-      T = Psi_loc.transpose() * V * V_partial_res_H0_CI;
-    }
-    
-    VectorXr T_perm = T;
-
-    // Random sign-flips
-    std::random_device rd; 
-    std::default_random_engine eng{rd()};
-    std::uniform_int_distribution<> distr{0,1}; // Bernoulli(1/2)
-    Real count_Up = 0;   // Counter for the number of flipped statistics that are larger the observed statistic
-    Real count_Down = 0; // Counter for the number of flipped statistics that are smaller the observed statistic
-    VectorXr res_perm = V_partial_res_H0_CI; 
- 
-    for(unsigned long int i=0; i < n_flip; ++i){
-      for(unsigned long int j=0; j < V_partial_res_H0_CI.size(); ++j){
-	UInt flip=2*distr(eng)-1;
-	res_perm(j)=V_partial_res_H0_CI(j)*flip;
-      }
-      if(this->inf_car.getInfData()->get_locs_are_nodes_inference()){
-        T_perm = Group_res * V * res_perm; 
-      }
-      else{
-        T_perm = Psi_loc.transpose() * V * res_perm;
-      }
-      // flipped statistics (one-at-the-time tests on the nodes)
-      if(T_perm(current_index) > T(current_index)){++count_Up;}else{
-        if(T_perm(current_index) < T(current_index)){++count_Down;}
-      }     
-    }
-    Real pval_Up = count_Up/n_flip;
-    Real pval_Down = count_Down/n_flip;
+  return Sign_Flip_Line(T(0,0), T(0,1), this->flip_engine(3).statistics(B, offset));
 
-    result = std::min(pval_Up, pval_Down);
+};
 
+template<typename InputHandler, typename MatrixType>
+template<typename MatrixB, typename Counter, typename PValues>
+MatrixXr Eigen_Sign_Flip_Base<InputHandler, MatrixType>::count_flips(UInt component, const Sign_Flip_Engine & engine, const MatrixB & B, const VectorXr & offset, UInt n_rows, UInt n_cols, Counter counter, PValues pvalues, Real scale, UInt n_fractions, unsigned long int & n_done) const{
+  const Real mc_error = this->inf_car.getInfData()->get_mc_Error();
+  MatrixXr counts;
+
+  if(mc_error > 0){
+    // significance of the decision: the one of the intervals of this implementation, if given
+    const VectorXr alphas = this->inf_car.getInfData()->get_inference_alpha();
+    const Real alpha = (this->pos_impl < alphas.size() && alphas(this->pos_impl) > 0 && alphas(this->pos_impl) < 1) ? alphas(this->pos_impl) : 0.05;
+
+    counts = engine.count_sequential(B, offset, n_rows, n_cols, counter, [&](const MatrixXr & c, unsigned long int n){
+	const Real band = scale*engine.mc_band(n, B.cols(), mc_error/n_fractions);
+	return ((pvalues(c, n).array() - alpha).abs() > band).all();
+      }, n_done);
   }
-  else{ //sign-flip implementation
-      
-    // observed statistics
-    VectorXr T; 
- 
-    if(this->inf_car.getInfData()->get_locs_are_nodes_inference()){
-      T = Group_res * partial_res_H0_CI; 
-    }
-    else{
-      T = Psi_loc.transpose() * partial_res_H0_CI;
-    }
-    
-    VectorXr T_perm = T;
-
-    // Random sign-flips
-    std::random_device rd; 
-    std::default_random_engine eng{rd()};
-    std::uniform_int_distribution<> distr{0,1}; // Bernoulli(1/2)
-    Real count_Up = 0;   // Counter for the number of flipped statistics that are larger the observed statistic
-    Real count_Down = 0; // Counter for the number of flipped statistics that are smaller the observed statistic
-    VectorXr res_perm = partial_res_H0_CI; 
- 
-    for(unsigned long int i=0; i < n_flip; ++i){
-      for(unsigned long int j=0; j < partial_res_H0_CI.size(); ++j){
-	UInt flip=2*distr(eng)-1;
-	res_perm(j)=partial_res_H0_CI(j)*flip;
-      }
-      if(this->inf_car.getInfData()->get_locs_are_nodes_inference()){
-        T_perm = Group_res * res_perm; 
-      }
-      else{
-        T_perm = Psi_loc.transpose() * res_perm;
-      }
-      // flipped statistics (one-at-the-time tests on the nodes)
-      if(T_perm(current_index) > T(current_index)){++count_Up;}else{
-        if(T_perm(current_index) < T(current_index)){++count_Down;}
-      }     
-    }
-    Real pval_Up = count_Up/n_flip;
-    Real pval_Down = count_Down/n_flip;
-
-    result = std::min(pval_Up, pval_Down);
+  else{
+    counts = engine.count(B, offset, n_rows, n_cols, counter);
+    n_done = engine.get_n_flip();
   }
 
-  return result;
+  // Monte Carlo standard error of the p-values, from the largest variance of the fractions they depend on
+  const VectorXr fractions = (pvalues(counts, n_done)/scale).cwiseMax(0.).cwiseMin(1.);
+  const Real mc_se = scale*std::sqrt((fractions.array()*(1 - fractions.array())).maxCoeff()/n_done);
+
+  n_flips_used[component] = n_done;
+  flips_mc_se[component] = mc_se;
+  Instrumentation::get().addCount("flips", n_done);
+  Instrumentation::get().maxCount("flips_mc_se", mc_se);
 
+  return counts;
 };
 
-template<typename InputHandler, typename MatrixType> 
+template<typename InputHandler, typename MatrixType>
 VectorXr Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_pvalue(void){
-  
-  // extract matrix C 
-  // (in the eigen-sign-flip case we cannot have linear combinations, but we can have at most one 1 for each column of C) 
+
+  // extract matrix C
+  // (in the eigen-sign-flip case we cannot have linear combinations, but we can have at most one 1 for each column of C)
   MatrixXr C = this->inf_car.getInfData()->get_coeff_inference();
-  UInt p = C.rows(); 
-  
+  UInt p = C.rows();
+
   // declare the vector that will store the p-values
   VectorXr result;
-  
-  // get the number of flips
-  unsigned long int n_flip=this->inf_car.getInfData()->get_n_Flip();
-  
+
   // get the value of the parameters under the null hypothesis
-  VectorXr beta_0 = this->inf_car.getInfData()->get_beta_0(); 
-  
+  VectorXr beta_0 = this->inf_car.getInfData()->get_beta_0();
+
   // compute Lambda if necessary
   if(!is_Lambda_computed){
     this->compute_Lambda();
     if(!is_Lambda_computed){
       Rprintf("error: failed FSPAI inversion in p_values computation, discarding inference");
       result.resize(p);
-    
+
       for(UInt k=0;k<p;k++){
 	result(k)=10e20;
       }
       return result;
     }
   }
-  
-  // compute eigenvectors and eigenvalues of Lambda
-  Eigen::SelfAdjointEigenSolver<MatrixType> Lambda_dec(Lambda);
-  
+
+  // compute eigenvectors and eigenvalues of Lambda, if not already done for the tests or the intervals
+  if(!is_Lambda_dec_computed){
+    this->Compute_Lambda_dec();
+  }
+
   // extract covariates matrices
   const MatrixXr * W = this->inf_car.getWp();
 
   // Store beta_hat
   VectorXr beta_hat = (*(this->inf_car.getBeta_hatp()));
   VectorXr beta_hat_mod=beta_hat;
-  
+
+  // sign-flips engine
+  const Sign_Flip_Engine engine = this->flip_engine(0);
+
   // simultaneous test
-  if(this->inf_car.getInfData()->get_test_type()[this->pos_impl] == "simultaneous"){    
+  if(this->inf_car.getInfData()->get_test_type()[this->pos_impl] == "simultaneous"){
     // extract the current betas in test
     for(UInt i=0; i<p; i++){
       for(UInt j=0; j<C.cols(); j++){
         if(C(i,j)>0){beta_hat_mod[j]=beta_0[j];}
       }
     }
-    
+
     // compute the partial residuals
     Partial_res_H0 = *(this->inf_car.getZp()) - (*W) * beta_hat_mod;
-    
+
     // compute the vectors needed for the statistic
     MatrixXr TildeX = (C * W->transpose()) * Lambda_dec.eigenvectors()*Lambda_dec.eigenvalues().asDiagonal();   	// W^t * V * D
     VectorXr Tilder = Lambda_dec.eigenvectors().transpose()*Partial_res_H0;   			        		// V^t * partial_res_H0
-        
-    UInt n_obs = this->inf_car.getN_obs();
 
     // Prepare vectors for enhanced-ESF if requested
     VectorXr Tilder_hat = Lambda_dec.eigenvectors().transpose()* (*(this->inf_car.getZp()) - (*W)* beta_hat); // This vector represents Tilder using only beta_hat, needed for bias estimation
 
-    // Estimate the standard error
-    VectorXr eps_hat = (*(this->inf_car.getZp())) - (this->inf_car.getZ_hat());
-    Real SS_res = eps_hat.squaredNorm();
-    Real Sigma_hat = std::sqrt(SS_res/(n_obs-1));
-
-    Real threshold = 10*Sigma_hat; // This threshold is used to determine how many components will not be flipped: we drop those that show large alpha_hat w.r.t. the expected standar error
-    UInt N_Eig_Out=0; // It will store the number of biased components that will be kept fixed if enhanced-ESF is required
-    
-    // Initialize observed statistic and sign-flipped statistic
+    // Initialize observed statistic
     VectorXr stat=TildeX*Tilder;
-    VectorXr stat_flip=stat;
-    
-    //Random sign-flips
-    std::random_device rd; 
-    std::default_random_engine eng{rd()};
-    std::uniform_int_distribution<> distr{0,1}; // Bernoulli(1/2)
-    Real count_Up=0;
-    Real count_Down=0;
-
-    VectorXr Tilder_perm=Tilder;
-    
-    for(unsigned long int i=0;i<n_flip;i++){
-      N_Eig_Out=0;
-      for(unsigned long int j=0;j<TildeX.cols();j++){
-	UInt flip;
-        if((this->inf_car.getInfData()->get_enhanced_inference()[this->pos_impl]==true) && (N_Eig_Out<n_obs/2) && (fabs(Tilder_hat(j))>threshold)){ // If enhanced-ESF is required and component is biased
-	  flip=1; // Fix the biased component
-          ++N_Eig_Out;
-        }else{
-	  flip=2*distr(eng)-1;
-        }
-	Tilder_perm(j)=Tilder(j)*flip;
-      }
-      stat_flip=TildeX*Tilder_perm; // Flipped statistic
-      if(is_Unilaterally_Greater(stat_flip,stat)){ ++count_Up;}else{ //Here we use the custom-operator defined in Eigen_Sign_Flip.h
-	if(is_Unilaterally_Smaller(stat_flip,stat)){ ++count_Down;} //Here we use the custom-operator defined in Eigen_Sign_Flip.h 
-      }
-    }
-    
-    Real pval_Up = count_Up/n_flip;
-    Real pval_Down = count_Down/n_flip;
+
+    // Flipped statistic: offset + B*flip, the biased components being fixed if enhanced-ESF is required
+    MatrixXr B;
+    VectorXr offset;
+    flip_operator(TildeX, Tilder, fixed_components(Tilder_hat), B, offset);
+
+    // Random sign-flips: count the flipped statistics that are unilaterally greater (column 0) and smaller (column 1) than the observed one
+    auto pvalue = [](const MatrixXr & count, unsigned long int n){ return VectorXr::Constant(1, 2*std::min(count(0,0), count(0,1))/n);};
+    unsigned long int n_done;
+    MatrixXr counts = count_flips(0, engine, B, offset, 1, 2, [&stat](const MatrixXr & stat_flip, MatrixXr & count){
+	for(UInt i=0; i<stat_flip.cols(); ++i){
+	  if((stat_flip.col(i).array() > stat.array()).all()){ ++count(0,0);}else{
+	    if((stat_flip.col(i).array() < stat.array()).all()){ ++count(0,1);}
+	  }
+	}
+      }, pvalue, 2, 2, n_done);
+
+    Real pval_Up = counts(0,0)/n_done;
+    Real pval_Down = counts(0,1)/n_done;
 
     result.resize(p); // Allocate more space so that R receives a well defined object (different implementations may require higher number of pvalues)
     result(0) = 2*std::min(pval_Up,pval_Down); // Obtain the bilateral p_value starting from the unilateral
@@ -399,8 +345,8 @@ VectorXr Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_pvalue(voi
     }
   }
   else{
-    
-    // one-at-the-time tests    
+
+    // one-at-the-time tests
     Partial_res_H0.resize(Lambda.cols(), p);
     for(UInt i=0; i<p; ++i){
       // Extract the current beta in test
@@ -415,206 +361,120 @@ VectorXr Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_pvalue(voi
     // compute the vectors needed for the statistic
     MatrixXr TildeX = (C * W->transpose()) * Lambda_dec.eigenvectors()*Lambda_dec.eigenvalues().asDiagonal();   	// W^t * V * D
     MatrixXr Tilder = Lambda_dec.eigenvectors().transpose()*Partial_res_H0;   			        		// V^t * partial_res_H0
-    
-    UInt n_obs = this->inf_car.getN_obs();
 
     // Seclect eigenvalues that will not be flipped basing on the estimated bias carried
     VectorXr Tilder_hat = Lambda_dec.eigenvectors().transpose()* (*(this->inf_car.getZp()) - (*W)* beta_hat); // This vector represents Tilder using only beta_hat, needed for bias estimation
 
-    // Estimate the standard error
-    VectorXr eps_hat = (*(this->inf_car.getZp())) - (this->inf_car.getZ_hat());
-    Real SS_res = eps_hat.squaredNorm();
-    Real Sigma_hat = std::sqrt(SS_res/(n_obs-1));
-
-    Real threshold = 10*Sigma_hat; // This threshold is used to determine how many components will not be flipped: we drop those that show large alpha_hat w.r.t. the expected standar error
-    UInt N_Eig_Out=0; // It will store the number of biased components that will be kept fixed if enhanced-ESF is required
-
-    // Observed statistic
+    // Observed statistic (the k-th test is on the diagonal element (k,k))
     MatrixXr stat=TildeX*Tilder;
-    MatrixXr stat_flip=stat;
-
-    // Random sign-flips
-    std::random_device rd; 
-    std::default_random_engine eng{rd()};
-    std::uniform_int_distribution<> distr{0,1}; // Bernoulli(1/2)
-    VectorXr count_Up = VectorXr::Zero(p);
-    VectorXr count_Down = VectorXr::Zero(p);
-    
-    MatrixXr Tilder_perm=Tilder;
-    
-    for(unsigned long int i=0;i<n_flip;i++){
-      N_Eig_Out=0;
-      for(unsigned long int j=0;j<TildeX.cols();j++){
-	UInt flip;
-	if((this->inf_car.getInfData()->get_enhanced_inference()[this->pos_impl]==true) && (N_Eig_Out<n_obs/2) && (fabs(Tilder_hat(j))>threshold)){ // If enhanced-ESF is required and component is biased
-	  flip=1; // Fix the biased component
-          ++N_Eig_Out;
-	}else{
-	  flip=2*distr(eng)-1;
-	}
-	Tilder_perm.row(j)=Tilder.row(j)*flip;
-      }
-      stat_flip=TildeX*Tilder_perm; // Flipped statistic
-      
-      for(UInt k=0; k<p; ++k){
-	if(stat_flip(k,k) > stat(k,k)){
-	  ++count_Up(k);
-	}else{
-	  ++count_Down(k);
+    VectorXr stat_diag=stat.diagonal();
+
+    // Flipped statistics: offset + B*flip, one row for each test, the biased components being fixed if enhanced-ESF is required
+    MatrixXr B;
+    VectorXr offset;
+    flip_operator(TildeX, Tilder, fixed_components(Tilder_hat), B, offset);
+
+    // Random sign-flips: count, for each test, the flipped statistics that are larger (column 0) and not larger (column 1) than the observed one
+    auto pvalues = [](const MatrixXr & count, unsigned long int n){ return VectorXr(2*count.col(0).cwiseMin(count.col(1))/n);};
+    unsigned long int n_done;
+    MatrixXr counts = count_flips(0, engine, B, offset, p, 2, [&stat_diag](const MatrixXr & stat_flip, MatrixXr & count){
+	for(UInt i=0; i<stat_flip.cols(); ++i){
+	  for(UInt k=0; k<stat_flip.rows(); ++k){
+	    if(stat_flip(k,i) > stat_diag(k)){
+	      ++count(k,0);
+	    }else{
+	      ++count(k,1);
+	    }
+	  }
 	}
-      } 
-    }
-    
-    VectorXr pval_Up = count_Up/n_flip;
-    VectorXr pval_Down = count_Down/n_flip;
-    
+      }, pvalues, 2, p, n_done);
+
+    VectorXr pval_Up = counts.col(0)/n_done;
+    VectorXr pval_Down = counts.col(1)/n_done;
+
     result.resize(p);
     result = 2*min(pval_Up,pval_Down); // Obtain the blateral p_value starting from the unilateral
-  } 
+  }
   return result;
-  
+
 };
 
 template<typename InputHandler, typename MatrixType>
 Real Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_f_pvalue(void){
   // declare the result
-  Real p_value; 
+  Real p_value;
 
   // get all the necessary matrices from the inf_car
-  const MatrixXr W_loc = this->inf_car.getW_loc();
   const SpMat Psi_loc = this->inf_car.getPsi_loc();
-  const VectorXr Z_loc = this->inf_car.getZ_loc(); 
-  const UInt n_loc = this->inf_car.getN_loc(); 
+  const VectorXr Z_loc = this->inf_car.getZ_loc();
+  const UInt n_loc = this->inf_car.getN_loc();
 
-  const VectorXr f_0 = this->inf_car.getInfData()->get_f_0(); 
-  unsigned long int n_flip=this->inf_car.getInfData()->get_n_Flip();
+  const VectorXr f_0 = this->inf_car.getInfData()->get_f_0();
 
-  // compute Q_loc
-  MatrixXr Q_loc; 
-  Q_loc.resize(n_loc, n_loc);
-  
-  if(this->inf_car.getRegData()->getCovariates()->rows()==0){ // no covariates case
-    Q_loc = MatrixXr::Identity(n_loc, n_loc);
-  }
-  else{ // covariates case
-    MatrixXr WtW_loc = W_loc.transpose() * W_loc; 
-    Q_loc = MatrixXr::Identity(n_loc, n_loc) - W_loc * WtW_loc.ldlt().solve(W_loc.transpose());
+  // decompose Q_loc, if necessary
+  if(!is_Q_loc_computed){
+    this->Compute_Q_loc();
   }
 
   // compute the residuals under H0
-  this->Partial_f_res_H0 = Q_loc*(Z_loc - f_0); 
+  this->Partial_f_res_H0 = Q_loc.project(Z_loc - f_0);
 
   // Matrix that groups close location points, needed only when locations are nodes
-  MatrixXr Group_res = this->inf_car.getGroup_loc(); 
-  
-  // eigen-sign-flip implementation
-  if(this->inf_car.getInfData()->get_implementation_type()[this->pos_impl] == "eigen-sign-flip"){
-    // compute Q_loc decomposition
-    Eigen::SelfAdjointEigenSolver<MatrixXr> Q_dec(Q_loc);
-    
-    MatrixXr V = Q_dec.eigenvectors();
-    
-    if(this->inf_car.getRegData()->getCovariates()->rows()!=0){
-      UInt q = this->inf_car.getq();
-      V = Q_dec.eigenvectors().rightCols(n_loc - q);
-    }
-   
-    // update residuals to be flipped
-    VectorXr V_Partial_f_res_H0 = V.transpose() * this->Partial_f_res_H0; 
-    
-    // observed statistics
-    VectorXr T; 
- 
-    if(this->inf_car.getInfData()->get_locs_are_nodes_inference()){
-      T = Group_res * V * V_Partial_f_res_H0; 
-    }
-    else{
-      T = Psi_loc.transpose() * V * V_Partial_f_res_H0;
-    }
-    
-    VectorXr T_perm = T;
+  MatrixXr Group_res = this->inf_car.getGroup_loc();
+  const bool locs_are_nodes = this->inf_car.getInfData()->get_locs_are_nodes_inference();
 
-    // observed final statistic (for simultaneous test) 
-    Real T_comb;
-    
-    VectorXr T_sq = T.array() * T.array();
-    T_comb = T_sq.sum();
-    Real T_comb_perm = T_comb; 
-
-    // random sign-flips
-    std::random_device rd; 
-    std::default_random_engine eng{rd()};
-    std::uniform_int_distribution<> distr{0,1}; // Bernoulli(1/2)
-    Real count=0;
-    VectorXr res_perm = V_Partial_f_res_H0; 
-
-    for(unsigned long int i=0; i < n_flip; ++i){
-      for(unsigned long int j=0; j < V_Partial_f_res_H0.size(); ++j){
-	UInt flip=2*distr(eng)-1;
-	res_perm(j)=V_Partial_f_res_H0(j)*flip;
-      }
-      if(this->inf_car.getInfData()->get_locs_are_nodes_inference()){
-        T_perm = Group_res * V * res_perm; 
-      }
-      else{
-        T_perm = Psi_loc.transpose() * V * res_perm;
-      }
-      // flipped statistics
-      VectorXr T_perm_sq = T_perm.array() * T_perm.array();
-      T_comb_perm = T_perm_sq.sum();
-      
-      if(T_comb_perm >= T_comb){ ++count;} 
-    }
-    p_value = count/n_flip;
-    
+  // residuals to be flipped, in the basis of Q_loc for the eigen-sign-flip implementation
+  VectorXr res;
+  const bool eigen_basis = (this->inf_car.getInfData()->get_implementation_type()[this->pos_impl] == "eigen-sign-flip");
+
+  if(eigen_basis){ // eigen-sign-flip implementation
+    res = Q_loc.to_basis(this->Partial_f_res_H0);
   }
   else{ // sign-flip implementation
-    // observed statistics
-    VectorXr T; 
-    if(this->inf_car.getInfData()->get_locs_are_nodes_inference()){
-      T = Group_res * this->Partial_f_res_H0; 
+    res = this->Partial_f_res_H0;
+  }
+
+  // observed statistics
+  VectorXr T;
+  if(locs_are_nodes){
+    T = Group_res * this->Partial_f_res_H0;
+  }
+  else{
+    T = Psi_loc.transpose() * this->Partial_f_res_H0;
+  }
+
+  // observed final statistic (for simultaneous test)
+  Real T_comb = T.squaredNorm();
+
+  // random sign-flips: the engine gives the flipped residuals in the locations, the flips whose final statistic is not smaller than the observed one are counted
+  auto counter = [&](const MatrixXr & res_perm, MatrixXr & count){
+    MatrixXr T_perm;
+    if(locs_are_nodes){
+      T_perm = Group_res * res_perm;
     }
     else{
-      T = Psi_loc.transpose() * this->Partial_f_res_H0;
+      T_perm = Psi_loc.transpose() * res_perm;
     }
-    
-    VectorXr T_perm = T;
-
-    // observed final statistic (for simultaneous test) 
-    Real T_comb;
-    
-    VectorXr T_sq = T.array() * T.array();
-    T_comb = T_sq.sum();
-    Real T_comb_perm = T_comb; 
-    
-    // random sign-flips
-    std::random_device rd; 
-    std::default_random_engine eng{rd()};
-    std::uniform_int_distribution<> distr{0,1}; // Bernoulli(1/2)
-    Real count=0;
-    VectorXr res_perm = this->Partial_f_res_H0; 
-
-    for(unsigned long int i=0; i < n_flip; ++i){
-      for(unsigned long int j=0; j < n_loc; ++j){
-	UInt flip=2*distr(eng)-1;
-	res_perm(j)=this->Partial_f_res_H0(j)*flip;
-      }
-      if(this->inf_car.getInfData()->get_locs_are_nodes_inference()){
-        T_perm = Group_res * res_perm; 
-      }
-      else{
-        T_perm = Psi_loc.transpose() * res_perm; 
-      }
-      // flipped statistic
-      VectorXr T_perm_sq = T_perm.array() * T_perm.array();
-      T_comb_perm = T_perm_sq.sum();
-      
-      if(T_comb_perm >= T_comb){ ++count;} 
+    // flipped statistics
+    for(UInt i=0; i<T_perm.cols(); ++i){
+      if(T_perm.col(i).squaredNorm() >= T_comb){ ++count(0,0);}
     }
-    p_value = count/n_flip; 
-  } 
+  };
+
+  const Sign_Flip_Engine engine = this->flip_engine(1);
+  auto pvalue = [](const MatrixXr & count, unsigned long int n){ return VectorXr::Constant(1, count(0,0)/n);};
+  unsigned long int n_done;
+  MatrixXr counts;
+  if(eigen_basis){
+    counts = count_flips(1, engine, Q_loc.flip_operator(res), VectorXr::Zero(n_loc), 1, 1, counter, pvalue, 1, 1, n_done);
+  }
+  else{
+    counts = count_flips(1, engine, res.asDiagonal(), VectorXr::Zero(n_loc), 1, 1, counter, pvalue, 1, 1, n_done);
+  }
 
-  return p_value; 
+  p_value = counts(0,0)/n_done;
+
+  return p_value;
 };
 
 
@@ -623,26 +483,22 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_f_CI(void){
   // This function will be called only when the chosen locations are a subset of the mesh nodes  
   
   // compute/get all the needed objects from the inference carrier 
-  const MatrixXr W_loc = this->inf_car.getW_loc();
   const SpMat Psi_loc = this->inf_car.getPsi_loc();
   const VectorXr Z_loc = this->inf_car.getZ_loc(); 
   const UInt n_loc = this->inf_car.getN_loc(); 
   const std::vector<UInt> sub_locations_index = this->inf_car.getInfData()->get_locs_index_inference(); 
   
-  // compute Q_loc
-  MatrixXr Q_loc; 
-  Q_loc.resize(n_loc, n_loc);
-  
-  if(this->inf_car.getRegData()->getCovariates()->rows()==0){ // no covariates case
-    Q_loc = MatrixXr::Identity(n_loc, n_loc);
-  }
-  else{ // covariates case
-    MatrixXr WtW_loc = W_loc.transpose() * W_loc; 
-    Q_loc = MatrixXr::Identity(n_loc, n_loc) - W_loc * WtW_loc.ldlt().solve(W_loc.transpose());
+  // decompose Q_loc, if necessary
+  if(!is_Q_loc_computed){
+    this->Compute_Q_loc();
   }
 
   // Matrix that groups close location points, needed only when locations are nodes
   MatrixXr Group_res = this->inf_car.getGroup_loc();
+  const bool locs_are_nodes = this->inf_car.getInfData()->get_locs_are_nodes_inference();
+
+  // the eigen-sign-flip implementation flips the residuals in the basis of Q_loc
+  const bool eigen_basis = (this->inf_car.getInfData()->get_implementation_type()[this->pos_impl] == "eigen-sign-flip");
 
   // get the estimator for f in the selected locations 
   UInt nnodes = this->inf_car.getN_nodes();
@@ -686,55 +542,9 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_f_CI(void){
     UL(i)=result(i)(2)-0.5*half_range; 	
   }
 
-  // define booleans used to unserstand which CI need to be computed forward on
-  std::vector<bool> converged_up(n_loc,false);
-  std::vector<bool> converged_low(n_loc,false);
-  bool all_f_converged=false;
-
-  // matrix that stores p_values of the bounds at actual step
-  MatrixXr local_p_values;
-  local_p_values.resize(4,n_loc);
-
-  // compute the vectors needed for the statistic
-  
-  VectorXr Partial_res_H0_CI;
-  Partial_res_H0_CI.resize(n_loc);
-
-  // fill the p_values matrix
-  for (UInt i=0; i<n_loc; i++){
-
-    VectorXr f_hat_loc_UU = f_hat_loc;
-    VectorXr f_hat_loc_UL = f_hat_loc;
-    VectorXr f_hat_loc_LU = f_hat_loc;
-    VectorXr f_hat_loc_LL = f_hat_loc; 
-    
-    for(UInt j=0; j < n_loc; ++j){
-      if(Group_res(sub_locations_index[i],j) == 1){
-	f_hat_loc_UU(j) = UU(i);  
-	f_hat_loc_UL(j) = UL(i); 
-	f_hat_loc_LU(j) = LU(i); 
-	f_hat_loc_LL(j) = LL(i); 
-      }
-    }
-    
-    // compute the partial residuals and p value
-    Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_UU); 
-    local_p_values(0,i)=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-
-    // compute the partial residuals and p value
-    Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_UL);
-    local_p_values(1,i)=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-
-    // compute the partial residuals and p value
-    Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_LU);
-    local_p_values(2,i)=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-
-    // compute the partial residuals and p value
-    Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_LL);
-    local_p_values(3,i)=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-
-
-  }
+  // define flags used to unserstand which CI have converged (not std::vector<bool>, written concurrently)
+  std::vector<char> converged_up(n_loc,false);
+  std::vector<char> converged_low(n_loc,false);
 
   // extract the CI significance (1-confidence)
   Real alpha=0;
@@ -742,139 +552,46 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_f_CI(void){
   alpha=0.5*(this->inf_car.getInfData()->get_inference_alpha()(this->pos_impl));
  
   UInt Max_Iter=50;
-  UInt Count_Iter=0;
-  while((!all_f_converged) && (Count_Iter<Max_Iter)){
-  
-    // Compute all p_values (only those needed)
-    for (UInt i=0; i<n_loc; i++){
-
-      VectorXr f_hat_loc_UU = f_hat_loc;
-      VectorXr f_hat_loc_UL = f_hat_loc;
-      VectorXr f_hat_loc_LU = f_hat_loc;
-      VectorXr f_hat_loc_LL = f_hat_loc; 
-  
-      if(!converged_up[i]){
-	if(local_p_values(0,i)>alpha){ // Upper-Upper bound excessively tight
-
-	  UU(i)=UU(i)+0.5*(UU(i)-UL(i));
-	  for(UInt j=0; j < n_loc; ++j){
-	    if(Group_res(sub_locations_index[i],j) == 1){
-	      f_hat_loc_UU(j) = UU(i);  
-	    }
-	  }
-          // compute the partial residuals
-	  Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_UU); 
-	  local_p_values(0,i)=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-  
-	}else{
- 
-	  if(local_p_values(1,i)<alpha){ // Upper-Lower bound excessively tight
-	    UL(i)=f_hat_loc(i)+0.5*(UL(i)-f_hat_loc(i));
-	    for(UInt j=0; j < n_loc; ++j){
-	      if(Group_res(sub_locations_index[i],j) == 1){
-		f_hat_loc_UL(j) = UL(i);  
-	      }
-	    } 
-  
-	    // compute the partial residuals
-	    Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_UL); 
-	    local_p_values(1,i)=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-
-	  }else{//both the Upper bounds are well defined
-
-	    if(UU(i)-UL(i)<bisection_tolerances(i)){
-
-	      converged_up[i]=true;
-
-	    }else{
-
-	      Real proposal=0.5*(UU(i)+UL(i));
-              VectorXr f_hat_loc_proposal = f_hat_loc; 
-
-              for(UInt j=0; j < n_loc; ++j){
-        	if(Group_res(sub_locations_index[i],j) == 1){
-           	  f_hat_loc_proposal(j) = proposal;
-       		}
-	      }
- 
-	      // compute the partial residuals
-	      Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_proposal);
-	      Real prop_p_val=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
 
+  // In each location the partial residuals under H0 are Q_loc*(Z_loc - f_hat_loc_mod), f_hat_loc_mod being f_hat_loc with the value v in the group of
+  // the location: they are affine in v, hence the flipped statistics are drawn once for each location and reused by all the steps of the bisections.
+  // The locations are independent of each other and are processed in parallel.
+  #pragma omp parallel for schedule(dynamic)
+  for(long int i=0; i<long(n_loc); ++i){
+    const UInt current_index = sub_locations_index[i];
 
-	      if(prop_p_val<=alpha){UU(i)=proposal; local_p_values(0,i)=prop_p_val;}else{UL(i)=proposal;local_p_values(1,i)=prop_p_val;}
-	    }
-	  }
-	}
+    // indicator of the group of the location
+    VectorXr group = VectorXr::Zero(n_loc);
+    for(UInt j=0; j < n_loc; ++j){
+      if(Group_res(current_index,j) == 1){
+	group(j) = 1;
       }
+    }
 
+    // partial residuals: Q_loc*(Z_loc - f_hat_loc out of the group) - v*Q_loc*group
+    const VectorXr res_base = Q_loc.project(Z_loc - f_hat_loc.cwiseProduct(VectorXr::Ones(n_loc) - group));
+    const VectorXr res_slope = -Q_loc.project(group);
 
-      if(!converged_low[i]){
-	if(local_p_values(2,i)<alpha){ // Lower-Upper bound excessively tight
-
-	  LU(i)=f_hat_loc(i)-0.5*(f_hat_loc(i)-LU(i));
-          for(UInt j=0; j < n_loc; ++j){
-	    if(Group_res(sub_locations_index[i],j) == 1){
-	      f_hat_loc_LU(j) = LU(i);  
-	    }
-	  }
-  
-	  // compute the partial residuals
-	  Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_LU);
-	  local_p_values(2,i)=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-  
-	}else{
- 
-	  if(local_p_values(3,i)>alpha){ // Lower-Lower bound excessively tight
-	    LL(i)=LL(i)-0.5*(LU(i)-LL(i));
-            for(UInt j=0; j < n_loc; ++j){
-	      if(Group_res(sub_locations_index[i],j) == 1){
-		f_hat_loc_LL(j) = LL(i);  
-	      }
-	    }
-  
-	    // compute the partial residuals
-	    Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_LL);
-	    local_p_values(3,i)=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-
-	  }else{//both the Upper bounds are well defined
-
-	    if(LU(i)-LL(i)<bisection_tolerances(i)){
-
-	      converged_low[i]=true;
-
-	    }else{
-
-	      Real proposal=0.5*(LU(i)+LL(i));
-              VectorXr f_hat_loc_proposal = f_hat_loc; 
-
-              for(UInt j=0; j < n_loc; ++j){
-        	if(Group_res(sub_locations_index[i],j) == 1){
-           	  f_hat_loc_proposal(j) = proposal;
-       		}
-	      }
- 
-   
-	      // compute the partial residuals
-	      Partial_res_H0_CI = Q_loc*(Z_loc - f_hat_loc_proposal);
-	      Real prop_p_val=compute_CI_aux_f_pvalue(Partial_res_H0_CI, sub_locations_index[i]);
-
-	      if(prop_p_val<=alpha){LL(i)=proposal; local_p_values(3,i)=prop_p_val;}else{LU(i)=proposal;local_p_values(2,i)=prop_p_val;}
-	    }
-	  }
-	}
-      }
+    // row of the statistics operator in the current location
+    MatrixXr A;
+    if(locs_are_nodes){
+      A = Group_res.row(current_index);
     }
-    all_f_converged =true;
-    for(UInt j=0; j<n_loc; j++){
-
-      if(!converged_up[j] || !converged_low[j]){
-	all_f_converged=false;
-      }
+    else{
+      A = MatrixXr(Psi_loc.col(current_index)).transpose();
     }
 
-    Count_Iter++;
+    const Sign_Flip_Line line = compute_CI_aux_f_line(res_base, res_slope, A, eigen_basis);
+
+    converged_up[i] = line.search_bound(f_hat_loc(i), UL(i), UU(i), bisection_tolerances(i), alpha, Max_Iter);
+    converged_low[i] = line.search_bound(f_hat_loc(i), LU(i), LL(i), bisection_tolerances(i), alpha, Max_Iter);
+  }
 
+  bool all_f_converged =true;
+  for(UInt j=0; j<n_loc; j++){
+    if(!converged_up[j] || !converged_low[j]){
+      all_f_converged=false;
+    }
   }
 
   // give a warning in R if at least one interval did not converge
@@ -917,6 +634,7 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_CI(void){
       Rprintf("error: failed FSPAI inversion in confidence intervals computation, discarding inference");
       MatrixXv result;
       MatrixXr C = this->inf_car.getInfData()->get_coeff_inference();
+      result.resize(1, C.rows());
       for(UInt i=0; i<C.rows(); ++i){
 	result(i).resize(3);
 
@@ -933,7 +651,6 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_CI(void){
   
   // Store beta_hat
   VectorXr beta_hat = (*(this->inf_car.getBeta_hatp()));
-  VectorXr beta_hat_mod=beta_hat;
 
   // get the matrix of coefficients
   MatrixXr C = this->inf_car.getInfData()->get_coeff_inference();
@@ -946,8 +663,10 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_CI(void){
     }
   }
 
-  // compute eigenvectors and eigenvalues of Lambda
-  Eigen::SelfAdjointEigenSolver<MatrixType> Lambda_dec(Lambda);
+  // compute eigenvectors and eigenvalues of Lambda, if not already done for the tests or the intervals
+  if(!is_Lambda_dec_computed){
+    this->Compute_Lambda_dec();
+  }
   
   // extract covariates matrices
   const MatrixXr * W = this->inf_car.getWp();
@@ -990,14 +709,9 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_CI(void){
     UL(i)=result(i)(2)-0.5*half_range; 	
   }
 
-  // define booleans used to unserstand which CI need to be computed forward on
-  std::vector<bool> converged_up(p,false);
-  std::vector<bool> converged_low(p,false);
-  bool all_betas_converged=false;
-
-  // matrix that stores p_values of the bounds at actual step
-  MatrixXr local_p_values;
-  local_p_values.resize(4,p);
+  // define flags used to unserstand which CI have converged (not std::vector<bool>, written concurrently)
+  std::vector<char> converged_up(p,false);
+  std::vector<char> converged_low(p,false);
   
   // compute the vectors needed for the statistic
   MatrixXr TildeX = (W->transpose()) * Lambda_dec.eigenvectors()*Lambda_dec.eigenvalues().asDiagonal();   	// W^t * V * D
@@ -1005,35 +719,19 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_CI(void){
 
   // Seclect eigenvalues that will not be flipped basing on the estimated bias carried
   VectorXr Tilder_hat = Lambda_dec.eigenvectors().transpose()* (*(this->inf_car.getZp()) - (*W)* beta_hat); // This vector represents Tilder using only beta_hat, needed for bias estimation
+  const std::vector<bool> fixed = fixed_components(Tilder_hat);
 
-  VectorXr Partial_res_H0_CI;
-  Partial_res_H0_CI.resize(Lambda.cols());
-
-  // fill the p_values matrix
-  for (UInt i=0; i<p; i++){
-    MatrixXr TildeX_loc= TildeX.row(beta_in_test[i]);
-    beta_hat_mod = beta_hat;
-
-    // compute the partial residuals and p value
-    beta_hat_mod(beta_in_test[i])=UU(i); // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-    Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*UU[i](in test))
-    local_p_values(0,i)=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-
-    // compute the partial residuals and p value
-    beta_hat_mod(beta_in_test[i])=UL(i); // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-    Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*UL[i](in test))
-    local_p_values(1,i)=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-
-    // compute the partial residuals and p value
-    beta_hat_mod(beta_in_test[i])=LU(i); // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-    Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*LU[i](in test))
-    local_p_values(2,i)=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-
-    // compute the partial residuals and p value
-    beta_hat_mod(beta_in_test[i])=LL(i); // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-    Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*LL[i](in test))
-    local_p_values(3,i)=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-
+  // The partial residuals under H0 are z - W*beta_hat_mod, beta_hat_mod being beta_hat with the value v in the beta in test: they are affine in v,
+  // hence the flipped statistics are drawn once for each beta and reused by all the steps of the bisections
+  const VectorXr eps_hat = *(this->inf_car.getZp()) - (*W) * beta_hat;
+  std::vector<Sign_Flip_Line> lines;
+  lines.reserve(p);
+  for(UInt i=0; i<p; i++){
+    const UInt k = beta_in_test[i];
+    // (z-W*beta_hat(non in test)) - v*W(in test)
+    const VectorXr res_base = eps_hat + beta_hat(k)*W->col(k);
+    const VectorXr res_slope = -W->col(k);
+    lines.push_back(compute_CI_aux_beta_line(res_base, res_slope, TildeX.row(k), fixed, Tilder_star));
   }
 
   // extract the CI significance (1-confidence)
@@ -1046,115 +744,31 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_CI(void){
   }
     
   UInt Max_Iter=50;
-  UInt Count_Iter=0;
-  while((!all_betas_converged) & (Count_Iter<Max_Iter)){
-  
-    // Compute all p_values (only those needed)
-    for (UInt i=0; i<p; i++){
-
-      MatrixXr TildeX_loc= TildeX.row(beta_in_test[i]);
-      beta_hat_mod = beta_hat;
-  
-      if(!converged_up[i]){
-	if(local_p_values(0,i)>alpha){ // Upper-Upper bound excessively tight
-
-	  UU(i)=UU(i)+0.5*(UU(i)-UL(i));
-  
-	  // compute the partial residuals
-          beta_hat_mod(beta_in_test[i])=UU(i); // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-	  Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*UU[i](in test))
-	  local_p_values(0,i)=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-  
-	}else{
- 
-	  if(local_p_values(1,i)<alpha){ // Upper-Lower bound excessively tight
-	    UL(i)=beta_hat(beta_in_test[i])+0.5*(UL(i)-beta_hat(beta_in_test[i]));
-  
-	    // compute the partial residuals
-            beta_hat_mod(beta_in_test[i])=UL(i); // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-	    Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*UL[i](in test))
-	    local_p_values(1,i)=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-
-	  }else{//both the Upper bounds are well defined
 
-	    if(UU(i)-UL(i)<ESF_bisection_tolerances(i)){
-
-	      converged_up[i]=true;
-
-	    }else{
-
-	      Real proposal=0.5*(UU(i)+UL(i));
-   
-	      // compute the partial residuals
-              beta_hat_mod(beta_in_test[i])=proposal; // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-	      Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*proposal)
-	      Real prop_p_val=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-
-	      if(prop_p_val<=alpha){UU(i)=proposal; local_p_values(0,i)=prop_p_val;}else{UL(i)=proposal;local_p_values(1,i)=prop_p_val;}
-	    }
-	  }
-	}
-      }
-
-
-      if(!converged_low[i]){
-	if(local_p_values(2,i)<alpha){ // Lower-Upper bound excessively tight
-
-	  LU(i)=beta_hat(beta_in_test[i])-0.5*(beta_hat(beta_in_test[i])-LU(i));
-  
-	  // compute the partial residuals
-          beta_hat_mod(beta_in_test[i])=LU(i); // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-	  Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*LU[i](in test))
-	  local_p_values(2,i)=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-  
-	}else{
- 
-	  if(local_p_values(3,i)>alpha){ // Lower-Lower bound excessively tight
-	    LL(i)=LL(i)-0.5*(LU(i)-LL(i));
-  
-	    // compute the partial residuals
-            beta_hat_mod(beta_in_test[i])=LL(i); // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-	    Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*LL[i](in test))
-	    local_p_values(3,i)=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-
-	  }else{//both the Upper bounds are well defined
-
-	    if(LU(i)-LL(i)<ESF_bisection_tolerances(i)){
-
-	      converged_low[i]=true;
-
-	    }else{
-
-	      Real proposal=0.5*(LU(i)+LL(i));
-   
-	      // compute the partial residuals
-              beta_hat_mod(beta_in_test[i])=proposal; // beta_hat_mod(i) = beta_hat(i) if i not in test; beta_HP otherwise
-	      Partial_res_H0_CI = *(this->inf_car.getZp()) - (*W) * (beta_hat_mod); // (z-W*beta_hat(non in test)-W*proposal)
-	      Real prop_p_val=compute_CI_aux_beta_pvalue(Partial_res_H0_CI, TildeX_loc, Tilder_hat, Tilder_star);
-
-	      if(prop_p_val<=alpha){LL(i)=proposal; local_p_values(3,i)=prop_p_val;}else{LU(i)=proposal;local_p_values(2,i)=prop_p_val;}
-	    }
-	  }
-	}
-      }
+  // the upper (even tasks) and lower (odd tasks) bounds of all the betas are independent searches, carried out in parallel
+  #pragma omp parallel for schedule(dynamic)
+  for(long int t=0; t<2*long(p); ++t){
+    const UInt i = t/2;
+    const Real center = beta_hat(beta_in_test[i]);
+    if(t%2==0){
+      converged_up[i] = lines[i].search_bound(center, UL(i), UU(i), ESF_bisection_tolerances(i), alpha, Max_Iter);
+    }else{
+      converged_low[i] = lines[i].search_bound(center, LU(i), LL(i), ESF_bisection_tolerances(i), alpha, Max_Iter);
     }
-    all_betas_converged =true;
-    for(UInt j=0; j<p; j++){
+  }
 
-      if(!converged_up[j] || !converged_low[j]){
-	all_betas_converged=false;
-      }
+  bool all_betas_converged =true;
+  for(UInt j=0; j<p; j++){
+    if(!converged_up[j] || !converged_low[j]){
+      all_betas_converged=false;
     }
-
-    Count_Iter++;
-
   }
    
   // for each row of C matrix
   for(UInt i=0; i<p; ++i){
     result(i).resize(3);
     
-    if(Count_Iter < Max_Iter){ // No discrepancy between beta_hat(i) and ESF, bisection converged
+    if(all_betas_converged){ // No discrepancy between beta_hat(i) and ESF, bisection converged
       // Central element
       result(i)(1)=beta_hat(beta_in_test[i]);
       
@@ -1177,25 +791,45 @@ MatrixXv Eigen_Sign_Flip_Base<InputHandler, MatrixType>::compute_beta_CI(void){
 
 template<typename InputHandler, typename MatrixType> 
 void Eigen_Sign_Flip_Exact<InputHandler, MatrixType>::compute_Lambda(void){
-  this->inverter->Compute_Inv();
-  // extract the inverse of E
-  const MatrixType * E_inv = this->inverter->getInv();
   // extract areal matrix (VectorXr)
   const VectorXr * A = this->inf_car.getAp();
   
   UInt n_obs = this->inf_car.getN_obs();
-  UInt n_nodes = this->inf_car.getN_nodes();
   const SpMat * Psi = this->inf_car.getPsip();
   const SpMat * Psi_t = this->inf_car.getPsi_tp();
-  UInt q = this->inf_car.getq(); 
+
+  // right hand side Psi^t*A: MatrixNoCov is solved only against the columns of the observations, never against the identity
+  SpMat Psi_tA = (this->inf_car.getRegData()->getNumberOfRegions()>0) ? SpMat((*Psi_t)*(A->asDiagonal())) : *Psi_t;
   
   this->Lambda.resize(n_obs,n_obs);
 
-  if(this->inf_car.getRegData()->getNumberOfRegions()>0){
-    this->Lambda = (MatrixXr::Identity(n_obs,n_obs) - (*Psi)*((*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t)*(A->asDiagonal()))); // I - Psi(Psi^T A Psi + P)^-1 Psi^T A
-  }else{
-    this->Lambda = (MatrixXr::Identity(n_obs,n_obs) - (*Psi)*((*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t))); // I - Psi(Psi^T Psi + P)^-1 Psi^T
+  // I - Psi(Psi^T A Psi + P)^-1 Psi^T A, by blocks of columns
+  for(UInt first_col=0; first_col<n_obs; first_col+=block_size){
+    UInt n_cols = std::min(block_size, n_obs-first_col);
+    this->Lambda.middleCols(first_col, n_cols) = -(*Psi)*(this->inverter->apply_upper_left_block(SpMat(Psi_tA.middleCols(first_col, n_cols))));
   }
+  this->Lambda.diagonal().array() += 1;
+  this->is_Lambda_computed = true;
+  
+  return; 
+};
+
+template<typename InputHandler, typename MatrixType> 
+void Eigen_Sign_Flip_Non_Exact<InputHandler, MatrixType>::compute_Lambda(void){
+  // extract areal matrix (VectorXr)
+  const VectorXr * A = this->inf_car.getAp();
+  
+  UInt n_obs = this->inf_car.getN_obs();
+  const SpMat * Psi = this->inf_car.getPsip();
+  const SpMat * Psi_t = this->inf_car.getPsi_tp();
+
+  SpMat Psi_tA = (this->inf_car.getRegData()->getNumberOfRegions()>0) ? SpMat((*Psi_t)*(A->asDiagonal())) : *Psi_t;
+  
+  this->Lambda.resize(n_obs,n_obs);
+  this->Lambda.setIdentity();
+
+  // I - Psi(Psi^T A Psi + P)^-1 Psi^T A, sparse since the inverter applies the sparse approximate upper left block of the inverse of E
+  this->Lambda -= (*Psi)*(this->inverter->apply_upper_left_block(Psi_tA));
   this->is_Lambda_computed = true;
   
   return; 
@@ -17,7 +17,7 @@ class InferenceData
   		std::vector<std::string> interval_Type  	= {"not-defined"};	        //!< Values: not-defined [default], one-at-the-time, simultaneous, bonferroni
   		std::vector<std::string> implementation_Type  	= {"wald"}; 	                //!< Values: wald [default], speckman, sign-flip, eigen-sign-flip
 		std::vector<std::string> component_Type		= {"parametric"};		//!< Values: parametric [default], nonparametric, both
-  		std::string exact_Inference			= "exact";		        //!< Values: exact [default], non-exact (not implemented in this version)
+  		std::string exact_Inference			= "exact";		        //!< Values: exact [default], non-exact (sparse approximate inverse of MatrixNoCov)
 		std::vector<bool> enhanced_Inference		= {false};			//!< Values: false [default], true 
 		// Parameters needed
 		MatrixXr locs_Inference;							//!< Matrix of spatial locations to be considered for nonparametric inference
@@ -32,6 +32,8 @@ class InferenceData
 		VectorXr inference_Alpha                        = VectorXr::Constant(1,0.05); 	//!< Significance used in ESF confidence interval computation;
   		bool definition					= false;			//!< Defines whether the inference analysis needs to be carried out or not
                 long int n_Flip 				= 1000; 			//!< Number of sign-flips if eigen-sign-flip tests are required
+		UInt seed_Flip				= 0;				//!< Seed of the sign-flips, 0 meaning a random seed
+		Real mc_Error				= 0;				//!< Error probability of the early stopping of the sign-flip tests, 0 meaning that all the sign-flips are performed
 		Real tol_Fspai 					= 0.05; 			//!< Tolerance given in input to the FSPAI algorithm
 
 	public:
@@ -41,11 +43,11 @@ class InferenceData
                 //! Space constructor
   		InferenceData(SEXP test_Type_, SEXP interval_Type_, SEXP implementation_Type_, SEXP component_Type_,
 				SEXP exact_Inference_,SEXP locs_Inference_, SEXP locs_index_Inference_, SEXP locs_are_nodes, SEXP coeff_Inference_, SEXP beta_0_,
-				SEXP f0_eval_, SEXP f_Var_, SEXP inference_Quantile_, SEXP inference_Alpha_, SEXP n_Flip_, SEXP tol_Fspai_, SEXP definition_);
+				SEXP f0_eval_, SEXP f_Var_, SEXP inference_Quantile_, SEXP inference_Alpha_, SEXP n_Flip_, SEXP seed_Flip_, SEXP mc_Error_, SEXP tol_Fspai_, SEXP definition_);
                 //! Space-time constructor (with time locations used for Wald inference on f)
                 InferenceData(SEXP test_Type_, SEXP interval_Type_, SEXP implementation_Type_, SEXP component_Type_,
                 		SEXP exact_Inference_,SEXP locs_Inference_, SEXP locs_index_Inference_, SEXP locs_are_nodes, SEXP time_locs_inf_, SEXP coeff_Inference_, SEXP beta_0_,
-                		SEXP f0_eval_, SEXP f_Var_, SEXP inference_Quantile_, SEXP inference_Alpha_, SEXP n_Flip_, SEXP tol_Fspai_, SEXP definition_);
+                		SEXP f0_eval_, SEXP f_Var_, SEXP inference_Quantile_, SEXP inference_Alpha_, SEXP n_Flip_, SEXP seed_Flip_, SEXP mc_Error_, SEXP tol_Fspai_, SEXP definition_);
                 
                 
         //Setters
@@ -67,6 +69,8 @@ class InferenceData
 		inline void set_inference_Alpha(const VectorXr & inference_Alpha_){inference_Alpha=inference_Alpha_;}; 		//!< Setter for inference_Alpha \param inference_Alpha_ new inference_Alpha
   		inline void set_definition(const bool & definition_){definition = definition_;};				//!< Setter for definition \param definition_ new definition
 		inline void set_n_Flip(long int n_Flip_){n_Flip=n_Flip_;}; 							//!< Setter for n_Flip \param n_Flip_ new n_Flip
+		inline void set_seed_Flip(UInt seed_Flip_){seed_Flip=seed_Flip_;}; 							//!< Setter for seed_Flip \param seed_Flip_ new seed_Flip
+		inline void set_mc_Error(Real mc_Error_){mc_Error=mc_Error_;}; 							//!< Setter for mc_Error \param mc_Error_ new mc_Error
 		inline void set_tol_Fspai(Real tol_Fspai_){tol_Fspai=tol_Fspai_;}; 						//!< Setter for tol_Fspai \param tol_Fspai_ new tol_Fspai
 
   	//Getters
@@ -88,6 +92,8 @@ class InferenceData
 		inline VectorXr get_inference_alpha() const{return this->inference_Alpha;}; 			                //!< Getter for inference_Alpha \return inference_Alpha
   		inline bool get_definition() const{return this->definition;};					                //!< Getter for definition \return definition
 		inline long int get_n_Flip() const{return this->n_Flip;}; 					                //!< Getter for n_Flip \return n_Flip
+		inline UInt get_seed_Flip() const{return this->seed_Flip;}; 					                //!< Getter for seed_Flip \return seed_Flip
+		inline Real get_mc_Error() const{return this->mc_Error;}; 					                //!< Getter for mc_Error \return mc_Error
 		inline Real get_tol_Fspai() const{return this->tol_Fspai;}; 					                //!< Getter for tol_Fspai \return tol_Fspai
 
 	//For debugging
@@ -12,38 +12,40 @@
 
 //! A Factory class: A class for the choice of implementation for the computation of inferential objects.
 /* \tparam InputHandler RegressionData of the problem
- * \tparam MatrixType the parameter that characterises the inverter object
+ * \tparam MatrixType the parameter that characterises the inverter object: MatrixXr selects the exact implementations, SpMat the non-exact ones
  */
 template<typename InputHandler, typename MatrixType>
 class Inference_Factory
 {
 private:
-  //!< Getter of the Inference_Factory
-  static std::map<std::string,std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>& get_Factory_Store(void)
+  //! A method that builds the exact or the non-exact version of an implementation, according to the type of the inverse of MatrixNoCov
+  template<template<typename, typename> class Exact, template<typename, typename> class Non_Exact>
+  static std::shared_ptr<Inference_Base<InputHandler, MatrixType>> make_method(Inference_Workspace<InputHandler, MatrixType> & workspace_, UInt pos_impl_)
   {
-    static std::map<std::string,std::shared_ptr<Inference_Base<InputHandler, MatrixType>>> factory_Store; // initialize the static map
-    return factory_Store;
+    if constexpr(std::is_same<MatrixType, SpMat>::value)
+      return std::make_shared<Non_Exact<InputHandler, MatrixType>>(workspace_, pos_impl_);
+    else
+      return std::make_shared<Exact<InputHandler, MatrixType>>(workspace_, pos_impl_);
   }
 
 public:
-  //! A method that takes as parameter a string and builds a pointer to the right implementation object. If the same implementation is required more than once, the same unique object is returned and reused. 
+  //! A method that takes as parameter a string and builds a pointer to the right implementation object. If the same implementation is required more than once in the same call, the same unique object, stored in the workspace, is returned and reused. 
   /*!
     \param implementation_type_ type of implementation required
-    \param inverter_ class demanded to the computation of MatrixNoCov inverse
-    \param inf_car_ inference carrier object
+    \param workspace_ workspace of the current call, that wraps the inference carrier and the inverter of MatrixNoCov
     \param pos_impl_ the position index of the current inferential procedure
     \return std::shared_ptr to the chosen solver
   */
-  static std::shared_ptr<Inference_Base<InputHandler, MatrixType>> create_inference_method(const std::string & implementation_type_, std::shared_ptr<Inverse_Base<MatrixType>> inverter_, const Inference_Carrier<InputHandler> & inf_car_, UInt pos_impl_)
+  static std::shared_ptr<Inference_Base<InputHandler, MatrixType>> create_inference_method(const std::string & implementation_type_, Inference_Workspace<InputHandler, MatrixType> & workspace_, UInt pos_impl_)
   {
-    std::map<std::string,std::shared_ptr<Inference_Base<InputHandler, MatrixType>>> factory_Store=get_Factory_Store(); // Get the static factory
+    std::map<std::string,std::shared_ptr<Inference_Base<InputHandler, MatrixType>>> & factory_Store=workspace_.getMethods_Store(); // Get the store of the current call
     
     if(implementation_type_=="wald"){
       // look if the object is already present in the factory
       auto It = factory_Store.find("wald_exact");
       // if not, insert the new object
       if(It==factory_Store.end()){
-	factory_Store.insert(std::make_pair<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>("wald_exact", std::make_shared<Wald_Exact<InputHandler, MatrixType>>(inverter_, inf_car_, pos_impl_)));
+	factory_Store.insert(std::make_pair<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>("wald_exact", make_method<Wald_Exact, Wald_Non_Exact>(workspace_, pos_impl_)));
       }else{
 	// if it is already in the factory, just update the pos_impl
 	It->second->setpos_impl(pos_impl_);
@@ -56,7 +58,7 @@ public:
       auto It = factory_Store.find("speckman_exact");
       // if not, insert the new object
       if(It==factory_Store.end()){
-	factory_Store.insert(std::make_pair<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>("speckman_exact", std::make_shared<Speckman_Exact<InputHandler, MatrixType>>(inverter_, inf_car_, pos_impl_)));
+	factory_Store.insert(std::make_pair<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>("speckman_exact", make_method<Speckman_Exact, Speckman_Non_Exact>(workspace_, pos_impl_)));
       }else{
 	// if it is already in the factory, just update the pos_impl
 	It->second->setpos_impl(pos_impl_);
@@ -69,7 +71,7 @@ public:
       auto It = factory_Store.find("eigen-sign-flip_exact");
       // if not, insert the new object
       if(It==factory_Store.end()){
-	factory_Store.insert(std::make_pair<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>("eigen-sign-flip_exact", std::make_shared<Eigen_Sign_Flip_Exact<InputHandler, MatrixType>>(inverter_, inf_car_, pos_impl_)));
+	factory_Store.insert(std::make_pair<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>("eigen-sign-flip_exact", make_method<Eigen_Sign_Flip_Exact, Eigen_Sign_Flip_Non_Exact>(workspace_, pos_impl_)));
       }else{
 	// if it is already in the factory, just update the pos_impl
 	It->second->setpos_impl(pos_impl_);
@@ -81,7 +83,7 @@ public:
 	Rprintf("Implementation not found, using wald exact");
 	auto It = factory_Store.find("wald_exact");
 	if(It==factory_Store.end()){
-	  factory_Store.insert(std::make_pair<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>("wald_exact", std::make_shared<Wald_Exact<InputHandler, MatrixType>>(inverter_, inf_car_, pos_impl_)));
+	  factory_Store.insert(std::make_pair<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>>("wald_exact", make_method<Wald_Exact, Wald_Non_Exact>(workspace_, pos_impl_)));
 	}else{
 	  It->second->setpos_impl(pos_impl_);
 	}
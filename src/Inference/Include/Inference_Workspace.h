@@ -0,0 +1,63 @@
+#ifndef __INFERENCE_WORKSPACE_H__
+#define __INFERENCE_WORKSPACE_H__
+
+// HEADERS
+#include "../../FdaPDE.h"
+#include "Inference_Carrier.h"
+#include "Inverter.h"
+#include <map>
+#include <memory>
+#include <string>
+
+template<typename InputHandler, typename MatrixType>
+class Inference_Base;
+
+// *** Inference_Workspace Class ***
+//! Quantities shared by all the inferential procedures required on the same fitted model
+/*!
+  This template class is built once for each inferential call, alongside with the inverter of MatrixNoCov. It stores the implementation objects built by the Inference_Factory, one for each implementation type,
+  so that an implementation required more than once, or used by another one (as Wald by eigen-sign-flip for its f intervals), reuses everything it has already computed. Moreover it lazily computes, at most once,
+  the quantities needed by more than one implementation: the residuals of the fitted model and the Speckman quantities, i.e. the products of the smoother Lambda = I - Psi*(Psi^t*A*Psi + lambda*R)^-1*Psi^t*A and of its transpose
+  with the design matrix W, the decomposition of W^t*Lambda^2*W = (Lambda^t*W)^t*(Lambda*W) and the sandwich variance-covariance matrix of the Speckman estimator. Lambda is never assembled: it is applied to blocks of vectors through
+  the upper left block of the inverse of MatrixNoCov, as provided by the inverter.
+  \tparam InputHandler the type of regression problem needed to determine the MixedFERegressionBase object type in Inference_Carrier<InputHandler>
+  \tparam MatrixType the type of the inverse of MatrixNoCov, MatrixXr for exact inference and SpMat for non-exact inference
+*/
+template<typename InputHandler, typename MatrixType>
+class Inference_Workspace{
+private:
+  const Inference_Carrier<InputHandler> & inf_car;	 				//!< Inference carrier that contains all the information needed for inference
+  std::shared_ptr<Inverse_Base<MatrixType>> inverter;	 				//!< Pointer to inverter object that computes the inverse of matrixNoCov in exact/non-exact way
+  std::map<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>> methods_Store;	//!< Implementation objects already built for this call
+  VectorXr eps_hat;									//!< Residuals of the fitted model, z - z_hat
+  bool is_eps_hat_computed = false;							//!< Boolean that tells whether eps_hat has been computed or not
+  MatrixXr Lambda_W;									//!< Lambda*W [size n_obs x q]
+  MatrixXr Lambda_t_W;									//!< Lambda^t*W [size n_obs x q]
+  Eigen::PartialPivLU<MatrixXr> WLW_dec;						//!< Decomposition of [W^t * Lambda^2 * W]
+  bool is_WLW_computed = false;								//!< Boolean that tells whether Lambda*W, Lambda^t*W and the WLW decomposition have been computed or not
+  MatrixXr V_Speckman;									//!< Variance-Covariance matrix of the Speckman estimator of the beta parameters
+  bool is_V_Speckman_computed = false;							//!< Boolean that tells whether V_Speckman has been computed or not
+  void compute_WLW_dec(void);								//!< Method that computes Lambda*W, Lambda^t*W and the WLW decomposition
+
+public:
+  // CONSTUCTOR
+  Inference_Workspace()=delete;	//The default constructor is deleted
+  Inference_Workspace(const Inference_Carrier<InputHandler> & inf_car_, std::shared_ptr<Inverse_Base<MatrixType>> inverter_):inf_car(inf_car_), inverter(inverter_){}; //Main constructor of the class
+
+  // GETTERS
+  inline const Inference_Carrier<InputHandler> & getInf_car (void) const {return inf_car;}		//!< Getter of inf_car \return inf_car
+  inline std::shared_ptr<Inverse_Base<MatrixType>> getInverter (void) const {return inverter;}		//!< Getter of inverter \return inverter
+  inline std::map<std::string, std::shared_ptr<Inference_Base<InputHandler, MatrixType>>> & getMethods_Store (void) {return methods_Store;}	//!< Getter of the store of the implementation objects \return methods_Store
+  const VectorXr & getEps_hat (void);							//!< Getter of eps_hat, computed if needed \return eps_hat
+  const MatrixXr & getLambda_W (void);							//!< Getter of Lambda*W, computed if needed \return Lambda_W
+  const MatrixXr & getLambda_t_W (void);						//!< Getter of Lambda^t*W, computed if needed \return Lambda_t_W
+  const Eigen::PartialPivLU<MatrixXr> & getWLW_dec (void);				//!< Getter of the WLW decomposition, computed if needed \return WLW_dec
+  const MatrixXr & getV_Speckman (void);						//!< Getter of the Speckman variance-covariance matrix, computed if needed \return V_Speckman
+
+  //! Method that applies Lambda (or its transpose) to the columns of X
+  MatrixXr apply_Lambda(const MatrixXr & X, bool transpose) const;
+};
+
+#include "Inference_Workspace_imp.h"
+
+#endif
@@ -0,0 +1,82 @@
+#include "Inference_Workspace.h"
+
+template<typename InputHandler, typename MatrixType>
+MatrixXr Inference_Workspace<InputHandler, MatrixType>::apply_Lambda(const MatrixXr & X, bool transpose) const{
+  // Lambda = I - Psi*E_inv(0:n_nodes,0:n_nodes)*Psi^t*A, the block of the inverse being symmetric since MatrixNoCov is
+  const SpMat * Psi = inf_car.getPsip();
+  const SpMat * Psi_t = inf_car.getPsi_tp();
+  const VectorXr * A = inf_car.getAp();
+  bool areal = inf_car.getRegData()->getNumberOfRegions()>0;
+
+  if(!transpose){
+    return X - (*Psi)*inverter->apply_upper_left_block(areal ? MatrixXr((*Psi_t)*(A->asDiagonal()*X)) : MatrixXr((*Psi_t)*X));
+  }
+  MatrixXr Psi_E_inv_Psi_t_X = (*Psi)*inverter->apply_upper_left_block((*Psi_t)*X);
+  if(areal){
+    return X - A->asDiagonal()*Psi_E_inv_Psi_t_X;
+  }
+  return X - Psi_E_inv_Psi_t_X;
+};
+
+template<typename InputHandler, typename MatrixType>
+const VectorXr & Inference_Workspace<InputHandler, MatrixType>::getEps_hat(void){
+  if(!is_eps_hat_computed){
+    eps_hat = (*(inf_car.getZp())) - inf_car.getZ_hat();
+    is_eps_hat_computed = true;
+  }
+  return eps_hat;
+};
+
+template<typename InputHandler, typename MatrixType>
+void Inference_Workspace<InputHandler, MatrixType>::compute_WLW_dec(void){
+  // compute the decomposition of W^T*Lambda^2*W = (Lambda^t*W)^t*(Lambda*W)
+  const MatrixXr * W = inf_car.getWp();
+  Lambda_W = apply_Lambda(*W, false);
+  Lambda_t_W = apply_Lambda(*W, true);
+  WLW_dec.compute(Lambda_t_W.transpose()*Lambda_W);
+  is_WLW_computed = true;
+};
+
+template<typename InputHandler, typename MatrixType>
+const MatrixXr & Inference_Workspace<InputHandler, MatrixType>::getLambda_W(void){
+  if(!is_WLW_computed){
+    compute_WLW_dec();
+  }
+  return Lambda_W;
+};
+
+template<typename InputHandler, typename MatrixType>
+const MatrixXr & Inference_Workspace<InputHandler, MatrixType>::getLambda_t_W(void){
+  if(!is_WLW_computed){
+    compute_WLW_dec();
+  }
+  return Lambda_t_W;
+};
+
+template<typename InputHandler, typename MatrixType>
+const Eigen::PartialPivLU<MatrixXr> & Inference_Workspace<InputHandler, MatrixType>::getWLW_dec(void){
+  if(!is_WLW_computed){
+    compute_WLW_dec();
+  }
+  return WLW_dec;
+};
+
+template<typename InputHandler, typename MatrixType>
+const MatrixXr & Inference_Workspace<InputHandler, MatrixType>::getV_Speckman(void){
+  if(!is_V_Speckman_computed){
+    if(!is_WLW_computed){
+      compute_WLW_dec();
+    }
+    // squared residuals
+    VectorXr Res2 = getEps_hat().array()*getEps_hat().array();
+
+    // W^t*Lambda^2*Res2*Lambda^2*W = (Lambda^t*Lambda^t*W)^t*Res2*(Lambda*Lambda*W)
+    const MatrixXr Lambda2_W = apply_Lambda(Lambda_W, false);
+    const MatrixXr Lambda2_t_W = apply_Lambda(Lambda_t_W, true);
+
+    UInt q = inf_car.getq();
+    V_Speckman = WLW_dec.solve(Lambda2_t_W.transpose()*Res2.asDiagonal()*Lambda2_W*WLW_dec.solve(MatrixXr::Identity(q,q))); // V = [(W*Lambda2*W)^-1 * W*Lambda2*Res2*Lambda2*W * (W*Lambda2*W)^-1]
+    is_V_Speckman_computed = true;
+  }
+  return V_Speckman;
+};
@@ -8,25 +8,20 @@
 // *** Inverse_Base Class ***
 //! Class for the inversion of sparse matrices in inference framework
 /*!
-  \tparam MatrixType the type of the inverse of MatrixNoCov, it will be either MatrixXr or SpMat 
-  This template class provides the base for the classes that are used to compute the exact or non exact inverse of sparse matrices needed for inferential work
+  \tparam MatrixType the type of the inverse of MatrixNoCov, it will be either MatrixXr (exact) or SpMat (sparse approximation)
+  This template class provides the base for the classes that apply the exact or non exact inverse of sparse matrices needed for inferential work
   The class is pure virtual, as one needs to specify the policy of inversion by using one of its derivation (inverse_Exact or inverse_Non_Exact)
-  In this CRAN version only Exact inversion is actually implemented
 */
 template<typename MatrixType>
 class Inverse_Base {
-protected:
-  MatrixType E_inv; 			//!< Matrix that stores the inverse when it has been computed
-  bool inverse_computed = false;
-
 public:
   // Constructor
   Inverse_Base() = default;		//!< Default constructor
 		
   // Getters
-  inline const MatrixType * getInv(void){if(inverse_computed==false){Compute_Inv();} return &E_inv;}; 	//!< Getter for the Inverse Matrix [Needs to call Compute_Inv() before calling this]
   virtual inline bool get_status_inverse (void) const {return true;} 					//!< Virtual method that will be overriden by the Non_Exact derived class to get the FSPAI status
-  virtual void Compute_Inv (void) = 0; 						     			//!< Pure virtual function for the computation of the inverse matrix
+  virtual MatrixXr apply_upper_left_block (const MatrixXr & B) = 0;					//!< Pure virtual function that applies the upper left block of the inverse, of size n_nodes x n_nodes, to the columns of B
+  virtual MatrixType apply_upper_left_block (const SpMat & B) = 0;					//!< Pure virtual function that applies the upper left block of the inverse to the sparse columns of B, the result being sparse in the non-exact case
   
   // Destructor
   virtual ~Inverse_Base() {};
@@ -36,7 +31,8 @@ public:
 // *** Inverse_Exact Class ***
 //! Class for the exact inversion of sparse matrices in inference framework
 /*!
-  This class is used to compute the exact inverse of the sparse MatrixNoCov, needed to recover the exact inverse of the system matrix
+  This class applies the exact inverse of the sparse MatrixNoCov through its (already computed) decomposition: the inverse, of size 2N x 2N
+  (2NM x 2NM in the space-time models), is never formed.
 */
 class Inverse_Exact : public Inverse_Base<MatrixXr> {
 private:
@@ -48,8 +44,43 @@ public:
   Inverse_Exact()=delete; 										//!< Default constructor deleted
   Inverse_Exact(const SpMat * Ep_, const Eigen::SparseLU<SpMat> * E_decp_): Ep(Ep_),E_decp(E_decp_){}; 	//!< Main constructor
 
-  void Compute_Inv(void) override;                                                                      //!< Function for the exact computation of the inverse matrix
+  MatrixXr apply_upper_left_block(const MatrixXr & B) override;						//!< Function that applies the upper left block of the inverse through the decomposition, without computing the inverse
+  MatrixXr apply_upper_left_block(const SpMat & B) override;						//!< Function that applies the upper left block of the inverse to sparse columns, the result being dense
 }; 
 
+// *** Inverse_Non_Exact Class ***
+//! Class for the approximate sparse inversion of sparse matrices in inference framework
+/*!
+  This class computes a sparse approximation of the upper left block of the inverse of MatrixNoCov, the only block needed by the inferential methods,
+  through factorized sparse approximate inverses (FSPAI). MatrixNoCov = [A, B^t; B, -C] is a symmetric saddle point matrix, so the block is the inverse
+  of its Schur complement K = A + B^t*C^-1*B. Two FSPAI factors are computed: first G_C, with C^-1 approximated by G_C^t*G_C (C is a mass matrix, the
+  magnitude of the penalized diagonal entries of the Dirichlet boundary conditions being used), so that K = A + (G_C*B)^t*(G_C*B) is sparse, symmetric and
+  positive definite; then G_K, the upper left block being approximated by G_K^t*G_K. The factor of M (C or K) is a sparse lower triangular G with G*M*G^t close
+  to the identity, computed row by row: the pattern of each row starts from the lower triangular pattern of M and it is enlarged, at most max_steps times,
+  with the max_new indices with the largest residual, until the norm of the residual of the row is below tol_Fspai. The rows are independent and they are
+  computed in parallel. M is scaled to have unit diagonal, so that the tolerance does not depend on the magnitude of the blocks of MatrixNoCov.
+*/
+class Inverse_Non_Exact : public Inverse_Base<SpMat> {
+private:
+  const SpMat * Ep;			//!< Const pointer to the MatrixNoCov
+  SpMat E_inv;				//!< Approximate upper left block of the inverse, computed at its first application
+  bool inverse_computed = false;
+  Real tol_Fspai;			//!< Tolerance on the norm of the residual of each row of the factor
+  UInt max_steps;			//!< Maximum number of enlargements of the pattern of each row
+  UInt max_new;				//!< Maximum number of indices added to the pattern of a row at each enlargement
+  bool status_inverse = true;		//!< Boolean that tells whether all the rows have reached the tolerance
+
+  void Compute_Inv(void);		//!< Function for the approximate computation of the upper left block of the inverse matrix
+
+public:
+  // Constructor
+  Inverse_Non_Exact()=delete; 										//!< Default constructor deleted
+  Inverse_Non_Exact(const SpMat * Ep_, Real tol_Fspai_, UInt max_steps_ = 8, UInt max_new_ = 4): Ep(Ep_), tol_Fspai(tol_Fspai_ > 0 ? tol_Fspai_ : 0.05), max_steps(max_steps_), max_new(max_new_){}; 	//!< Main constructor, a non positive tolerance is replaced by the default 0.05
+
+  inline bool get_status_inverse(void) const override {return status_inverse;}				//!< Getter of the FSPAI status: false if some rows did not reach the tolerance
+  MatrixXr apply_upper_left_block(const MatrixXr & B) override;						//!< Function that applies the approximate upper left block of the inverse, computing it at the first call
+  SpMat apply_upper_left_block(const SpMat & B) override;						//!< Function that applies the approximate upper left block of the inverse to sparse columns, the result being sparse
+};
+
 #endif 
 
@@ -0,0 +1,249 @@
+#ifndef __SIGN_FLIP_ENGINE_H__
+#define __SIGN_FLIP_ENGINE_H__
+
+// HEADERS
+#include "../../FdaPDE.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// *** Sign_Flip_Engine Class ***
+//! Shared kernel of the sign-flip tests
+/*!
+  All the sign-flip statistics are linear in the flipped vector: for a flip s in {-1,1}^m the flipped statistics are T(s) = offset + B*s, where B
+  (k x m) already contains the residuals to be flipped and offset collects the components that are not flipped. The engine draws the signs from a
+  counter-based generator: the signs of the flip f are the bits of a hash of (seed, stream, f), so that any flip can be generated independently of
+  the others. The flips are processed in blocks: the signs of a block are unpacked from 64-bit words into a m x n_block matrix S and the statistics
+  of the whole block are obtained with a single product B*S. The blocks are spread among the threads and every block stores its own counts, which
+  are summed in block order: the result depends only on the seed, not on the number of threads.
+  The tests can also be run sequentially: the blocks are then processed by rounds of a fixed number of blocks and, after each round, the caller decides
+  from the counts gathered so far whether the decision of the test is settled, in which case the remaining flips are not drawn. The rounds do not depend
+  on the number of threads either, so that the flips used are still a function of the seed only.
+*/
+class Sign_Flip_Engine{
+private:
+  std::uint64_t seed;				//!< Seed of the generator
+  std::uint64_t stream;				//!< Stream of the generator, to draw independent flips for different tests with the same seed
+  unsigned long int n_flip;			//!< Number of flips
+
+  //! Method that fills the first n_block columns of S with the signs of the flips [first_flip, first_flip + n_block)
+  void fill_signs(MatrixXr & S, unsigned long int first_flip, UInt n_block) const;
+  //! Method returning the number of flips of a block: large enough for an efficient product, small enough for the sign matrix to stay in cache
+  static UInt block_size(UInt m);
+  //! Method that computes the flipped statistics offset + B*S of the blocks [first_block, last_block), in parallel, and gives them to visitor(b, first_flip, T)
+  template<typename MatrixB, typename Visitor>
+  void for_each_block(const MatrixB & B, const VectorXr & offset, long int first_block, long int last_block, Visitor visitor) const;
+  //! Method returning the number of blocks of flips for a matrix B with m columns
+  inline long int n_blocks(UInt m) const {return (n_flip + block_size(m) - 1)/block_size(m);}
+
+  static constexpr long int round_blocks = 8;	//!< Number of blocks of a round of the sequential tests
+
+public:
+  // CONSTRUCTOR
+  Sign_Flip_Engine()=delete;	//The default constructor is deleted
+  Sign_Flip_Engine(std::uint64_t seed_, std::uint64_t stream_, unsigned long int n_flip_):seed(seed_), stream(stream_), n_flip(n_flip_){};
+
+  //! Method returning the seed to be used for a user seed: the user seed itself if positive, a random one otherwise
+  static std::uint64_t make_seed(UInt user_seed);
+  //! Method returning 64 signs (one for each bit, 1 meaning +1) of the flip flip, for the components [64*word, 64*word + 64)
+  static std::uint64_t sign_word(std::uint64_t seed, std::uint64_t stream, unsigned long int flip, UInt word);
+
+  //! Method that runs all the flips and counts them
+  /*!
+    \tparam MatrixB the type of B: a dense matrix, or any Eigen expression that can multiply a dense matrix (e.g. a diagonal matrix, when each statistic depends on a single component)
+    \param B the matrix that gives the flipped statistics, one row for each statistic and one column for each flipped component
+    \param offset the part of the statistics that is not flipped
+    \param n_rows number of rows of the counts
+    \param n_cols number of columns of the counts
+    \param counter a function (const MatrixXr & T, MatrixXr & counts) that adds to counts the flipped statistics of a block, T having one column for each flip;
+    it is called concurrently on different blocks, hence it can only modify its counts
+    \return the sum of the counts of all the blocks
+  */
+  template<typename MatrixB, typename Counter>
+  MatrixXr count(const MatrixB & B, const VectorXr & offset, UInt n_rows, UInt n_cols, Counter counter) const;
+
+  //! Method that runs the flips by rounds and counts them, until the decision of the test is settled
+  /*!
+    \param B the matrix that gives the flipped statistics, as in count
+    \param offset the part of the statistics that is not flipped
+    \param n_rows number of rows of the counts
+    \param n_cols number of columns of the counts
+    \param counter the function that adds to counts the flipped statistics of a block, as in count
+    \param settled a function (const MatrixXr & counts, unsigned long int n) returning true if the decision of the test is settled given the counts of the first n flips
+    \param n_done number of flips actually performed, n_flip if the decision has never been settled
+    \return the sum of the counts of the flips performed
+  */
+  template<typename MatrixB, typename Counter, typename Stopper>
+  MatrixXr count_sequential(const MatrixB & B, const VectorXr & offset, UInt n_rows, UInt n_cols, Counter counter, Stopper settled, unsigned long int & n_done) const;
+
+  //! Method returning the half width of a Monte Carlo band around the fractions of flips estimated after each round
+  /*!
+    The band follows from the Hoeffding inequality, with a union bound over the rounds: with probability at least 1 - error, each fraction estimated on
+    the flips of any round is within the band from the one that would be estimated on infinitely many flips.
+    \param n number of flips performed
+    \param m number of columns of B, which determines the number of rounds
+    \param error probability that a fraction leaves the band in any of the rounds
+  */
+  Real mc_band(unsigned long int n, UInt m, Real error) const;
+
+  //! Method that runs all the flips and stores them
+  /*!
+    \param B the matrix that gives the flipped statistics, as in count
+    \param offset the part of the statistics that is not flipped
+    \return the matrix of the flipped statistics, one column for each flip: the flips being drawn once, they can be reused by searches that evaluate many candidate values
+  */
+  template<typename MatrixB>
+  MatrixXr statistics(const MatrixB & B, const VectorXr & offset) const;
+
+  inline unsigned long int get_n_flip(void) const {return n_flip;}	//!< Getter of n_flip \return n_flip
+};
+
+template<typename MatrixB, typename Visitor>
+void Sign_Flip_Engine::for_each_block(const MatrixB & B, const VectorXr & offset, long int first_block, long int last_block, Visitor visitor) const{
+  const UInt m = B.cols();
+  const UInt n_block = block_size(m);
+
+  #pragma omp parallel
+  {
+    MatrixXr S(m, n_block);
+    MatrixXr T;
+
+    #pragma omp for schedule(static)
+    for(long int b=first_block; b<last_block; ++b){
+      const unsigned long int first_flip = b*n_block;
+      const UInt n_current = std::min<unsigned long int>(n_block, n_flip - first_flip);
+      fill_signs(S, first_flip, n_current);
+      T.noalias() = B*S.leftCols(n_current);
+      T.colwise() += offset;
+      visitor(b, first_flip, T);
+    }
+  }
+};
+
+template<typename MatrixB, typename Counter>
+MatrixXr Sign_Flip_Engine::count(const MatrixB & B, const VectorXr & offset, UInt n_rows, UInt n_cols, Counter counter) const{
+  const long int n_b = n_blocks(B.cols());
+  std::vector<MatrixXr> block_counts(n_b, MatrixXr::Zero(n_rows, n_cols));
+
+  for_each_block(B, offset, 0, n_b, [&](long int b, unsigned long int, const MatrixXr & T){ counter(T, block_counts[b]);});
+
+  MatrixXr counts = MatrixXr::Zero(n_rows, n_cols);
+  for(const MatrixXr & c : block_counts)
+    counts += c;
+
+  return counts;
+};
+
+template<typename MatrixB, typename Counter, typename Stopper>
+MatrixXr Sign_Flip_Engine::count_sequential(const MatrixB & B, const VectorXr & offset, UInt n_rows, UInt n_cols, Counter counter, Stopper settled, unsigned long int & n_done) const{
+  const long int n_b = n_blocks(B.cols());
+  const UInt n_block = block_size(B.cols());
+  std::vector<MatrixXr> block_counts(round_blocks, MatrixXr::Zero(n_rows, n_cols));
+
+  MatrixXr counts = MatrixXr::Zero(n_rows, n_cols);
+  n_done = 0;
+  for(long int first_block=0; first_block<n_b; first_block+=round_blocks){
+    const long int last_block = std::min(n_b, first_block + round_blocks);
+    for(MatrixXr & c : block_counts)
+      c.setZero();
+
+    for_each_block(B, offset, first_block, last_block, [&](long int b, unsigned long int, const MatrixXr & T){ counter(T, block_counts[b - first_block]);});
+
+    for(long int b=first_block; b<last_block; ++b)
+      counts += block_counts[b - first_block];
+    n_done = std::min<unsigned long int>(n_flip, last_block*n_block);
+
+    if(n_done < n_flip && settled(counts, n_done))
+      break;
+  }
+
+  return counts;
+};
+
+template<typename MatrixB>
+MatrixXr Sign_Flip_Engine::statistics(const MatrixB & B, const VectorXr & offset) const{
+  MatrixXr T_flip(offset.size(), n_flip);
+
+  // every block writes its own columns
+  for_each_block(B, offset, 0, n_blocks(B.cols()), [&T_flip](long int, unsigned long int first_flip, const MatrixXr & T){ T_flip.middleCols(first_flip, T.cols()) = T;});
+
+  return T_flip;
+};
+
+// *** Sign_Flip_Line Class ***
+//! Flipped statistics that are affine in a scalar value
+/*!
+  The statistics of the confidence intervals depend on the value under the null hypothesis v as T(v) = base + v*slope, both for the observed data
+  and for each flip. Once the flips have been drawn, the p-value of any candidate v costs O(n_flip), and the search of the bounds always sees the same
+  flips: the p-value is a deterministic function of v.
+*/
+class Sign_Flip_Line{
+private:
+  Real observed_base;				//!< Observed statistic in v = 0
+  Real observed_slope;				//!< Slope of the observed statistic
+  MatrixXr flipped;				//!< Flipped statistics: base (row 0) and slope (row 1) of each flip
+
+public:
+  // CONSTRUCTOR
+  Sign_Flip_Line()=delete;	//The default constructor is deleted
+  Sign_Flip_Line(Real observed_base_, Real observed_slope_, MatrixXr && flipped_):observed_base(observed_base_), observed_slope(observed_slope_), flipped(std::move(flipped_)){};
+
+  //! Method returning the unilateral p-value of v: the smaller fraction of flipped statistics that are larger or smaller than the observed one
+  Real pvalue(Real v) const;
+  //! Method that searches a bound of a confidence interval by bisection
+  /*!
+    \param center the estimate, center of the interval
+    \param inner the limit of the bound on the side of the center, updated by the search
+    \param outer the limit of the bound on the other side, updated by the search
+    \param tolerance the search stops when the limits are closer than tolerance
+    \param alpha the significance of the bound
+    \param max_iter maximum number of iterations
+    \return true if the search has converged, the bound being 0.5*(inner + outer)
+  */
+  bool search_bound(Real center, Real & inner, Real & outer, Real tolerance, Real alpha, UInt max_iter) const;
+};
+
+// *** Sign_Flip_Projector Class ***
+//! Projector Q = I - W (W^t W)^-1 W^t on the orthogonal complement of the covariates
+/*!
+  Q is represented by the thin QR decomposition of W (n x q): the last n - q columns of the orthogonal factor H are an orthonormal basis V of the
+  range of Q, so that Q = V V^t and V is the basis in which the eigen-sign-flip tests flip the residuals. H is kept in its Householder form: projecting,
+  changing basis and flipping cost O(n q) for each vector, instead of building the dense n x n projector and its eigendecomposition. Without covariates
+  (q = 0) Q and V are the identity.
+*/
+class Sign_Flip_Projector{
+private:
+  Eigen::HouseholderQR<MatrixXr> W_dec;		//!< QR decomposition of W
+  UInt n = 0;					//!< Number of rows of W
+  UInt q = 0;					//!< Number of columns of W
+
+public:
+  //! Operator V * diag(res) that gives the flipped residuals, back in the original space, to Sign_Flip_Engine
+  class Flip{
+  private:
+    const Sign_Flip_Projector & projector;
+    const VectorXr & res;
+  public:
+    Flip(const Sign_Flip_Projector & projector_, const VectorXr & res_):projector(projector_), res(res_){};
+    inline UInt cols(void) const {return res.size();}
+    template<typename Derived>
+    MatrixXr operator*(const Eigen::MatrixBase<Derived> & S) const {return projector.from_basis(res.asDiagonal()*S);}
+  };
+
+  //! Method that decomposes W (the matrix may have no columns, when there are no covariates)
+  void compute(const MatrixXr & W);
+
+  //! Method returning Q*R
+  MatrixXr project(const MatrixXr & R) const;
+  //! Method returning V^t*R, the coordinates of the projection of R in the basis V
+  MatrixXr to_basis(const MatrixXr & R) const;
+  //! Method returning V*X
+  MatrixXr from_basis(const MatrixXr & X) const;
+  //! Method returning the operator that flips res in the basis V, res being kept by reference
+  inline Flip flip_operator(const VectorXr & res) const {return Flip(*this, res);}
+
+  inline UInt rank(void) const {return n - q;}	//!< Getter of the dimension of the range of Q \return n - q
+};
+
+#endif
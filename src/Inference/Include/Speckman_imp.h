@@ -4,57 +4,27 @@
 
 template<typename InputHandler, typename MatrixType> 
 void Speckman_Base<InputHandler, MatrixType>::compute_V(){
-  //check if Lambda2 has been computed
-  if(!is_Lambda2_computed){
-    this->compute_Lambda2();
+  //check if Lambda has been computed
+  if(!is_Lambda_computed){
+    this->compute_Lambda();
   }
-  //check if WLW_dec has been computed
-  if(!is_WLW_computed){
-    compute_WLW_dec();
-  }
-  
-  // get the residuals needed
-  VectorXr eps_hat = (*(this->inf_car.getZp())) - (this->inf_car.getZ_hat());
-  // compute squared residuals
-  VectorXr Res2=eps_hat.array()*eps_hat.array();
-  
-  // resize the variance-covariance matrix
-  UInt q = this->inf_car.getq();
-  V.resize(q,q);
-  
-  const MatrixXr * W = this->inf_car.getWp();
-  const MatrixXr W_t = W->transpose();
   
-  MatrixXr diag = Res2.asDiagonal();
-  
-  V = (WLW_dec).solve((W_t)*Lambda2*Res2.asDiagonal()*Lambda2*(*W)*(WLW_dec).solve(MatrixXr::Identity(q,q)));
+  // the sandwich variance-covariance matrix is shared with the eigen-sign-flip implementation
+  V = this->workspace.getV_Speckman();
   is_V_computed = true;
   
   return;
 };
 
-template<typename InputHandler, typename MatrixType>
-void Speckman_Base<InputHandler, MatrixType>::compute_WLW_dec(void){
-  //check if Lambda2 has been computed
-  if(!is_Lambda2_computed){
-    this->compute_Lambda2();
-  }
-  
-  // compute the decomposition of W^T*Lambda^2*W
-  const MatrixXr * W = this->inf_car.getWp();
-  WLW_dec.compute(W->transpose()*Lambda2*(*W));
-  is_WLW_computed=true;
-};
-
 template<typename InputHandler, typename MatrixType> 
 void Speckman_Base<InputHandler, MatrixType>::compute_beta_hat(void){
-  //check if WLW_dec has been computed
-  if(!is_WLW_computed){
-    compute_WLW_dec();
+  //check if Lambda has been computed
+  if(!is_Lambda_computed){
+    this->compute_Lambda();
   }
-  const MatrixXr * W = this->inf_car.getWp();
   
-  this->beta_hat = WLW_dec.solve(W->transpose()*Lambda2*(*(this->inf_car.getZp())));
+  // W^t*Lambda^2*z = (Lambda^t*W)^t*(Lambda*z)
+  this->beta_hat = this->workspace.getWLW_dec().solve(this->workspace.getLambda_t_W().transpose()*this->workspace.apply_Lambda(*(this->inf_car.getZp()), false));
   this->is_beta_hat_computed = true; 
   
   return; 
@@ -67,9 +37,9 @@ VectorXr Speckman_Base<InputHandler, MatrixType>::compute_beta_pvalue(void){
   VectorXr result;
 
   // compute the variance-covariance matrix if needed
-  if(!is_Lambda2_computed){
-    this->compute_Lambda2();
-    if(!is_Lambda2_computed){     // Failed computation of E_tilde_inv/E_inv, returning, unfeasible p_values
+  if(!is_Lambda_computed){
+    this->compute_Lambda();
+    if(!is_Lambda_computed){     // Failed computation of E_tilde_inv/E_inv, returning, unfeasible p_values
       Rprintf("error: failed FSPAI inversion in p_values computation, discarding inference");
       MatrixXr C = this->inf_car.getInfData()->get_coeff_inference();
       result.resize(C.rows());
@@ -166,13 +136,14 @@ MatrixXv Speckman_Base<InputHandler, MatrixType>::compute_f_CI(void){
 template<typename InputHandler, typename MatrixType> 
 MatrixXv Speckman_Base<InputHandler, MatrixType>::compute_beta_CI(void){
   
-  // compute Lambda2 and V if needed
-  if(!is_Lambda2_computed){
-    compute_Lambda2();
-    if(!is_Lambda2_computed){
+  // compute Lambda and V if needed
+  if(!is_Lambda_computed){
+    this->compute_Lambda();
+    if(!is_Lambda_computed){
       Rprintf("error: failed FSPAI inversion in confidence intervals computation, discarding inference");
       MatrixXv result;
       MatrixXr C = this->inf_car.getInfData()->get_coeff_inference();
+      result.resize(1, C.rows());
       for(UInt i=0; i<C.rows(); ++i){
 	result(i).resize(3);
 
@@ -227,29 +198,18 @@ MatrixXv Speckman_Base<InputHandler, MatrixType>::compute_beta_CI(void){
 };
 
 template<typename InputHandler, typename MatrixType> 
-void Speckman_Exact<InputHandler, MatrixType>::compute_Lambda2(void){
-  this->inverter->Compute_Inv();
-  // extract the inverse of E
-  const MatrixType * E_inv = this->inverter->getInv();
-  // extract areal matrix (VectorXr)
-  const VectorXr * A = this->inf_car.getAp();
-  
-  UInt n_obs = this->inf_car.getN_obs();
-  UInt n_nodes = this->inf_car.getN_nodes();
+void Speckman_Exact<InputHandler, MatrixType>::compute_Lambda(void){
+  // the decomposition of MatrixNoCov is already available in the carrier, the inverter solves with it and nothing has to be inverted
+  this->is_Lambda_computed = true;
   
-  const SpMat * Psi = this->inf_car.getPsip();
-  const SpMat * Psi_t = this->inf_car.getPsi_tp(); 
-  
-  this->Lambda2.resize(n_obs, n_obs);
+  return; 
+};
 
-  if(this->inf_car.getRegData()->getNumberOfRegions()>0){
-    this->Lambda2 = (MatrixXr::Identity(n_obs,n_obs) - (*Psi)*((*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t)*(A->asDiagonal())))*(MatrixXr::Identity(n_obs,n_obs) - (*Psi)*((*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t)*(A->asDiagonal())));
-  }else{
-    this->Lambda2 = (MatrixXr::Identity(n_obs,n_obs) - (*Psi)*((*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t)))*(MatrixXr::Identity(n_obs,n_obs) - (*Psi)*((*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t)));
-  }
+template<typename InputHandler, typename MatrixType> 
+void Speckman_Non_Exact<InputHandler, MatrixType>::compute_Lambda(void){
+  // the approximate upper left block of the inverse of E is computed by the inverter at its first application
 
-  this->is_Lambda2_computed = true;
+  this->is_Lambda_computed = true;
   
   return; 
 };
-
@@ -11,35 +11,40 @@
 #include "Inference_Carrier.h"
 #include "Inverter.h"
 #include "Inference_Base.h"
+#include "../../Global_Utilities/Include/Instrumentation.h"
 #include <memory>
 
 // *** Wald_Base Class ***
 //! Hypothesis testing and confidence intervals using Wald implementation
 /*!
-  This template class is an abstract base class to perform hypothesis testing and/or compute confidence intervals using a parametric Wald-type approach. Beyond all the objects and methods inherited from the abstract base inference class, it stores the smoothing matrix S, its trace, the estimator of the residuals variance, the variance-covariance matrix of the beta parameters V and the one of the estimator f_hat V_f, alongside with some convenient boolean objects. It overrides the methods that specify how to compute the p-values and the confidence intervals, according to the Wald apporach. It has a pure virtual method for the computation of the smoothing matrix S, since it relies on the inversion of MatrixNoCov in an exact or non-exact way (not implemented in this CRAN version). Moreover it also overrides the method for the computation of the exact GCV, since it can be computed in a straight-forward way after having computed the smoothing matrix S and its trace. 
+  This template class is an abstract base class to perform hypothesis testing and/or compute confidence intervals using a parametric Wald-type approach. Beyond all the objects and methods inherited from the abstract base inference class, it stores the quantities derived from the smoothing matrix S, the estimator of the residuals variance, the variance-covariance matrix of the beta parameters V, alongside with some convenient boolean objects. It overrides the methods that specify how to compute the p-values and the confidence intervals, according to the Wald apporach. 
+  The smoothing matrix S = Psi*Partial_S, with Partial_S = (Psi^t*Q*Psi + lambda*P)^-1*Psi^t*Q, is never stored: it is computed by blocks of columns by the derived classes through the pure virtual method compute_S, and each block is reduced by accumulate_S to the only quantities needed by the tests, i.e. tr(S), S^t*W, the diagonal of S*S^t and Psi_loc*Partial_S. Since Q is a symmetric projector, the variance-covariance matrix of f_hat is V_f = sigma_hat_sq*Partial_S*Partial_S^t, so that its restriction to the locations is recovered from Psi_loc*Partial_S only. The confidence intervals on f only need the diagonal of Psi_loc*V_f*Psi_loc^t, which is accumulated by blocks of locations without storing Psi_loc*Partial_S: this matrix is kept only for the test on f. It also overrides the method for the computation of the exact GCV, since it can be computed in a straight-forward way after having computed the trace of S. 
   \tparam InputHandler the type of regression problem needed to determine the MixedFERegressionBase object type in Inference_Carrier<InputHandler>
-  \tparam MatrixType the type of matrix (MatrixXr or SpMat) used to store diffferent objects related to the smoothers S and B (I-Lambda). SpMat type is related to approximated inference computation (not implemented in this CRAN version).
+  \tparam MatrixType the type of the inverse of MatrixNoCov (MatrixXr or SpMat) provided by the inverter. SpMat type is related to approximated inference computation.
 */
 template<typename InputHandler, typename MatrixType>
 class Wald_Base:public Inference_Base<InputHandler, MatrixType>{
 protected:
-  MatrixXr S;						//!< Smoothing matrix 
-  MatrixXr B;                                           //!< Smoothing matrix without covariates
-  MatrixXr Partial_S;                                   //!< (Psi^t*Q*Psi + lambda*P)^-1 * Psi^t computed only if local f variance and/or inference on f are required 
+  static constexpr UInt block_size = 256;		//!< Number of columns of S computed at once
+  static constexpr UInt loc_block_size = 4096;		//!< Number of rows of S_loc computed at once
   Real tr_S=0; 						//!< Trace of smoothing matrix, needed for the variance-covariance matrix (V) and eventually GCV computation
+  MatrixXr St_W;					//!< S^t*W [size n_obs x q], the only product with S needed by V
+  VectorXr diag_SSt;					//!< Diagonal of S*S^t [size n_obs], computed only if local f variance is required
+  MatrixXr S_loc;					//!< Psi_loc*Partial_S [size n_loc x n_obs], computed only if a test on f is required
+  VectorXr diag_S_loc;					//!< Diagonal of S_loc*S_loc^t [size n_loc], computed if inference on f is required, also when S_loc is not stored
+  Eigen::SparseMatrix<Real, Eigen::RowMajor> Psi_loc_rows;	//!< Psi_loc stored by rows, to compute S_loc by blocks of locations
   Real sigma_hat_sq; 					//!< Estimator for the variance of the residuals (SSres/(n_obs-(q+tr_S)))
   bool is_sigma_hat_sq_computed = false;                //!< Boolean that tells whether sigma_hat_sq has been computed or not
-  bool is_S_computed = false;				//!< Boolean that tells whether S has been computed or not
-  bool is_B_computed = false;                           //!< Boolean that tells whether B has been computed or not
+  bool is_S_computed = false;				//!< Boolean that tells whether the quantities derived from S have been computed or not
   MatrixXr V;						//!< Variance-Covariance matrix of the beta parameters
   bool is_V_computed = false;				//!< Boolean that tells whether V has been computed or not
-  virtual void compute_S(void) = 0;			//!< Pure virtual method used to compute S
-  virtual void compute_B(void) = 0;                     //!< Pure virtual method used to compute B
+  virtual void compute_S(void) = 0;			//!< Pure virtual method used to compute the quantities derived from S
+  void init_S(void);					//!< Method that resets the quantities derived from S before calling accumulate_S
+  void accumulate_S(const MatrixXr & Partial_S_block, UInt first_col);	//!< Method that adds the contribution of the columns [first_col, first_col+Partial_S_block.cols()) of Partial_S
   void compute_V(void);					//!< Method used to compute V
-  MatrixXr V_f;                                         //!< Variance-Covariance matrix of f_hat estimator
-  bool is_V_f_computed = false;                         //!< Boolean that tells whether V_f has been computed or not
-  void compute_V_f(void);                               //!< Method used to compute V_f
   void compute_sigma_hat_sq(void);                      //!< Method to compute the estimator of the variance of the residuals 
+  bool need_f_inference(void) const;			//!< Method that tells whether some of the required implementations makes inference on f
+  bool need_f_test(void) const;				//!< Method that tells whether some of the positions that require Wald tests f, which needs the whole S_loc
 
   // methods that compute pvalues and/or CI on beta and on f respectively
   VectorXr compute_beta_pvalue(void) override;
@@ -50,15 +55,15 @@ protected:
 public:
   // CONSTUCTOR
   Wald_Base()=delete;	//The default constructor is deleted
-  Wald_Base(std::shared_ptr<Inverse_Base<MatrixType>> inverter_, const Inference_Carrier<InputHandler> & inf_car_, UInt pos_impl_):Inference_Base<InputHandler, MatrixType>(inverter_, inf_car_, pos_impl_){}; //Main constructor of the class
+  Wald_Base(Inference_Workspace<InputHandler, MatrixType> & workspace_, UInt pos_impl_):Inference_Base<InputHandler, MatrixType>(workspace_, pos_impl_){}; //Main constructor of the class
   
   virtual ~ Wald_Base(){};
   
-  Real compute_GCV_from_inference(void) const override; //!< Needed to compute exact GCV in case Wald test is required and GCV exact is not provided by lambda optimization (Run after S computation)
+  Real compute_GCV_from_inference(void) const override; //!< Needed to compute exact GCV in case Wald test is required and GCV exact is not provided by lambda optimization (Run after S computation, NA otherwise)
   VectorXr compute_f_var(void) override; //!< Needed to compute local f variance if required
   
   // GETTERS
-  inline const MatrixXr * getSp (void) const {return &this->S;}      //!< Getter of Sp \return Sp
+  inline Real getTr_S (void) const {return this->tr_S;}            //!< Getter of tr_S \return tr_S
   inline const MatrixXr * getVp (void) const {return &this->V;}      //!< Getter of Vp \ return Vp
 };
 
@@ -66,17 +71,31 @@ public:
 // *** Wald_Exact Class ***
 //! Hypothesis testing and confidence intervals using Wald implementation in an exact way 
 /*!
-  This template class derives from the Wald_Base class and it overrides the method that manages the computation of the smoothing matrices S and B, relying on an exact inversion of the MatrixNoCov. 
+  This template class derives from the Wald_Base class and it overrides the method that manages the computation of the smoothing matrix S in an exact way. Instead of inverting MatrixNoCov, the blocks of Partial_S are obtained through multi right hand side solves with its already computed factorization, reconstructing the Woodbury decomposition of the system when there are covariates. 
 */
 template<typename InputHandler, typename MatrixType>
 class Wald_Exact:public Wald_Base<InputHandler, MatrixType>{
 private: 
   void compute_S(void) override;
-  void compute_B(void) override;
 public:
   // CONSTUCTOR
   Wald_Exact()=delete;	//The default constructor is deleted
-  Wald_Exact(std::shared_ptr<Inverse_Base<MatrixType>> inverter_, const Inference_Carrier<InputHandler> & inf_car_, UInt pos_impl_):Wald_Base<InputHandler, MatrixType>(inverter_, inf_car_, pos_impl_){}; 
+  Wald_Exact(Inference_Workspace<InputHandler, MatrixType> & workspace_, UInt pos_impl_):Wald_Base<InputHandler, MatrixType>(workspace_, pos_impl_){}; 
+};
+
+// *** Wald_Non_Exact Class ***
+//! Hypothesis testing and confidence intervals using Wald implementation in a non-exact way 
+/*!
+  This template class derives from the Wald_Base class and it overrides the method that manages the computation of the smoothing matrix S in a non-exact way. The blocks of Partial_S are obtained through products with the sparse approximate inverse of MatrixNoCov provided by the inverter, instead of solves with its factorization; the Woodbury decomposition of the system is applied as in the exact case when there are covariates. 
+*/
+template<typename InputHandler, typename MatrixType>
+class Wald_Non_Exact:public Wald_Base<InputHandler, MatrixType>{
+private: 
+  void compute_S(void) override;
+public:
+  // CONSTUCTOR
+  Wald_Non_Exact()=delete;	//The default constructor is deleted
+  Wald_Non_Exact(Inference_Workspace<InputHandler, MatrixType> & workspace_, UInt pos_impl_):Wald_Base<InputHandler, MatrixType>(workspace_, pos_impl_){}; 
 };
 
 #include "Wald_imp.h"
@@ -1,32 +1,103 @@
 #include "Wald.h"
+#include <algorithm>
 #include <cmath>
 
+template<typename InputHandler, typename MatrixType> 
+bool Wald_Base<InputHandler, MatrixType>::need_f_inference(void) const{
+  const std::vector<std::string> & components = this->inf_car.getInfData()->get_component_type();
+  return this->inf_car.getN_loc() > 0 && std::any_of(components.begin(), components.end(), [](const std::string & c){return c != "parametric";});
+};
+
+template<typename InputHandler, typename MatrixType> 
+bool Wald_Base<InputHandler, MatrixType>::need_f_test(void) const{
+  // the same object serves all the positions that require Wald in this call
+  const std::vector<std::string> & implementations = this->inf_car.getInfData()->get_implementation_type();
+  const std::vector<std::string> & tests = this->inf_car.getInfData()->get_test_type();
+  const std::vector<std::string> & components = this->inf_car.getInfData()->get_component_type();
+  if(!need_f_inference()){
+    return false;
+  }
+  for(std::size_t i=0; i<implementations.size(); ++i){
+    if(implementations[i]=="wald" && tests[i]!="not-defined" && components[i]!="parametric"){
+      return true;
+    }
+  }
+  return false;
+};
+
+template<typename InputHandler, typename MatrixType> 
+void Wald_Base<InputHandler, MatrixType>::init_S(void){
+  UInt n_obs = this->inf_car.getN_obs();
+  tr_S = 0;
+
+  if(this->inf_car.getRegData()->getCovariates()->rows()!=0){
+    St_W.resize(n_obs, this->inf_car.getq());
+  }
+  if(this->inf_car.getInfData()->get_f_var()){
+    diag_SSt = VectorXr::Zero(n_obs);
+  }
+  if(need_f_inference()){
+    Psi_loc_rows = this->inf_car.getPsi_loc();
+    diag_S_loc = VectorXr::Zero(this->inf_car.getN_loc());
+  }
+  if(need_f_test()){
+    S_loc.resize(this->inf_car.getN_loc(), n_obs);
+  }
+
+  return;
+};
+
+template<typename InputHandler, typename MatrixType> 
+void Wald_Base<InputHandler, MatrixType>::accumulate_S(const MatrixXr & Partial_S_block, UInt first_col){
+  const UInt n_cols = Partial_S_block.cols();
+  // columns of the smoothing matrix S = Psi*Partial_S
+  const MatrixXr S_block = (*(this->inf_car.getPsip()))*Partial_S_block;
+
+  for(UInt j=0; j<n_cols; ++j){
+    tr_S += S_block(first_col+j, j);
+  }
+  if(this->inf_car.getRegData()->getCovariates()->rows()!=0){
+    St_W.middleRows(first_col, n_cols) = S_block.transpose()*(*(this->inf_car.getWp()));
+  }
+  if(this->inf_car.getInfData()->get_f_var()){
+    diag_SSt += S_block.cwiseAbs2().rowwise().sum();
+  }
+  if(need_f_inference()){
+    // rows of Psi_loc*Partial_S by blocks of locations, as sparse-dense products: only their squared norms are kept, unless the test on f needs them
+    const long int n_loc = Psi_loc_rows.rows();
+    const bool store_S_loc = need_f_test();
+    #pragma omp parallel for schedule(static)
+    for(long int first_loc=0; first_loc<n_loc; first_loc+=loc_block_size){
+      const UInt n_rows = std::min<long int>(loc_block_size, n_loc-first_loc);
+      const MatrixXr S_loc_block = Psi_loc_rows.middleRows(first_loc, n_rows)*Partial_S_block;
+      diag_S_loc.segment(first_loc, n_rows) += S_loc_block.cwiseAbs2().rowwise().sum();
+      if(store_S_loc){
+	S_loc.block(first_loc, first_col, n_rows, n_cols) = S_loc_block;
+      }
+    }
+  }
+
+  return;
+};
+
 template<typename InputHandler, typename MatrixType> 
 void Wald_Base<InputHandler, MatrixType>::compute_sigma_hat_sq(void){
   
-  VectorXr eps_hat = (*(this->inf_car.getZp())) - (this->inf_car.getZ_hat());
-  Real SS_res = eps_hat.squaredNorm();
+  Real SS_res = this->workspace.getEps_hat().squaredNorm();
   UInt n = this->inf_car.getN_obs();
   
-  if(this->inf_car.getRegData()->getCovariates()->rows()!=0){ //case with covariates
-    //check if S has been computed 
-    if(is_S_computed==false){
-      this->compute_S();
-    }
+  //check if S has been computed (without covariates it coincides with B)
+  if(is_S_computed==false){
+    this->compute_S();
+  }
 
+  if(this->inf_car.getRegData()->getCovariates()->rows()!=0){ //case with covariates
     UInt q = this->inf_car.getq();
-    tr_S = this->S.trace();
     sigma_hat_sq = SS_res/(n - (q + tr_S));
   }
 
   else{//no covariates case
-    //check if B has been computed 
-    if(is_B_computed==false){
-      this->compute_B();
-    }
-
-    Real tr_B = this->B.trace();
-    sigma_hat_sq = SS_res/(n - tr_B);
+    sigma_hat_sq = SS_res/(n - tr_S);
   }
   
   is_sigma_hat_sq_computed = true;
@@ -45,61 +116,19 @@ void Wald_Base<InputHandler, MatrixType>::compute_V(void){
   UInt q = this->inf_car.getq();
   V.resize(q,q);
   
-  const MatrixXr * W = this->inf_car.getWp();
   const Eigen::PartialPivLU<MatrixXr> * WtW_decp = this->inf_car.getWtW_decp();
   
   if(is_sigma_hat_sq_computed==false){
     this->compute_sigma_hat_sq();
   }
-  V = this->sigma_hat_sq*((*WtW_decp).solve(MatrixXr::Identity(q,q)) + (*WtW_decp).solve(W->transpose()*S*S.transpose()*(*W)*(*WtW_decp).solve(MatrixXr::Identity(q,q))));
+  // W^t*S*S^t*W is obtained from S^t*W, S is never formed
+  MatrixXr WtW_inv = (*WtW_decp).solve(MatrixXr::Identity(q,q));
+  V = this->sigma_hat_sq*(WtW_inv + (*WtW_decp).solve(St_W.transpose()*St_W*WtW_inv));
   is_V_computed = true;
   
   return;
 };
 
-template<typename InputHandler, typename MatrixType> 
-void Wald_Base<InputHandler, MatrixType>::compute_V_f(void){
-  // make sure that B and Partial_S has been computed
-  if(this->inf_car.getRegData()->getCovariates()->rows()==0){ // case with no covariates
-    if(!is_B_computed){
-      compute_B();
-    }
-    if(!is_B_computed){
-      // something went wrong with FSPAI inversion 
-      this->is_V_f_computed = false;
-      return; 
-    }
-  }
-  else{ // case with covariates
-    if(!is_S_computed){
-      compute_S();
-    }
-    if(!is_S_computed){
-      // something went wrong with FSPAI inversion 
-      this->is_V_f_computed = false;
-      return; 
-    }
-  }
-  // make sure sigma_hat_sq has been computed
-  if(is_sigma_hat_sq_computed==false){
-    compute_sigma_hat_sq();
-  }
-
-  UInt n = this->inf_car.getN_obs(); 
-  MatrixXr Q = MatrixXr::Identity(n, n); // if there are no covariates Q is just an identity 
-						       
-  if(this->inf_car.getRegData()->getCovariates()->rows()!=0){
-    Q = Q - *(this->inf_car.getHp());
-  }
-
-  // compute variance-covariance matrix of f_hat
-  this->V_f = this->sigma_hat_sq * (this->Partial_S) * Q * (this->Partial_S.transpose());
-  this->is_V_f_computed = true;
-
-  return;
-   
-};
-
 template<typename InputHandler, typename MatrixType> 
 VectorXr Wald_Base<InputHandler, MatrixType>::compute_beta_pvalue(void){
 
@@ -184,17 +213,21 @@ template<typename InputHandler, typename MatrixType>
 Real Wald_Base<InputHandler, MatrixType>::compute_f_pvalue(void){
   
   Real result;
-  // check that variance-covariance matrix of f_hat has been computed
-  if(!is_V_f_computed){
-    this->compute_V_f();
+  // check that S and the variance of the residuals have been computed
+  if(!is_S_computed){
+    this->compute_S();
   }
 
   // check that FSPAI inversion went well (if non-exact inference was required)
-  if(!is_V_f_computed){
+  if(!is_S_computed){
     Rprintf("error: failed FSPAI inversion in p_values computation, discarding inference"); 
     result = 10e20;
     return result; 
   }
+
+  if(!is_sigma_hat_sq_computed){
+    this->compute_sigma_hat_sq();
+  }
   
   // get the estimator f_hat 
   UInt nnodes = this->inf_car.getN_nodes();
@@ -209,8 +242,8 @@ Real Wald_Base<InputHandler, MatrixType>::compute_f_pvalue(void){
   // compute local estimator 
   VectorXr f_loc_hat = Psi_loc * f_hat; 
 
-  // derive the variance-covariance matrix of f_loc_hat
-  MatrixXr V_f_loc = Psi_loc * this->V_f * Psi_loc.transpose();
+  // derive the variance-covariance matrix of f_loc_hat, Psi_loc*V_f*Psi_loc^t
+  MatrixXr V_f_loc = this->sigma_hat_sq * this->S_loc * this->S_loc.transpose();
 
   // compute eigenvalue decomposition of V_f_loc
   Eigen::SelfAdjointEigenSolver<MatrixXr> V_f_loc_eig(V_f_loc);
@@ -321,22 +354,26 @@ MatrixXv Wald_Base<InputHandler, MatrixType>::compute_f_CI(void){
   UInt n_loc = this->inf_car.getN_loc();
   result.resize(1, n_loc);
   
-  // make sure that variance-covariance matrix of f_hat has been computed
-  if(!is_V_f_computed){
-    this->compute_V_f();
+  // make sure that S has been computed
+  if(!is_S_computed){
+    this->compute_S();
   }
 
   // check that FSPAI inversion went well (if non-exact inference was required)
-  if(!is_V_f_computed){
+  if(!is_S_computed){
     Rprintf("error: failed FSPAI inversion in p_values computation, discarding inference"); 
     for(UInt i=0; i < n_loc; ++i){
       result(i).resize(3); 
-      result(i)(1) = 10e20; 
+      result(i)(0) = 10e20; 
+      result(i)(1) = 10e20;
       result(i)(2) = 10e20;
-      result(i)(3) = 10e20;
     }
     return result; 
   }
+
+  if(!is_sigma_hat_sq_computed){
+    this->compute_sigma_hat_sq();
+  }
   
   // get the estimator f_hat 
   UInt nnodes = this->inf_car.getN_nodes();
@@ -348,8 +385,8 @@ MatrixXv Wald_Base<InputHandler, MatrixType>::compute_f_CI(void){
   // compute local estimator 
   VectorXr f_loc_hat = Psi_loc * f_hat; 
 
-  // derive the variance-covariance matrix of f_loc_hat
-  MatrixXr V_f_loc = Psi_loc * this->V_f * Psi_loc.transpose();
+  // derive the variances of f_loc_hat, the diagonal of Psi_loc*V_f*Psi_loc^t
+  VectorXr V_f_loc_diag = this->sigma_hat_sq * this->diag_S_loc;
 
   // compute the quantile 
   Real alpha = this->inf_car.getInfData()->get_inference_alpha()[this->pos_impl];
@@ -365,7 +402,7 @@ MatrixXv Wald_Base<InputHandler, MatrixType>::compute_f_CI(void){
     result(i)(1)=f_loc_hat(i);
     
     // compute the half range of the interval
-    Real sd = std::sqrt(V_f_loc(i,i));
+    Real sd = std::sqrt(V_f_loc_diag(i));
     Real half_range=sd*quant;
     
     // compute the limits of the interval
@@ -381,20 +418,16 @@ template<typename InputHandler, typename MatrixType>
 Real Wald_Base<InputHandler, MatrixType>::compute_GCV_from_inference(void) const {
   UInt n_obs =this->inf_car.getN_obs();
   UInt q = this->inf_car.getq();
-  if(this->is_S_computed==true){
+  if(this->is_S_computed==true && this->inf_car.getRegData()->getCovariates()->rows()!=0){
     return sigma_hat_sq * n_obs /(n_obs - q - tr_S);
   } else{
-    return -1; // S has not been computed, returning default value
+    return NA_REAL; // S has not been computed, or there are no covariates: the GCV is not defined
   }
 };
 
 
 template<typename InputHandler, typename MatrixType>
 VectorXr Wald_Base<InputHandler, MatrixType>::compute_f_var(void){
-  UInt n_obs = this->inf_car.getN_obs();
-  VectorXr result; 
-  result.resize(n_obs);
-
   if(is_S_computed==false){
     this->compute_S();
   }
@@ -403,64 +436,46 @@ VectorXr Wald_Base<InputHandler, MatrixType>::compute_f_var(void){
     compute_sigma_hat_sq();
   }
 
-  const SpMat * Psi = this->inf_car.getPsip();
-  const SpMat * Psi_t = this->inf_car.getPsi_tp();
-
-  MatrixXr Q = MatrixXr::Identity(n_obs, n_obs); // if there are no covariates Q is just an identity 
-						       
-  if(this->inf_car.getRegData()->getCovariates()->rows()!=0){
-    Q = Q - *(this->inf_car.getHp());
-  }
-
-  for(long int i=0; i<n_obs; ++i){
-    result(i) = sigma_hat_sq*((*Psi).row(i))*Partial_S*Q*Partial_S.transpose()*((*Psi_t).col(i));
-  }
-  
-  return result; 
+  // diagonal of Psi*V_f*Psi^t = sigma_hat_sq*S*S^t
+  return sigma_hat_sq*diag_SSt; 
 };
 
 
 template<typename InputHandler, typename MatrixType> 
 void Wald_Exact<InputHandler, MatrixType>::compute_S(void){
-  // compute the inverse of the system matrix M by reconstructing the Woodbury decomposition
-  this->inverter->Compute_Inv();
-
-  MatrixXr M_inv;
-  M_inv.resize(this->inverter->getInv()->rows(), this->inverter->getInv()->cols());
-
-  const MatrixType * E_inv = this->inverter->getInv();
-  const VectorXr * A = this->inf_car.getAp();
-  const MatrixXr * U = this->inf_car.getUp();
-  const MatrixXr * V = this->inf_car.getVp();
-  const Eigen::PartialPivLU<MatrixXr> * G_decp = this->inf_car.getG_decp();
-  
-  M_inv = *E_inv - (*E_inv)*(*U)*((*G_decp).solve((*V)*(*E_inv)));
-  
   UInt n_obs = this->inf_car.getN_obs();
   UInt n_nodes = this->inf_car.getN_nodes();
-  this->S.resize(n_obs, n_obs);
-  const SpMat * Psi = this->inf_car.getPsip();
   const SpMat * Psi_t = this->inf_car.getPsi_tp();
-  MatrixXr Q = MatrixXr::Identity(n_obs, n_obs) - *(this->inf_car.getHp()); 
+  const VectorXr * A = this->inf_car.getAp();
+  const Eigen::SparseLU<SpMat> * E_decp = this->inf_car.getE_decp();
+  bool has_covariates = this->inf_car.getRegData()->getCovariates()->rows()!=0;
 
-  if(this->inf_car.getInfData()->get_f_var() || (this->inf_car.getInfData()->get_component_type())[this->pos_impl]!="parametric"){
-    this->Partial_S.resize(n_nodes, n_obs);
-    
-    if(this->inf_car.getRegData()->getNumberOfRegions()>0){
-      this->Partial_S = M_inv.block(0,0, n_nodes, n_nodes)*(*Psi_t)*(A->asDiagonal());
-    }else{
-      this->Partial_S = M_inv.block(0,0, n_nodes, n_nodes)*(*Psi_t);
-    }
-  }
-  else{
-    this->Partial_S.resize(1,1);
-    this->Partial_S(0) = 0;
+  // right hand side Psi^t*A*Q, built by blocks of columns (Q is the identity if there are no covariates)
+  SpMat Psi_tA = (this->inf_car.getRegData()->getNumberOfRegions()>0) ? SpMat((*Psi_t)*(A->asDiagonal())) : *Psi_t;
+  
+  // Woodbury decomposition of the system: M^-1 = E^-1 - E^-1*U*G^-1*V*E^-1, E^-1*U is computed once
+  MatrixXr E_inv_U;
+  if(has_covariates){
+    E_inv_U = E_decp->solve(*(this->inf_car.getUp()));
   }
 
-  if(this->inf_car.getRegData()->getNumberOfRegions()>0){
-    this->S = (*Psi)*M_inv.block(0,0, n_nodes, n_nodes)*((*Psi_t)*(A->asDiagonal())*Q);
-  }else{
-    this->S = (*Psi)*M_inv.block(0,0, n_nodes, n_nodes)*((*Psi_t)*Q);
+  this->init_S();
+  for(UInt first_col=0; first_col<n_obs; first_col+=this->block_size){
+    UInt n_cols = std::min(this->block_size, n_obs-first_col);
+
+    MatrixXr rhs = MatrixXr::Zero(2*n_nodes, n_cols);
+    rhs.topRows(n_nodes) = Psi_tA.middleCols(first_col, n_cols);
+    if(has_covariates){
+      rhs.topRows(n_nodes) -= Psi_tA*(this->inf_car.getHp()->middleCols(first_col, n_cols));
+    }
+
+    MatrixXr x = E_decp->solve(rhs);
+    Instrumentation::get().addCount("solves");
+    if(has_covariates){
+      x -= E_inv_U*(this->inf_car.getG_decp()->solve((*(this->inf_car.getVp()))*x));
+    }
+
+    this->accumulate_S(x.topRows(n_nodes), first_col);
   }
   
   this->is_S_computed = true;
@@ -469,29 +484,41 @@ void Wald_Exact<InputHandler, MatrixType>::compute_S(void){
 };
 
 template<typename InputHandler, typename MatrixType> 
-void Wald_Exact<InputHandler, MatrixType>::compute_B(void){
-  this->inverter->Compute_Inv();
-  // extract the inverse of E
-  const MatrixType * E_inv = this->inverter->getInv();
-  
+void Wald_Non_Exact<InputHandler, MatrixType>::compute_S(void){
   UInt n_obs = this->inf_car.getN_obs();
   UInt n_nodes = this->inf_car.getN_nodes();
-  const SpMat * Psi = this->inf_car.getPsip();
   const SpMat * Psi_t = this->inf_car.getPsi_tp();
   const VectorXr * A = this->inf_car.getAp();
-  
-  this->B.resize(n_obs,n_obs);
-  this->Partial_S.resize(n_nodes, n_obs);
-  
-  if(this->inf_car.getRegData()->getNumberOfRegions()>0){
-    this->B = (*Psi)*((*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t)*(A->asDiagonal()));
-    this->Partial_S = (*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t)*(A->asDiagonal());
-  }else{
-    this->B = (*Psi)*((*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t));
-    this->Partial_S = (*E_inv).block(0,0, n_nodes, n_nodes)*(*Psi_t);
+  bool has_covariates = this->inf_car.getRegData()->getCovariates()->rows()!=0;
+
+  // right hand side Psi^t*A*Q, built by blocks of columns (Q is the identity if there are no covariates)
+  SpMat Psi_tA = (this->inf_car.getRegData()->getNumberOfRegions()>0) ? SpMat((*Psi_t)*(A->asDiagonal())) : *Psi_t;
+
+  // Woodbury decomposition of the system: M^-1 = E^-1 - E^-1*U*G^-1*V*E^-1, U and V are zero outside their first n_nodes rows and columns respectively
+  MatrixXr E_inv_U;
+  if(has_covariates){
+    E_inv_U = this->inverter->apply_upper_left_block(this->inf_car.getUp()->topRows(n_nodes));
   }
 
-  this->is_B_computed = true;
+  this->init_S();
+  for(UInt first_col=0; first_col<n_obs; first_col+=this->block_size){
+    UInt n_cols = std::min(this->block_size, n_obs-first_col);
+
+    MatrixXr rhs = Psi_tA.middleCols(first_col, n_cols);
+    if(has_covariates){
+      rhs -= Psi_tA*(this->inf_car.getHp()->middleCols(first_col, n_cols));
+    }
 
+    // approximate upper left block of the inverse of E, the only one that multiplies the right hand side
+    MatrixXr x = this->inverter->apply_upper_left_block(rhs);
+    if(has_covariates){
+      x -= E_inv_U*(this->inf_car.getG_decp()->solve(this->inf_car.getVp()->leftCols(n_nodes)*x));
+    }
+
+    this->accumulate_S(x, first_col);
+  }
+  
+  this->is_S_computed = true;
+  
   return; 
 };
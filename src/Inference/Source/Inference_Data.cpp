@@ -16,12 +16,14 @@
   \param inference_Quantile_ vector parameter containing the quantiles to be used for the computation of the confidence intervals (if interval_type is defined)
   \param inference_Alpha_ significance used to compute ESF confidence intervals
   \param n_Flip_ parameter that provides the number of sign-flips to be used for the eigen-sign-flip tests (if they are required)
+  \param seed_Flip_ parameter that provides the seed of the sign-flips (0 or missing for a random seed)
+  \param mc_Error_ parameter that provides the error probability of the early stopping of the sign-flip tests (0 or missing to perform all the sign-flips)
   \param tol_Fspai_ parameter that provides the tolerance used in the FSPAI algorithm
   \param definition_ parameter used to set definition of the InferenceData object
 */
 InferenceData::InferenceData(SEXP test_Type_, SEXP interval_Type_, SEXP implementation_Type_, SEXP component_Type_, SEXP exact_Inference_,
 			     SEXP locs_Inference_, SEXP locs_index_Inference_, SEXP locs_are_nodes_, SEXP coeff_Inference_, SEXP beta_0_,SEXP f0_eval_, SEXP f_Var_,
-			     SEXP inference_Quantile_, SEXP inference_Alpha_, SEXP n_Flip_, SEXP tol_Fspai_, SEXP definition_){
+			     SEXP inference_Quantile_, SEXP inference_Alpha_, SEXP n_Flip_, SEXP seed_Flip_, SEXP mc_Error_, SEXP tol_Fspai_, SEXP definition_){
   //test_Type
   UInt size_test_Type=Rf_length(test_Type_);
   test_Type.resize(size_test_Type);
@@ -163,6 +165,14 @@ InferenceData::InferenceData(SEXP test_Type_, SEXP interval_Type_, SEXP implemen
   //n_flip
   this->set_n_Flip(INTEGER(n_Flip_)[0]);
 
+  //seed_Flip (not set by the default inference objects built in R)
+  if(Rf_length(seed_Flip_)>0)
+    this->set_seed_Flip(INTEGER(seed_Flip_)[0]);
+
+  //mc_Error (not set by the default inference objects built in R)
+  if(Rf_length(mc_Error_)>0)
+    this->set_mc_Error(REAL(mc_Error_)[0]);
+
   //tol_Fspai
   this->set_tol_Fspai(REAL(tol_Fspai_)[0]);
 
@@ -189,12 +199,14 @@ InferenceData::InferenceData(SEXP test_Type_, SEXP interval_Type_, SEXP implemen
   \param inference_Quantile_ vector parameter containing the quantiles to be used for the computation of the confidence intervals (if interval_type is defined)
   \param inference_Alpha_ significance used to compute ESF confidence intervals
   \param n_Flip_ parameter that provides the number of sign-flips to be used for the eigen-sign-flip tests (if they are required)
+  \param seed_Flip_ parameter that provides the seed of the sign-flips (0 or missing for a random seed)
+  \param mc_Error_ parameter that provides the error probability of the early stopping of the sign-flip tests (0 or missing to perform all the sign-flips)
   \param tol_Fspai_ parameter that provides the tolerance used in the FSPAI algorithm
   \param definition_ parameter used to set definition of the InferenceData object
 */
 InferenceData::InferenceData(SEXP test_Type_, SEXP interval_Type_, SEXP implementation_Type_, SEXP component_Type_,
 			     SEXP exact_Inference_, SEXP locs_Inference_, SEXP locs_index_Inference_, SEXP locs_are_nodes_, SEXP time_locs_inf_ ,SEXP coeff_Inference_, SEXP beta_0_,
-			     SEXP f0_eval_, SEXP f_Var_,SEXP inference_Quantile_, SEXP inference_Alpha_, SEXP n_Flip_, SEXP tol_Fspai_, SEXP definition_):InferenceData(test_Type_, interval_Type_, implementation_Type_, component_Type_, exact_Inference_, locs_Inference_, locs_index_Inference_, locs_are_nodes_, coeff_Inference_, beta_0_, f0_eval_, f_Var_, inference_Quantile_, inference_Alpha_, n_Flip_, tol_Fspai_, definition_){
+			     SEXP f0_eval_, SEXP f_Var_,SEXP inference_Quantile_, SEXP inference_Alpha_, SEXP n_Flip_, SEXP seed_Flip_, SEXP mc_Error_, SEXP tol_Fspai_, SEXP definition_):InferenceData(test_Type_, interval_Type_, implementation_Type_, component_Type_, exact_Inference_, locs_Inference_, locs_index_Inference_, locs_are_nodes_, coeff_Inference_, beta_0_, f0_eval_, f_Var_, inference_Quantile_, inference_Alpha_, n_Flip_, seed_Flip_, mc_Error_, tol_Fspai_, definition_){
 
   //time_locs_inf
   UInt size_time_locs_inf=Rf_length(time_locs_inf_); 
@@ -287,6 +299,8 @@ void InferenceData::print_inference_data() const{
   }
 
   Rprintf("n_Flip: %lu\n", n_Flip);
+  Rprintf("seed_Flip: %d\n", seed_Flip);
+  Rprintf("mc_Error: %f\n", mc_Error);
   Rprintf("tol_Fspai: %f\n", tol_Fspai);
   Rprintf("definition: %d\n",definition);
 };
@@ -1,10 +1,173 @@
 #include "../Include/Inverter.h"
+#include "../../Global_Utilities/Include/Instrumentation.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
-void Inverse_Exact::Compute_Inv(void){
-  if(!this->inverse_computed){
-    this->E_inv=this->E_decp->solve(MatrixXr::Identity(Ep->rows(),Ep->cols())); //Solve directly the system for an identity matrix
-    this->inverse_computed=true;
+namespace
+{
+  //! Factorized sparse approximate inverse of a symmetric positive definite matrix K: a sparse G such that K^-1 is approximated by G^t*G
+  /*!
+    G is lower triangular up to a diagonal scaling: K is scaled to unit diagonal, K = D^-1*K_s*D^-1, the factor of K_s is computed row by row and
+    G = G_s*D is returned. The pattern of each row starts from the lower triangular pattern of K and it is enlarged, at most max_steps times, with the
+    max_new indices with the largest residual, until the norm of the residual of the row is below tol; n_failed counts the rows that did not reach it.
+  */
+  SpMat fspai(const SpMat & K, Real tol, UInt max_steps, UInt max_new, UInt & n_failed)
+  {
+    const UInt n = K.rows();
+    VectorXr D = VectorXr::Ones(n);
+    for(UInt k=0; k<n; ++k)
+      if(K.coeff(k, k) > 0)
+	D(k) = 1/std::sqrt(K.coeff(k, k));
+    const SpMat K_s = D.asDiagonal()*K*D.asDiagonal();
+
+    // rows of the factor G (pattern and values), filled independently by the threads
+    std::vector<std::vector<std::pair<UInt, Real>>> rows(n);
+
+    #pragma omp parallel reduction(+:n_failed)
+    {
+      // local position of the indices in the current pattern and of the entries of the residual, -1 if not present (reset after each row)
+      std::vector<int> pattern_pos(n, -1), residual_pos(n, -1);
+      std::vector<UInt> J, touched;
+      std::vector<Real> residual;
+      std::vector<std::pair<Real, UInt>> candidates;
+
+      #pragma omp for schedule(dynamic, 64)
+      for(UInt i=0; i<n; ++i){
+	// initial pattern: lower triangular pattern of the i-th row of K, i being the last index
+	J.clear();
+	for(SpMat::InnerIterator it(K_s, i); it; ++it)
+	  if(UInt(it.row())<i){
+	    pattern_pos[it.row()] = J.size();
+	    J.push_back(it.row());
+	  }
+	pattern_pos[i] = J.size();
+	J.push_back(i);
+
+	VectorXr y;
+	for(UInt step=0; ; ++step){
+	  // K(J,J)*y = e_i(J)
+	  MatrixXr K_JJ = MatrixXr::Zero(J.size(), J.size());
+	  for(std::size_t c=0; c<J.size(); ++c)
+	    for(SpMat::InnerIterator it(K_s, J[c]); it; ++it)
+	      if(pattern_pos[it.row()]!=-1)
+		K_JJ(pattern_pos[it.row()], c) = it.value();
+	  VectorXr e_i = VectorXr::Zero(J.size());
+	  e_i(pattern_pos[i]) = 1;
+	  y = K_JJ.ldlt().solve(e_i);
+
+	  // residual K(:,J)*y - e_i on the indices lower than i outside the pattern, the only ones controlled by the factor
+	  for(UInt j : touched) residual_pos[j] = -1;
+	  touched.clear();
+	  residual.clear();
+	  for(std::size_t c=0; c<J.size(); ++c)
+	    for(SpMat::InnerIterator it(K_s, J[c]); it; ++it){
+	      const UInt j = it.row();
+	      if(j>=i || pattern_pos[j]!=-1) continue;
+	      if(residual_pos[j]==-1){
+		residual_pos[j] = touched.size();
+		touched.push_back(j);
+		residual.push_back(0);
+	      }
+	      residual[residual_pos[j]] += it.value()*y(c);
+	    }
+	  Real res_sq = 0;
+	  for(Real r : residual) res_sq += r*r;
+	  if(res_sq <= tol*tol)
+	    break;
+	  if(step==max_steps){
+	    ++n_failed;
+	    break;
+	  }
+
+	  // the indices with the largest residual enter the pattern, ties broken by the index to keep the pattern independent of the thread
+	  candidates.clear();
+	  for(std::size_t t=0; t<touched.size(); ++t)
+	    candidates.emplace_back(-residual[t]*residual[t], touched[t]);
+	  const UInt n_new = std::min<UInt>(max_new, candidates.size());
+	  std::partial_sort(candidates.begin(), candidates.begin()+n_new, candidates.end());
+	  for(UInt c=0; c<n_new; ++c){
+	    pattern_pos[candidates[c].second] = J.size();
+	    J.push_back(candidates[c].second);
+	  }
+	}
+
+	// G(i,J) = y/sqrt(y_i), so that (G*K*G^t)(i,i) = 1
+	const Real scale = 1/std::sqrt(std::abs(y(pattern_pos[i])));
+	rows[i].reserve(J.size());
+	for(std::size_t c=0; c<J.size(); ++c){
+	  rows[i].emplace_back(J[c], y(c)*scale);
+	  pattern_pos[J[c]] = -1;
+	}
+      }
+      for(UInt j : touched) residual_pos[j] = -1;
+    }
+
+    std::vector<coeff> triplets;
+    for(UInt i=0; i<n; ++i)
+      for(const auto & entry : rows[i])
+	triplets.emplace_back(i, entry.first, entry.second);
+    SpMat G(n, n);
+    G.setFromTriplets(triplets.begin(), triplets.end());
+
+    return G*D.asDiagonal();
+  }
+}
+
+MatrixXr Inverse_Exact::apply_upper_left_block(const MatrixXr & B){
+  // solve the whole system with a right hand side that is zero in its lower block, and keep the upper block of the solution
+  MatrixXr rhs = MatrixXr::Zero(Ep->rows(), B.cols());
+  rhs.topRows(B.rows()) = B;
+  MatrixXr x = this->E_decp->solve(rhs);
+  Instrumentation::get().addCount("solves");
+
+  return x.topRows(B.rows());
+};
+
+MatrixXr Inverse_Exact::apply_upper_left_block(const SpMat & B){
+  return apply_upper_left_block(MatrixXr(B));
+};
+
+MatrixXr Inverse_Non_Exact::apply_upper_left_block(const MatrixXr & B){
+  Compute_Inv();
+  return E_inv*B;
+};
+
+SpMat Inverse_Non_Exact::apply_upper_left_block(const SpMat & B){
+  Compute_Inv();
+  return E_inv*B;
+};
+
+void Inverse_Non_Exact::Compute_Inv(void){
+  if(this->inverse_computed){
+    return;
   }
-  
+  ScopedPhase phase("fspai");
+
+  const UInt n = Ep->rows()/2;
+  UInt n_failed = 0;
+
+  // C = -E(n:2n, n:2n) is a mass matrix, whose inverse is well approximated by a sparse factor: C^-1 = G_C^t*G_C
+  // (the penalized rows of the Dirichlet boundary conditions have a huge diagonal of the wrong sign, only its magnitude matters)
+  SpMat C = -SpMat(Ep->bottomRightCorner(n, n));
+  for(UInt k=0; k<n; ++k)
+    C.coeffRef(k, k) = std::abs(C.coeff(k, k));
+  const SpMat G_C = fspai(C, tol_Fspai, max_steps, max_new, n_failed);
+
+  // Schur complement K = A + B^t*C^-1*B, sparse since C^-1 is replaced by its factorized approximation
+  const SpMat G_CB = G_C*SpMat(Ep->bottomLeftCorner(n, n));
+  SpMat K = SpMat(Ep->topLeftCorner(n, n)) + SpMat(G_CB.transpose()*G_CB);
+  K = 0.5*(K + SpMat(K.transpose()));
+
+  // upper left block of the inverse of E: K^-1 = G_K^t*G_K
+  const SpMat G_K = fspai(K, tol_Fspai, max_steps, max_new, n_failed);
+  this->E_inv = G_K.transpose()*G_K;
+  this->E_inv.makeCompressed();
+
+  status_inverse = (n_failed==0);
+  Instrumentation::get().setCount("fspai_nnz", this->E_inv.nonZeros());
+  Instrumentation::get().setCount("fspai_failed_rows", n_failed);
+  this->inverse_computed = true;
+
   return;
 };
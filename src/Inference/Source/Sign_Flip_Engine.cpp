@@ -0,0 +1,135 @@
+#include "../Include/Sign_Flip_Engine.h"
+#include <cmath>
+#include <random>
+
+namespace
+{
+  //! Finalizer of splitmix64: a bijection of the 64-bit integers whose output bits are all well mixed
+  inline std::uint64_t mix(std::uint64_t x)
+  {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  const std::uint64_t golden_gamma = 0x9e3779b97f4a7c15ULL;
+}
+
+std::uint64_t Sign_Flip_Engine::make_seed(UInt user_seed){
+  if(user_seed > 0)
+    return user_seed;
+
+  std::random_device rd;
+  return (std::uint64_t(rd()) << 32) ^ rd();
+};
+
+std::uint64_t Sign_Flip_Engine::sign_word(std::uint64_t seed, std::uint64_t stream, unsigned long int flip, UInt word){
+  const std::uint64_t key = mix(seed + golden_gamma*(stream + 1));
+  return mix(mix(key ^ (golden_gamma*(std::uint64_t(flip) + 1))) + golden_gamma*(std::uint64_t(word) + 1));
+};
+
+UInt Sign_Flip_Engine::block_size(UInt m){
+  // at most 2^17 signs (1 MB) for each block, between 16 and 256 flips
+  const UInt max_signs = 1 << 17;
+  return std::max<UInt>(16, std::min<UInt>(256, max_signs/std::max<UInt>(m, 1)));
+};
+
+Real Sign_Flip_Engine::mc_band(unsigned long int n, UInt m, Real error) const{
+  // P(|fraction - limit| > band) <= 2 exp(-2 n band^2) for each of the rounds
+  const Real n_rounds = std::ceil(Real(n_blocks(m))/round_blocks);
+  return std::sqrt(std::log(2*n_rounds/error)/(2*Real(n)));
+};
+
+void Sign_Flip_Engine::fill_signs(MatrixXr & S, unsigned long int first_flip, UInt n_block) const{
+  const UInt m = S.rows();
+  const UInt n_words = (m + 63)/64;
+
+  for(UInt c=0; c<n_block; ++c){
+    Real * column = S.col(c).data();
+    for(UInt w=0; w<n_words; ++w){
+      std::uint64_t bits = sign_word(seed, stream, first_flip + c, w);
+      const UInt last = std::min<UInt>(m, 64*(w + 1));
+      for(UInt j=64*w; j<last; ++j, bits >>= 1)
+	column[j] = (bits & 1) ? 1. : -1.;
+    }
+  }
+};
+
+Real Sign_Flip_Line::pvalue(Real v) const{
+  const Real stat = observed_base + v*observed_slope;
+  unsigned long int count_Up = 0;   // Counter for the number of flipped statistics that are larger the observed statistic
+  unsigned long int count_Down = 0; // Counter for the number of flipped statistics that are smaller the observed statistic
+
+  for(UInt i=0; i<flipped.cols(); ++i){
+    const Real stat_flip = flipped(0,i) + v*flipped(1,i);
+    if(stat_flip > stat){ ++count_Up;}else{
+      if(stat_flip < stat){ ++count_Down;}
+    }
+  }
+
+  return Real(std::min(count_Up, count_Down))/flipped.cols();
+};
+
+bool Sign_Flip_Line::search_bound(Real center, Real & inner, Real & outer, Real tolerance, Real alpha, UInt max_iter) const{
+  Real p_inner = pvalue(inner);
+  Real p_outer = pvalue(outer);
+
+  for(UInt iter=0; iter<max_iter; ++iter){
+    if(p_outer>alpha){ // outer limit excessively tight
+      outer = outer + 0.5*(outer - inner);
+      p_outer = pvalue(outer);
+    }else{
+      if(p_inner<alpha){ // inner limit excessively tight
+	inner = center + 0.5*(inner - center);
+	p_inner = pvalue(inner);
+      }else{ // both the limits are well defined
+	if(std::abs(outer - inner)<tolerance){
+	  return true;
+	}
+
+	Real proposal = 0.5*(outer + inner);
+	Real prop_p_val = pvalue(proposal);
+
+	if(prop_p_val<=alpha){outer=proposal; p_outer=prop_p_val;}else{inner=proposal; p_inner=prop_p_val;}
+      }
+    }
+  }
+
+  return false;
+};
+
+void Sign_Flip_Projector::compute(const MatrixXr & W){
+  n = W.rows();
+  q = W.cols();
+  if(q > 0)
+    W_dec.compute(W);
+};
+
+MatrixXr Sign_Flip_Projector::project(const MatrixXr & R) const{
+  if(q == 0)
+    return R;
+
+  // Q*R = H * [0; (H^t R) without its first q rows]
+  MatrixXr HtR = W_dec.householderQ().adjoint() * R;
+  HtR.topRows(q).setZero();
+  return W_dec.householderQ() * HtR;
+};
+
+MatrixXr Sign_Flip_Projector::to_basis(const MatrixXr & R) const{
+  if(q == 0)
+    return R;
+
+  return (W_dec.householderQ().adjoint() * R).bottomRows(n - q);
+};
+
+MatrixXr Sign_Flip_Projector::from_basis(const MatrixXr & X) const{
+  if(q == 0)
+    return X;
+
+  MatrixXr Y = MatrixXr::Zero(n, X.cols());
+  Y.bottomRows(n - q) = X;
+  return W_dec.householderQ() * Y;
+};
@@ -9,6 +9,7 @@
 #include "Function_Variadic.h"
 #include "Solution_Builders.h"
 #include "../../Global_Utilities/Include/Lambda.h"
+#include "../../Global_Utilities/Include/Print_Buffer.h"
 
 // CLASSES
 //! Father class for a scalar function evaluation of a given vector of lambda values computing the minimum fuction value
@@ -62,7 +63,7 @@ class Vec_evaluation
 
                         for (UInt i=0; i<dim; i++)
                         {
-                                Rprintf("Grid: evaluating %d/%d\n", i+1, dim);
+                                fdaPDE::Rprintf_buffered("Grid: evaluating %d/%d\n", i+1, dim);
                                 this->F.set_index(i);
                                 evaluations[i] = this->F.evaluate_f(this->lambda_vec[i]); //only scalar functions;
 
@@ -9,6 +9,8 @@
 #include "../../FE_Assemblers_Solvers/Include/Solver.h"
 #include <algorithm>
 #include "../../Global_Utilities/Include/Lambda.h"
+#include "../../Global_Utilities/Include/Instrumentation.h"
+#include "../../Global_Utilities/Include/Print_Buffer.h"
 
 // CLASSES
 // **** GENERAL METHODS ***
@@ -668,9 +668,9 @@ void GCV_Exact<InputCarrier, 1>::update_dor(lambda::type<1> lambda)
 
         if (this->dor < 0)   // Just in case of bad computation
         {
-                Rprintf("WARNING: Some values of the trace of the matrix S('lambda') are inconstistent.\n");
-                Rprintf("This might be due to ill-conditioning of the linear system.\n");
-                Rprintf("Try increasing value of 'lambda'. Value of 'lambda' that produces an error is: %e \n", lambda);
+                fdaPDE::Rprintf_buffered("WARNING: Some values of the trace of the matrix S('lambda') are inconstistent.\n");
+                fdaPDE::Rprintf_buffered("This might be due to ill-conditioning of the linear system.\n");
+                fdaPDE::Rprintf_buffered("Try increasing value of 'lambda'. Value of 'lambda' that produces an error is: %e \n", lambda);
         }
 
         // Debugging purpose
@@ -685,9 +685,9 @@ void GCV_Exact<InputCarrier, 2>::update_dor(lambda::type<2> lambda)
 
         if (this->dor < 0)   // Just in case of bad computation
         {
-                Rprintf("WARNING: Some values of the trace of the matrix S('lambda') are inconstistent.\n");
-                Rprintf("This might be due to ill-conditioning of the linear system.\n");
-                Rprintf("Try increasing value of 'lambda'. Value of 'lambda' that produces an error is: (%e, %e) \n", lambda(0), lambda(1));
+                fdaPDE::Rprintf_buffered("WARNING: Some values of the trace of the matrix S('lambda') are inconstistent.\n");
+                fdaPDE::Rprintf_buffered("This might be due to ill-conditioning of the linear system.\n");
+                fdaPDE::Rprintf_buffered("Try increasing value of 'lambda'. Value of 'lambda' that produces an error is: (%e, %e) \n", lambda(0), lambda(1));
         }
 
         // Debugging purpose
@@ -735,6 +735,7 @@ void GCV_Exact<InputCarrier, 2>::update_matrices(lambda::type<2> lambda)
 template<typename InputCarrier>
 void GCV_Exact<InputCarrier, 1>::update_parameters(lambda::type<1> lambda)
 {
+        ScopedPhase phase("dof");
         // this order must be kept
         this->update_matrices(lambda);
         this->update_errors(lambda);
@@ -743,6 +744,7 @@ void GCV_Exact<InputCarrier, 1>::update_parameters(lambda::type<1> lambda)
 template<typename InputCarrier>
 void GCV_Exact<InputCarrier, 2>::update_parameters(lambda::type<2> lambda)
 {
+        ScopedPhase phase("dof");
         // this order must be kept
         this->update_matrices(lambda);
         this->update_errors(lambda);
@@ -978,6 +980,7 @@ void GCV_Stochastic<InputCarrier, size>::set_US_(void)
 template<typename InputCarrier, UInt size>
 void GCV_Stochastic<InputCarrier, size>::update_dof(lambda::type<size> lambda)
 {
+        ScopedPhase phase("dof");
         MatrixXr m = this->the_carrier.get_opt_data()->get_DOF_matrix();
         
         div_t divresult = div(this->use_index, this->the_carrier.get_opt_data()->get_size_S());
@@ -1075,7 +1078,7 @@ void GCV_Stochastic<InputCarrier, size>::update_dof(lambda::type<size> lambda)
         }
         else
         {
-                Rprintf("No DOF computation required\n");
+                fdaPDE::Rprintf_buffered("No DOF computation required\n");
                 this->dof = m(divresult.rem,divresult.quot);
                 //std::cout<< this->dof << std::endl;
         }
@@ -1095,8 +1098,8 @@ void GCV_Stochastic<InputCarrier, size>::update_dor(lambda::type<size> lambda)
 
         if (this->dor < 0)   // Just in case of bad computation
         {
-                Rprintf("WARNING: Some values of the trace of the matrix S('lambda') are inconstistent.\n");
-                Rprintf("This might be due to ill-conditioning of the linear system.\n");
+                fdaPDE::Rprintf_buffered("WARNING: Some values of the trace of the matrix S('lambda') are inconstistent.\n");
+                fdaPDE::Rprintf_buffered("This might be due to ill-conditioning of the linear system.\n");
                 //printing not generalized for uni- and bi- dimensional lambda
                 //Rprintf("Try increasing value of 'lambda'. Value of 'lambda' that produces an error is: %e \n", lambda);
         }
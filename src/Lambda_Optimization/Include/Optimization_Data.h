@@ -69,8 +69,8 @@ class  OptimizationData
                 inline void set_criterion(const std::string && criterion_) {criterion = criterion_;}                            //!< Setter of criterion \param criterion_ new criterion
                 inline void set_DOF_evaluation(const std::string && DOF_evaluation_) {DOF_evaluation = DOF_evaluation_;}        //!< Setter of DOF_evaluation \param DOF_evaluation_ new DOF_evaluation
                 inline void set_loss_function(const std::string && loss_function_) {loss_function = loss_function_;}            //!< Setter of loss_function \param loss_function_ new \loss_function
-                inline void set_lambda_S(const std::vector<Real> & lambda_S_) {lambda_S = lambda_S_;}                           //!< Setter of lambda_S vector \param lambda_S_ new lambda_S
-                inline void set_lambda_T(const std::vector<Real> & lambda_T_) {lambda_T = lambda_T_;}                           //!< Setter of lambda_T vector \param lambda_T_ new lambda_T
+                inline void set_lambda_S(const std::vector<Real> & lambda_S_) {lambda_S = lambda_S_; size_S = lambda_S_.size();} //!< Setter of lambda_S vector \param lambda_S_ new lambda_S
+                inline void set_lambda_T(const std::vector<Real> & lambda_T_) {lambda_T = lambda_T_; size_T = lambda_T_.size();} //!< Setter of lambda_T vector \param lambda_T_ new lambda_T
                 inline void set_best_lambda_S(const UInt best_lambda_S_) {best_lambda_S = best_lambda_S_;}                      //!< Setter of best_lambda_S \param best_lambda_S_ new best_lambda_S
                 inline void set_best_lambda_T(const UInt best_lambda_T_) {best_lambda_T = best_lambda_T_;}                      //!< Setter of best_lambda_T \param best_lambda_T_ new best_lambda_T
                 inline void set_best_value(const Real best_value_) {best_value = best_value_;}                                  //!< Setter of best_value \param best_value_ new best_value
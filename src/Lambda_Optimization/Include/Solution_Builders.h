@@ -9,6 +9,7 @@
 #include "../../Mesh/Include/Mesh.h"
 #include "../../Regression/Include/Regression_Data.h"
 #include "../../Global_Utilities/Include/Lambda.h"
+#include "../../Global_Utilities/Include/Instrumentation.h"
 #include "../../Inference/Include/Inference_Data.h"
 
 //! Output struct to be used to return values in R
@@ -49,7 +50,7 @@ namespace Solution_Builders
          \param regressionData the original data passed by the user
          \param inference_Output the matrix collecting the inference output 
          \param inf_Data the object containing the inference data passed by the user
-         \return SEXP containg all the data that will be managed by R code
+         \return SEXP containg all the data that will be managed by R code, the last element being the content of the Instrumentation registry
         */
         template<typename InputHandler, UInt ORDER, UInt mydim, UInt ndim>
         static SEXP build_solution_plain_regression(const MatrixXr & solution, const output_Data<1> & output, const MeshHandler<ORDER, mydim, ndim> & mesh, const InputHandler & regressionData, const MixedFERegression<InputHandler>& regression,  const MatrixXv & inference_Output, const InferenceData & inf_Data); 
@@ -4,6 +4,8 @@
 template<typename InputHandler, UInt ORDER, UInt mydim, UInt ndim>
 SEXP Solution_Builders::build_solution_plain_regression(const MatrixXr & solution, const output_Data<1> & output, const MeshHandler<ORDER, mydim, ndim> & mesh , const InputHandler & regressionData, const MixedFERegression<InputHandler>& regression,  const MatrixXv & inference_Output, const InferenceData & inf_Data)
 {
+        ScopedPhase output_phase("output");
+
         // ---- Preparation ----
         // Prepare regression coefficients space
         MatrixXv beta;
@@ -66,6 +68,15 @@ SEXP Solution_Builders::build_solution_plain_regression(const MatrixXr & solutio
               f_var(0,0)(i) = 10e20;
            }
         }
+
+        // Prepare the sign-flips summary: number of sign-flips used and Monte Carlo standard error of the p-values on beta and on f of each implementation
+        MatrixXr flips_info;
+        if(inf_Data.get_definition()==false){
+           flips_info = MatrixXr::Constant(4, 1, 10e20);
+        }
+        else{
+           flips_info = Eigen::Map<const MatrixXr>(inference_Output(2*n_inf_implementations,1).data(), 4, n_inf_implementations);
+        }
 	
         // Define string for optimzation method
         UInt code_string;
@@ -87,7 +98,7 @@ SEXP Solution_Builders::build_solution_plain_regression(const MatrixXr & solutio
 
         // ---- Copy results in R memory ----
         SEXP result = NILSXP;  // Define emty term --> never pass to R empty or is "R session aborted"
-        result = PROTECT(Rf_allocVector(VECSXP, 25)); // 25 elements to be allocated
+        result = PROTECT(Rf_allocVector(VECSXP, 27)); // 27 elements to be allocated
 
         // Add solution matrix in position 0
         SET_VECTOR_ELT(result, 0, Rf_allocMatrix(REALSXP, solution.rows(), solution.cols()));
@@ -272,8 +283,20 @@ SEXP Solution_Builders::build_solution_plain_regression(const MatrixXr & solutio
         {
                rans14[j] = f_var(0)[j];
         }
-        
-        
+
+        // sign-flips summary
+        SET_VECTOR_ELT(result, 25, Rf_allocMatrix(REALSXP, flips_info.rows(), flips_info.cols()));
+        Real *rans15 = REAL(VECTOR_ELT(result, 25));
+        for(UInt j = 0; j < flips_info.cols(); j++)
+        {
+                for(UInt i = 0; i < flips_info.rows(); i++)
+                        rans15[i + flips_info.rows()*j] = flips_info(i,j);
+        }
+
+        // Timings and counters, including the time spent here
+        output_phase.stop();
+        SET_VECTOR_ELT(result, 26, Instrumentation::get().toR());
+
         UNPROTECT(1);
 
         return(result);
@@ -283,6 +306,8 @@ SEXP Solution_Builders::build_solution_plain_regression(const MatrixXr & solutio
 template<typename InputHandler, UInt ORDER, UInt mydim, UInt ndim>
 static SEXP Solution_Builders::build_solution_temporal_regression(const MatrixXr & solution, const output_Data<2> & output, const MeshHandler<ORDER, mydim, ndim> & mesh, const InputHandler & regressionData, const MixedFERegression<InputHandler>& regression,   const MatrixXv & inference_Output, const InferenceData & inf_Data)
 {
+  ScopedPhase output_phase("output");
+
   std::vector<Real> const & dof = output.dof;
   std::vector<Real> const & GCV = output.GCV_evals;
   div_t divresult = div(output.lambda_pos, output.size_S); // from the pair index, reconstruct the original indices of LambdaS, LambdaT
@@ -354,6 +379,15 @@ static SEXP Solution_Builders::build_solution_temporal_regression(const MatrixXr
     }
   }
 
+  //!Prepare the sign-flips summary: number of sign-flips used and Monte Carlo standard error of the p-values on beta and on f of each implementation
+  MatrixXr flips_info;
+  if(inf_Data.get_definition()==false){
+    flips_info = MatrixXr::Constant(4, 1, 10e20);
+  }
+  else{
+    flips_info = Eigen::Map<const MatrixXr>(inference_Output(2*n_inf_implementations,1).data(), 4, n_inf_implementations);
+  }
+
          
   // Define string for optimzation method
   UInt code_string;
@@ -369,7 +403,7 @@ static SEXP Solution_Builders::build_solution_temporal_regression(const MatrixXr
 
   //!Copy result in R memory
   SEXP result = NILSXP;
-  result = PROTECT(Rf_allocVector(VECSXP, 5+5+2+11+3));
+  result = PROTECT(Rf_allocVector(VECSXP, 5+5+2+11+3+1+1));
   SET_VECTOR_ELT(result, 0, Rf_allocMatrix(REALSXP, solution.rows(), solution.cols()));
   if(code_string == 0) //Newton
     {
@@ -563,7 +597,20 @@ static SEXP Solution_Builders::build_solution_temporal_regression(const MatrixXr
     {
       rans25[j] = f_var(0)[j];
     }
-    
+
+  // sign-flips summary
+  SET_VECTOR_ELT(result, 26, Rf_allocMatrix(REALSXP, flips_info.rows(), flips_info.cols()));
+  Real *rans26 = REAL(VECTOR_ELT(result, 26));
+  for(UInt j = 0; j < flips_info.cols(); j++)
+    {
+      for(UInt i = 0; i < flips_info.rows(); i++)
+	rans26[i + flips_info.rows()*j] = flips_info(i,j);
+    }
+
+  // Timings and counters, including the time spent here
+  output_phase.stop();
+  SET_VECTOR_ELT(result, 27, Instrumentation::get().toR());
+
   UNPROTECT(1);
   return(result);
 }
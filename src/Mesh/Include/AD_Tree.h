@@ -72,10 +72,29 @@ protected:
 
   void setTree(const RNumericMatrix& points, const RIntegerMatrix& triangle);
 
+  /** It fills the tree from its flattened representation (the one returned to R by tree_mesh_construction).
+   */
+  void setTree(int tree_lev, const std::vector<Real>& origin, const std::vector<Real>& scalingfactors, UInt num_tree_nodes,
+               const Id* id, const int* left_child, const int* right_child, const Real* box);
+
 public:
 
 	ADTree(SEXP Rmesh);
 
+  /// Builds the tree from the nodes and the elements of a mesh.
+  ADTree(const RNumericMatrix& points, const RIntegerMatrix& triangle) {setTree(points, triangle);}
+
+  /** Rebuilds an already computed tree from its flattened representation.
+   *
+   * 	\param[in] tree_lev Tree levels.
+   * 	\param[in] origin, scalingfactors Origin and scaling factors of the tree's domain.
+   * 	\param[in] num_tree_nodes Number of tree nodes, head included.
+   * 	\param[in] id, left_child, right_child, box Column-major arrays with the information of each tree node.
+   */
+  ADTree(int tree_lev, const std::vector<Real>& origin, const std::vector<Real>& scalingfactors, UInt num_tree_nodes,
+         const Id* id, const int* left_child, const int* right_child, const Real* box)
+  {setTree(tree_lev, origin, scalingfactors, num_tree_nodes, id, left_child, right_child, box);}
+
   /// Returns a reference to the tree header.
   inline TreeHeader<Shape> gettreeheader() const { return header_; }
   /** Adds a node to the tree.
@@ -76,31 +76,32 @@ template<class Shape>
 void ADTree<Shape>::setTree(SEXP Rmesh){
   int tree_loc_ = INTEGER(Rf_getAttrib(VECTOR_ELT(Rmesh, 3), R_DimSymbol))[0];
   int tree_lev_ = INTEGER(VECTOR_ELT(Rmesh, 11))[0];
-  int ndimp_ = Shape::dp();
-  int ndimt_ = 2*ndimp_;
-  int nele_ = tree_loc_;
-  int iava_ = tree_loc_+1;
-  int iend_ = tree_loc_+1;
+  int ndimt_ = 2*Shape::dp();
 
   std::vector<Real>  origin_;
   origin_.assign(REAL(VECTOR_ELT(Rmesh, 12)), REAL(VECTOR_ELT(Rmesh, 12))+ndimt_);
   std::vector<Real> scalingfactors_;
   scalingfactors_.assign(REAL(VECTOR_ELT(Rmesh, 13)), REAL(VECTOR_ELT(Rmesh, 13))+ndimt_);
 
-  Domain<Shape> tree_domain(origin_, scalingfactors_);
-  header_ = TreeHeader<Shape>(tree_loc_, tree_lev_, ndimp_, ndimt_, nele_, iava_, iend_, tree_domain);
+  //treenode information (number of nodes = number of elements+1)
+  setTree(tree_lev_, origin_, scalingfactors_, tree_loc_+1, INTEGER(VECTOR_ELT(Rmesh, 14)),
+          INTEGER(VECTOR_ELT(Rmesh, 15)), INTEGER(VECTOR_ELT(Rmesh, 16)), REAL(VECTOR_ELT(Rmesh, 17)));
+}
 
 
-  //treenode information (number of nodes = number of elements+1)
-  std::vector<Id> id_;
-  id_.assign(INTEGER(VECTOR_ELT(Rmesh, 14)), INTEGER(VECTOR_ELT(Rmesh, 14))+tree_loc_+1);
-  std::vector<int> node_left_child_;
-  node_left_child_.assign(INTEGER(VECTOR_ELT(Rmesh, 15)), INTEGER(VECTOR_ELT(Rmesh, 15))+tree_loc_+1);
-  std::vector<int> node_right_child_;
-  node_right_child_.assign(INTEGER(VECTOR_ELT(Rmesh, 16)), INTEGER(VECTOR_ELT(Rmesh, 16))+tree_loc_+1);
-  Real* box_ = REAL(VECTOR_ELT(Rmesh, 17));
-
-  UInt num_tree_nodes = id_.size();
+template<class Shape>
+void ADTree<Shape>::setTree(int tree_lev, const std::vector<Real>& origin, const std::vector<Real>& scalingfactors, UInt num_tree_nodes,
+                            const Id* id, const int* left_child, const int* right_child, const Real* box_){
+  int tree_loc_ = num_tree_nodes-1;
+  int ndimp_ = Shape::dp();
+  int ndimt_ = 2*ndimp_;
+  int nele_ = tree_loc_;
+  int iava_ = tree_loc_+1;
+  int iend_ = tree_loc_+1;
+
+  Domain<Shape> tree_domain(origin, scalingfactors);
+  header_ = TreeHeader<Shape>(tree_loc_, tree_lev, ndimp_, ndimt_, nele_, iava_, iend_, tree_domain);
+
   data_.reserve(num_tree_nodes);
 
   std::vector<Real> coord;
@@ -110,7 +111,7 @@ void ADTree<Shape>::setTree(SEXP Rmesh){
       coord.push_back(box_[i + num_tree_nodes*j]);
     }
     Box<Shape::dp()> box(coord);
-    TreeNode<Shape> tree_node(box, id_[i], node_left_child_[i], node_right_child_[i]);
+    TreeNode<Shape> tree_node(box, id[i], left_child[i], right_child[i]);
     data_.push_back(tree_node);
     coord.clear();
   }
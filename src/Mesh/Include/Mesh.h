@@ -6,6 +6,7 @@
 
 #include "../../FdaPDE.h"
 #include "../../Global_Utilities/Include/Make_Unique.h"
+#include "../../Global_Utilities/Include/Instrumentation.h"
 // Note: how_many_nodes constexpr function is defined in mesh_objects.h
 // Also Point and Element
 #include "Mesh_Objects.h"
@@ -30,6 +31,15 @@ public:
 
   MeshHandler(SEXP Rmesh, UInt search=1);
 
+  //! A constructor.
+    /*!
+      * This constructor permits the initialization of the mesh from raw column-major arrays
+      * (e.g. mapped from a binary archive), which are used in place and must outlive the mesh.
+      * If search==2 and no tree is given, the tree is built from nodes and elements.
+    */
+  MeshHandler(Real* const points, UInt num_nodes, UInt* const sides, UInt num_sides, UInt* const elements, UInt num_elements,
+              UInt* const neighbors, UInt search, std::unique_ptr<const ADTree<meshElement> > tree=nullptr);
+
   MeshHandler(const MeshHandler&) = delete;
   MeshHandler(MeshHandler&&) = delete;
   MeshHandler& operator=(const MeshHandler&) = delete;
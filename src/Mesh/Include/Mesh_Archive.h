@@ -0,0 +1,180 @@
+#ifndef __MESH_ARCHIVE_H__
+#define __MESH_ARCHIVE_H__
+
+#include "../../FdaPDE.h"
+#include "../../Global_Utilities/Include/Binary_Archive.h"
+#include "../../Global_Utilities/Include/Make_Unique.h"
+#include "Mesh.h"
+#include <memory>
+#include <vector>
+
+//! Function that adds the mesh, and its tree if present, to a binary archive
+/*!
+  \tparam ORDER the order of the mesh
+  \tparam mydim specifies if the mesh lie in R^2 or R^3
+  \tparam ndim specifies if the local dimension is 2 or 3
+  \param mesh the mesh to be stored
+  \param writer the archive to be filled
+  \return false if the mesh type cannot be archived (linear networks, whose neighbors are stored as lists)
+*/
+template<UInt ORDER, UInt mydim, UInt ndim>
+typename std::enable_if<(mydim>1), bool>::type
+archive_mesh(const MeshHandler<ORDER, mydim, ndim> & mesh, BinaryArchiveWriter & writer)
+{
+  constexpr UInt NNODES = how_many_nodes(ORDER,mydim);
+  const UInt num_nodes = mesh.num_nodes();
+  const UInt num_elements = mesh.num_elements();
+  const UInt num_sides = mesh.num_edges();
+
+  const UInt info[4] = {ORDER, mydim, ndim, mesh.getSearch()};
+  writer.addSection(BinaryArchive::MeshInfo, info, 4, 1);
+
+  std::vector<Real> points(num_nodes*ndim);
+  for(UInt j=0; j<ndim; ++j)
+    for(UInt i=0; i<num_nodes; ++i)
+      points[i+num_nodes*j] = mesh.nodes(i,j);
+  writer.addSection(BinaryArchive::MeshNodes, points.data(), num_nodes, ndim);
+
+  std::vector<UInt> sides(num_sides*mydim);
+  for(UInt j=0; j<mydim; ++j)
+    for(UInt i=0; i<num_sides; ++i)
+      sides[i+num_sides*j] = mesh.edges(i,j);
+  writer.addSection(BinaryArchive::MeshSides, sides.data(), num_sides, mydim);
+
+  std::vector<UInt> elements(num_elements*NNODES);
+  for(UInt j=0; j<NNODES; ++j)
+    for(UInt i=0; i<num_elements; ++i)
+      elements[i+num_elements*j] = mesh.elements(i,j);
+  writer.addSection(BinaryArchive::MeshElements, elements.data(), num_elements, NNODES);
+
+  std::vector<UInt> neighbors(num_elements*(mydim+1));
+  for(UInt j=0; j<mydim+1; ++j)
+    for(UInt i=0; i<num_elements; ++i)
+      neighbors[i+num_elements*j] = mesh.neighbors(i,j);
+  writer.addSection(BinaryArchive::MeshNeighbors, neighbors.data(), num_elements, mydim+1);
+
+  if(mesh.hasTree())
+    {
+      // Same flattened representation returned to R by tree_mesh_construction
+      const auto & tree = mesh.getTree();
+      const UInt num_tree_nodes = num_elements+1; // The head is stored as the first node
+      const UInt tree_lev = tree.gettreeheader().gettreelev();
+      writer.addSection(BinaryArchive::TreeInfo, &tree_lev, 1, 1);
+
+      std::vector<Real> domain(4*ndim);
+      for(UInt i=0; i<2*ndim; ++i)
+	{
+	  domain[i] = tree.gettreeheader().domainorig(i);
+	  domain[i+2*ndim] = tree.gettreeheader().domainscal(i);
+	}
+      writer.addSection(BinaryArchive::TreeDomain, domain.data(), 2*ndim, 2);
+
+      std::vector<UInt> ids(num_tree_nodes);
+      std::vector<UInt> children(2*num_tree_nodes);
+      std::vector<Real> boxes(2*ndim*num_tree_nodes);
+      for(UInt i=0; i<num_tree_nodes; ++i)
+	{
+	  auto tree_node = tree.gettreenode(i);
+	  ids[i] = tree_node.getid();
+	  children[i] = tree_node.getchild(0);
+	  children[i+num_tree_nodes] = tree_node.getchild(1);
+	  const std::vector<Real> box = tree_node.getbox().get();
+	  for(UInt j=0; j<2*ndim; ++j)
+	    boxes[i+num_tree_nodes*j] = box[j];
+	}
+      writer.addSection(BinaryArchive::TreeIds, ids.data(), num_tree_nodes, 1);
+      writer.addSection(BinaryArchive::TreeChildren, children.data(), num_tree_nodes, 2);
+      writer.addSection(BinaryArchive::TreeBoxes, boxes.data(), num_tree_nodes, 2*ndim);
+    }
+
+  return true;
+}
+
+template<UInt ORDER, UInt mydim, UInt ndim>
+typename std::enable_if<(mydim==1), bool>::type
+archive_mesh(const MeshHandler<ORDER, mydim, ndim> &, BinaryArchiveWriter &)
+{
+  return false;
+}
+
+//! Function that checks that the entries of an integer section lie in [lower, upper)
+inline bool archive_indices_in_range(const UInt * indices, UInt size, UInt lower, UInt upper)
+{
+  for(UInt i=0; i<size; ++i)
+    {
+      if(indices[i] < lower || indices[i] >= upper)
+	return false;
+    }
+  return true;
+}
+
+//! Function that builds a mesh from a binary archive, the arrays are used in place
+/*!
+  \tparam ORDER the order of the mesh
+  \tparam mydim specifies if the mesh lie in R^2 or R^3
+  \tparam ndim specifies if the local dimension is 2 or 3
+  \param reader the archive, it must outlive the returned mesh
+  \return the mesh, nullptr if the archive does not contain a mesh of the required type.
+  An R error is raised if the sections of the mesh are inconsistent with each other, since the mesh would be read out of bounds.
+*/
+template<UInt ORDER, UInt mydim, UInt ndim>
+std::unique_ptr<MeshHandler<ORDER, mydim, ndim>> load_mesh(const BinaryArchiveReader & reader)
+{
+  using meshElement = typename MeshHandler<ORDER, mydim, ndim>::meshElement;
+  constexpr UInt NNODES = how_many_nodes(ORDER,mydim);
+  UInt nrows = 0, ncols = 0;
+
+  const UInt * info = reader.getInteger(BinaryArchive::MeshInfo, nrows, ncols);
+  if(info == nullptr || nrows < 4 || info[0] != ORDER || info[1] != mydim || info[2] != ndim)
+    return nullptr;
+  const UInt search = info[3];
+
+  UInt num_nodes = 0, num_sides = 0, num_elements = 0;
+  UInt nodes_cols = 0, sides_cols = 0, elements_cols = 0, neighbors_rows = 0, neighbors_cols = 0;
+  Real * points = reader.getReal(BinaryArchive::MeshNodes, num_nodes, nodes_cols);
+  UInt * sides = reader.getInteger(BinaryArchive::MeshSides, num_sides, sides_cols);
+  UInt * elements = reader.getInteger(BinaryArchive::MeshElements, num_elements, elements_cols);
+  UInt * neighbors = reader.getInteger(BinaryArchive::MeshNeighbors, neighbors_rows, neighbors_cols);
+  if(points == nullptr || sides == nullptr || elements == nullptr || neighbors == nullptr)
+    return nullptr;
+
+  if(nodes_cols != ndim || sides_cols != mydim || elements_cols != NNODES)
+    Rf_error("the nodes, sides and elements of the archived mesh do not match its dimensions");
+  if(neighbors_rows != num_elements || neighbors_cols != mydim+1)
+    Rf_error("the neighbors of the archived mesh do not match its elements");
+  if(!archive_indices_in_range(elements, num_elements*NNODES, 0, num_nodes) || !archive_indices_in_range(sides, num_sides*mydim, 0, num_nodes))
+    Rf_error("the elements of the archived mesh refer to missing nodes");
+  if(!archive_indices_in_range(neighbors, num_elements*(mydim+1), -1, num_elements))
+    Rf_error("the neighbors of the archived mesh refer to missing elements");
+
+  std::unique_ptr<const ADTree<meshElement>> tree;
+  if(search == 2 && reader.hasSection(BinaryArchive::TreeInfo))
+    {
+      UInt num_tree_nodes = 0, info_rows = 0, domain_rows = 0, domain_cols = 0;
+      UInt children_rows = 0, children_cols = 0, boxes_rows = 0, boxes_cols = 0;
+      const UInt * tree_lev = reader.getInteger(BinaryArchive::TreeInfo, info_rows, ncols);
+      const Real * domain = reader.getReal(BinaryArchive::TreeDomain, domain_rows, domain_cols);
+      const UInt * ids = reader.getInteger(BinaryArchive::TreeIds, num_tree_nodes, ncols);
+      const UInt * children = reader.getInteger(BinaryArchive::TreeChildren, children_rows, children_cols);
+      const Real * boxes = reader.getReal(BinaryArchive::TreeBoxes, boxes_rows, boxes_cols);
+      if(tree_lev != nullptr && domain != nullptr && ids != nullptr && children != nullptr && boxes != nullptr)
+	{
+	  // The head is stored as the first node, the ids of the others are elements
+	  if(info_rows < 1 || domain_rows*domain_cols != 4*ndim || num_tree_nodes != num_elements+1 ||
+	     children_rows != num_tree_nodes || children_cols != 2 || boxes_rows != num_tree_nodes || boxes_cols != 2*ndim)
+	    Rf_error("the sections of the archived tree do not match the mesh");
+	  if(!archive_indices_in_range(ids+1, num_elements, 0, num_elements) ||
+	     !archive_indices_in_range(children, 2*num_tree_nodes, 0, num_tree_nodes))
+	    Rf_error("the archived tree refers to missing elements or nodes");
+
+	  const std::vector<Real> origin(domain, domain+2*ndim);
+	  const std::vector<Real> scalingfactors(domain+2*ndim, domain+4*ndim);
+	  tree = fdaPDE::make_unique<const ADTree<meshElement>>(tree_lev[0], origin, scalingfactors, num_tree_nodes,
+								 ids, children, children+num_tree_nodes, boxes);
+	}
+    }
+
+  return fdaPDE::make_unique<MeshHandler<ORDER, mydim, ndim>>(points, num_nodes, sides, num_sides, elements, num_elements, neighbors, search, std::move(tree));
+}
+
+#endif
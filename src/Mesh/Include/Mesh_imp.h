@@ -7,7 +7,23 @@ MeshHandler<ORDER,mydim,ndim>::MeshHandler(SEXP Rmesh, UInt search) :
 		elements_(VECTOR_ELT(Rmesh, 3)), neighbors_(VECTOR_ELT(Rmesh, 8)),
 		 	search_(search) {
 		 		if(search==2)
+		 		{
+		 			ScopedPhase phase("tree_build");
 		 			tree_ptr_= fdaPDE::make_unique<const ADTree<meshElement> > (Rmesh);
+		 		}
+				}
+
+template <UInt ORDER, UInt mydim, UInt ndim>
+MeshHandler<ORDER,mydim,ndim>::MeshHandler(Real* const points, UInt num_nodes, UInt* const sides, UInt num_sides, UInt* const elements, UInt num_elements,
+	UInt* const neighbors, UInt search, std::unique_ptr<const ADTree<meshElement> > tree) :
+	points_(points, num_nodes, ndim), sides_(sides, num_sides, mydim),
+		elements_(elements, num_elements, how_many_nodes(ORDER,mydim)), neighbors_(neighbors, num_elements, mydim+1),
+			search_(search), tree_ptr_(std::move(tree)) {
+				if(search==2 && !tree_ptr_)
+				{
+					ScopedPhase phase("tree_build");
+					tree_ptr_= fdaPDE::make_unique<const ADTree<meshElement> > (points_, elements_);
+				}
 				}
 
 template <UInt ORDER, UInt mydim, UInt ndim>
@@ -154,7 +170,10 @@ MeshHandler<ORDER,1,2>::MeshHandler(SEXP Rmesh, UInt search) :
         search_(search) {
 
     if(search==2)
+    {
+        ScopedPhase phase("tree_build");
         tree_ptr_= fdaPDE::make_unique<const ADTree<meshElement> > (Rmesh);
+    }
 
 }
 
@@ -11,6 +11,8 @@
 #include "../../FE_Assemblers_Solvers/Include/Param_Functors.h"
 #include "../../FE_Assemblers_Solvers/Include/Solver.h"
 #include "../../Mesh/Include/Mesh.h"
+#include "../../Global_Utilities/Include/Instrumentation.h"
+#include "../../Global_Utilities/Include/Print_Buffer.h"
 #include "../../Lambda_Optimization/Include/Optimization_Data.h"
 #include "Regression_Data.h"
 
@@ -200,6 +202,8 @@ class MixedFERegressionBase
 		void computeDegreesOfFreedom(UInt output_indexS, UInt output_indexT, Real lambdaS, Real lambdaT);
 		//! A method that set WTW flag to false, in order to recompute the matrix WTW.
 		void recomputeWTW(void){ this->isWTWfactorized_ = false;}
+		//! A method that sets already assembled R0 and R1 matrices, so that preapply skips their assembly (used when several datasets share the same mesh)
+		void setFEMatrices(const SpMat & R0, const SpMat & R1) {R0_ = R0; R1_ = R1; isR0Computed = true; isR1Computed = true;}
 		//! A method used to reset the system matrix to the value obtained for a given lambda (used for inference)
 		void build_regression_inference(Real lambda_inference_) {this->buildSystemMatrix(lambda_inference_); this->system_factorize();}; // If the last lambda used is not  the optimal one and inference is required, coherent system matrices are needed
 		void build_regression_inference(Real lambda_S_Inference_, Real lambda_T_Inference_) {this->buildSystemMatrix(lambda_S_Inference_,lambda_T_Inference_); this->system_factorize();}; // If the last lambda used is not  the optimal one and inference is required, coherent system matrices are needed
@@ -300,12 +304,12 @@ class MixedFERegression : public MixedFERegressionBase<InputHandler>
 
 		void apply(void)
 		{
-			Rprintf("Option not implemented!\n");
+			fdaPDE::Rprintf_buffered("Option not implemented!\n");
 		}
 
          void apply_iterative(void)
         {
-            Rprintf("Option not implemented!\n");
+            fdaPDE::Rprintf_buffered("Option not implemented!\n");
          }
 };
 
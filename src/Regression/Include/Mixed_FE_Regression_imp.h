@@ -611,8 +611,20 @@ void MixedFERegressionBase<InputHandler>::system_factorize()
     UInt nnodes = N_*M_;	// Note that is only space M_=1
 	const VectorXr * P = regressionData_.getWeightsMatrix(); // Matrix of weights for GAM
 
-	// First phase: Factorization of matrixNoCov
-	matrixNoCovdec_.compute(matrixNoCov_);
+	// First phase: Factorization of matrixNoCov, split in its symbolic and numeric steps to measure them
+	{
+		ScopedPhase phase("factorization_symbolic");
+		matrixNoCovdec_.analyzePattern(matrixNoCov_);
+	}
+	{
+		ScopedPhase phase("factorization_numeric");
+		matrixNoCovdec_.factorize(matrixNoCov_);
+	}
+	Instrumentation & instrumentation = Instrumentation::get();
+	instrumentation.addCount("factorizations");
+	instrumentation.setCount("system_nnz", matrixNoCov_.nonZeros());
+	if(isMatrixNoCov_factorized())
+		instrumentation.setCount("factor_nnz", matrixNoCovdec_.nnzL() + matrixNoCovdec_.nnzU());
 
     bool needUpdate = isGAMData ? true : !isUVComputed;
 
@@ -689,6 +701,7 @@ MatrixXr MixedFERegressionBase<InputHandler>::solve_covariates_iter(const Eigen:
         G = -W.transpose()*W + D;
         Gdec_.compute(G);
 
+        Instrumentation::get().addCount("solves");
         MatrixXr x1 = matrixNoCovdec_.solve(b);
 
         // Resolution of G * x2 = V * x1
@@ -705,6 +718,7 @@ template<typename Derived>
 MatrixXr MixedFERegressionBase<InputHandler>::system_solve(const Eigen::MatrixBase<Derived> & b)
 {
 	if(isMatrixNoCov_factorized()) {
+	 Instrumentation::get().addCount("solves");
 	 // Resolution of the system matrixNoCov * x1 = b
 	 MatrixXr x1 = matrixNoCovdec_.solve(b);
 	 if(regressionData_.getCovariates()->rows() != 0 && !this->isIterative)
@@ -729,18 +743,19 @@ MatrixXr MixedFERegressionBase<InputHandler>::system_solve(const Eigen::MatrixBa
 template<typename InputHandler>
 void MixedFERegressionBase<InputHandler>::computeDegreesOfFreedom(UInt output_indexS, UInt output_indexT, Real lambdaS, Real lambdaT)
 {
+	ScopedPhase phase("dof");
 	std::string GCVmethod = optimizationData_.get_DOF_evaluation();
 	int flag = GCVmethod == "exact";
 	switch (flag) {
 		case 1:
 			if(this->isIterative & !isGAMData)
-				Rprintf("Function computeDOFExact_iterative moved to Lambda_optimizer\n");
+				fdaPDE::Rprintf_buffered("Function computeDOFExact_iterative moved to Lambda_optimizer\n");
 			else
 				computeDegreesOfFreedomExact(output_indexS, output_indexT, lambdaS, lambdaT);
 			break;
 		case 0:
 			if(this->isIterative & !isGAMData)
-				Rprintf("Function computeDOFStochastic_iterative moved to Lambda_optimizer\n");
+				fdaPDE::Rprintf_buffered("Function computeDOFStochastic_iterative moved to Lambda_optimizer\n");
 			else
 				computeDegreesOfFreedomStochastic(output_indexS, output_indexT, lambdaS, lambdaT);
 			break;
@@ -958,6 +973,7 @@ void MixedFERegressionBase<InputHandler>::preapply(EOExpr<A> oper, const Forcing
 	}
 	// Set psi matrix if not already done
 	if(!isPsiComputed){
+		ScopedPhase phase("psi");
 		this-> setPsi<ORDER, mydim, ndim>(mesh_);
 		isPsiComputed = true;
 	}
@@ -972,18 +988,21 @@ void MixedFERegressionBase<InputHandler>::preapply(EOExpr<A> oper, const Forcing
 	typedef EOExpr<Mass> ETMass; Mass EMass; ETMass mass(EMass);
 	if(!isR1Computed)
 	{
+		ScopedPhase phase("assembly");
 		Assembler::operKernel(oper, mesh_, fe, R1_);
 		isR1Computed = true;
 	}
 
 	if(!isR0Computed)
 	{
+		ScopedPhase phase("assembly");
 		Assembler::operKernel(mass, mesh_, fe, R0_);
 		isR0Computed = true;
 	}
 
 	if(this->isSpaceVarying && !isFTComputed)
 	{
+		ScopedPhase phase("assembly");
 		Assembler::forcingTerm(mesh_, fe, u, rhs_ft_correction_);
 		isFTComputed = true;
 	}
@@ -1378,7 +1397,7 @@ MatrixXv  MixedFERegressionBase<InputHandler>::apply_iterative(void) {
                 i++;
             }
 
-            Rprintf("Solution found after %d iterations (max number of iterations: %d)\n", i, (regressionData_.get_maxiter()+1));
+            fdaPDE::Rprintf_buffered("Solution found after %d iterations (max number of iterations: %d)\n", i, (regressionData_.get_maxiter()+1));
 
             if(optimizationData_.get_loss_function()!="GCV" || isGAMData)
             {
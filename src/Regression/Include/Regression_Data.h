@@ -102,6 +102,10 @@ class  RegressionData
 		explicit RegressionData(Real* locations, UInt n_locations, UInt ndim, VectorXr & observations, UInt order, MatrixXr & covariates,
 			 VectorXr & WeightsMatrix, std::vector<UInt> & bc_indices, std::vector<Real> & bc_values,  MatrixXi & incidenceMatrix, bool arealDataAvg, UInt search);
 
+		// -- SETTERS --
+		//! A method that replaces the observations, keeping locations, covariates and all the other data (used by persistent sessions)
+		void updateObservations(SEXP Robservations);
+
 		// -- PRINTERS --
 		void printObservations(std::ostream & out) const;
 		void printCovariates(std::ostream & out) const;
@@ -141,6 +141,12 @@ void RegressionData::setObservations(SEXP Robservations)
 	//for(auto i=0;i<observations_indices_.size();++i)	std::cout<<observations_indices_[i]<<std::endl;
 }
 
+void RegressionData::updateObservations(SEXP Robservations)
+{
+	observations_indices_.clear();
+	setObservations(Robservations);
+}
+
 void RegressionData::setObservationsTime(SEXP Robservations)
 {
 	UInt n_obs_ = Rf_length(Robservations);
@@ -1,5 +1,6 @@
 #include "../../FdaPDE.h"
 #include "../../Skeletons/Include/Regression_Skeleton.h"
+#include "../../Skeletons/Include/Regression_Skeleton_Batch.h"
 #include "../../Skeletons/Include/Regression_Skeleton_Time.h"
 #include "../../Skeletons/Include/GAM_Skeleton.h"
 #include "../../Skeletons/Include/GAM_Skeleton_time.h"
@@ -56,6 +57,8 @@ extern "C"
     \param RinferenceQuantile an R-vector defining the quantiles needed for the confidence intervals for the betas parameters of the model
     \param RinferenceAlpha an R-vector defining the significance used to compute the sign-flip confidence intervals
     \param RinferenceFlip an R-integer defining the number of sign-flips needed in eigen-sign-flip inference
+    \param RinferenceSeed an R-integer defining the seed of the sign-flips, 0 meaning a random seed
+    \param RinferenceMCError an R-double defining the error probability of the early stopping of the sign-flip tests, 0 meaning that all the sign-flips are performed
     \param RinferenceTolFspai an R-double defining the tolerance of the FSPAI algorithm needed if non-exact implementation of inference is required
     \param RinferenceDefined R-integer taking value 0 or 1; if equal to 0, inference analysis will not be carried out
     \return R-vectors containg the coefficients of the solution, prediction of the values, optimization data and much more
@@ -65,13 +68,13 @@ extern "C"
 			  SEXP Roptim, SEXP Rlambda, SEXP Rnrealizations, SEXP Rseed, SEXP RDOF_matrix, SEXP Rtune, SEXP Rsct,
 			  SEXP RtestType, SEXP RintervalType, SEXP RimplementationType, SEXP RcomponentType, SEXP RexactInference,
 			  SEXP RlocsInference, SEXP RlocsindexInference, SEXP Rlocsarenodes, SEXP RcoeffInference, SEXP Rbeta0, SEXP Rf0eval, SEXP RfvarInference,
-			  SEXP RinferenceQuantile, SEXP RinferenceAlpha, SEXP RinferenceFlip, SEXP RinferenceTolFspai, SEXP RinferenceDefined)
+			  SEXP RinferenceQuantile, SEXP RinferenceAlpha, SEXP RinferenceFlip, SEXP RinferenceSeed, SEXP RinferenceMCError, SEXP RinferenceTolFspai, SEXP RinferenceDefined)
   {
     //Set input data
     RegressionData regressionData(Rlocations, RbaryLocations, Robservations, Rorder, Rcovariates, RBCIndices, RBCValues, RincidenceMatrix, RarealDataAvg, Rsearch);
     OptimizationData optimizationData(Roptim, Rlambda, Rnrealizations, Rseed, RDOF_matrix, Rtune, Rsct);
     InferenceData inferenceData(RtestType, RintervalType, RimplementationType, RcomponentType, RexactInference, RlocsInference, RlocsindexInference, Rlocsarenodes, RcoeffInference, Rbeta0, Rf0eval,
-    RfvarInference, RinferenceQuantile, RinferenceAlpha, RinferenceFlip, RinferenceTolFspai, RinferenceDefined);
+    RfvarInference, RinferenceQuantile, RinferenceAlpha, RinferenceFlip, RinferenceSeed, RinferenceMCError, RinferenceTolFspai, RinferenceDefined);
 
     UInt mydim = INTEGER(Rmydim)[0];
     UInt ndim = INTEGER(Rndim)[0];
@@ -95,6 +98,71 @@ extern "C"
     return(NILSXP);
   }
   
+  //! This function manages the batch version of Spatial Regression, where several datasets share the same mesh
+  /*!
+    This function is then called from R code.
+    \param Rlocations an R-list of R-matrices containing the spatial locations of the observations of each dataset
+    \param RbaryLocations an R-list of barycenter information (as in regression_Laplace) for each dataset, elements may be NULL
+    \param Robservations an R-list of R-vectors containing the values of the observations of each dataset
+    \param Rmesh an R-object containg the output mesh from Trilibrary, shared by all the datasets
+    \param Rorder an R-integer containing the order of the approximating basis.
+    \param Rmydim an R-integer specifying if the mesh nodes lie in R^2 or R^3
+    \param Rndim  an R-integer specifying if the "local dimension" is 2 or 3
+    \param Rcovariates an R-list of R-matrices of covariates for the regression model of each dataset
+    \param RBCIndices an R-integer containing the indexes of the nodes the user want to apply a Dirichlet Condition,
+    the other are automatically considered in Neumann Condition.
+    \param RBCValues an R-double containing the value to impose for the Dirichlet condition, on the indexes specified in RBCIndices
+    \param RincidenceMatrix an R-matrix containing the incidence matrix defining the regions for the smooth regression with areal data
+    \param RarealDataAvg an R boolean indicating whether the areal data are averaged or not.
+    \param Rsearch an R-integer to decide the search algorithm type (tree or naive search algorithm).
+    \param Roptim optimzation type, DOF evaluation and loss function used coded as integer vector
+    \param Rlambda a vector containing the penalization term of the empirical evidence respect to the prior one. or initial codition for optimized methods
+    \param Rnrealizations integer, the number of random points used in the stochastic computation of the dofs
+    \param Rseed integer, user defined seed for stochastic DOF computation methods
+    \param RDOF_matrix user provided DOF matrix for GCV computation
+    \param Rtune a R-double, Tuning parameter used for the estimation of GCV. called 'GCV.inflation.factor' in R code.
+    \param Rsct user defined stopping criterion tolerance for optimized methods (newton or newton with finite differences)
+    \return an R-list with one element per dataset, each one containing the same output of regression_Laplace
+  */
+  SEXP regression_Laplace_batch(SEXP Rlocations, SEXP RbaryLocations, SEXP Robservations, SEXP Rmesh, SEXP Rorder, SEXP Rmydim, SEXP Rndim,
+				SEXP Rcovariates, SEXP RBCIndices, SEXP RBCValues, SEXP RincidenceMatrix, SEXP RarealDataAvg, SEXP Rsearch,
+				SEXP Roptim, SEXP Rlambda, SEXP Rnrealizations, SEXP Rseed, SEXP RDOF_matrix, SEXP Rtune, SEXP Rsct)
+  {
+    //Set input data
+    UInt n_datasets = Rf_length(Robservations);
+    std::vector<std::unique_ptr<RegressionData>> regressionData;
+    regressionData.reserve(n_datasets);
+    for(UInt i=0; i<n_datasets; ++i)
+      regressionData.push_back(fdaPDE::make_unique<RegressionData>(VECTOR_ELT(Rlocations, i), VECTOR_ELT(RbaryLocations, i), VECTOR_ELT(Robservations, i), Rorder,
+								VECTOR_ELT(Rcovariates, i), RBCIndices, RBCValues, RincidenceMatrix, RarealDataAvg, Rsearch));
+    OptimizationData optimizationData(Roptim, Rlambda, Rnrealizations, Rseed, RDOF_matrix, Rtune, Rsct);
+
+    if(n_datasets==0)
+      return(NILSXP);
+
+    UInt order = regressionData[0]->getOrder();
+    UInt mydim = INTEGER(Rmydim)[0];
+    UInt ndim = INTEGER(Rndim)[0];
+    if(order==1 && mydim==2 && ndim==2)
+      return(regression_skeleton_batch<RegressionData, 1, 2, 2>(regressionData, optimizationData, Rmesh));
+    else if(order==2 && mydim==2 && ndim==2)
+      return(regression_skeleton_batch<RegressionData, 2, 2, 2>(regressionData, optimizationData, Rmesh));
+    else if(order==1 && mydim==2 && ndim==3)
+      return(regression_skeleton_batch<RegressionData, 1, 2, 3>(regressionData, optimizationData, Rmesh));
+    else if(order==2 && mydim==2 && ndim==3)
+      return(regression_skeleton_batch<RegressionData, 2, 2, 3>(regressionData, optimizationData, Rmesh));
+    else if(order==1 && mydim==3 && ndim==3)
+      return(regression_skeleton_batch<RegressionData, 1, 3, 3>(regressionData, optimizationData, Rmesh));
+    else if(order==2 && mydim==3 && ndim==3)
+      return(regression_skeleton_batch<RegressionData, 2, 3, 3>(regressionData, optimizationData, Rmesh));
+    else if(order==1 && mydim==1 && ndim==2)
+      return(regression_skeleton_batch<RegressionData, 1, 1, 2>(regressionData, optimizationData, Rmesh));
+    else if(order==2 && mydim==1 && ndim==2)
+      return(regression_skeleton_batch<RegressionData, 2, 1, 2>(regressionData, optimizationData, Rmesh));
+
+    return(NILSXP);
+  }
+
   //! This function manages the various options for Spatio-Temporal Regression
   /*!
     This function is then called from R code.
@@ -147,6 +215,8 @@ extern "C"
     \param RinferenceQuantile an R-vector defining the quantiles needed for the confidence intervals for the betas parameters of the model
     \param RinferenceAlpha an R-double defining the significance used to compute the sign-flip confidence intervals
     \param RinferenceFlip an R-integer defining the number of sign-flips needed in eigen-sign-flip inference
+    \param RinferenceSeed an R-integer defining the seed of the sign-flips, 0 meaning a random seed
+    \param RinferenceMCError an R-double defining the error probability of the early stopping of the sign-flip tests, 0 meaning that all the sign-flips are performed
     \param RinferenceTolFspai an R-double defining the tolerance of the FSPAI algorithm needed if non-exact implementation of inference is required
     \param RinferenceDefined R-integer taking value 0 or 1; if equal to 0, inference analysis will not be carried out
     \return R-vectors containg the coefficients of the solution, prediction of the values, optimization data and much more
@@ -157,13 +227,13 @@ extern "C"
 			       SEXP Roptim, SEXP Rlambda_S, SEXP Rlambda_T, SEXP Rnrealizations, SEXP Rseed, SEXP RDOF_matrix, SEXP Rtune, SEXP Rsct,
 			       SEXP RtestType, SEXP RintervalType, SEXP RimplementationType,SEXP RcomponentType, SEXP RexactInference, SEXP RlocsInference, SEXP RlocsindexInference,
 			       SEXP Rlocsarenodes, SEXP RtimeLocsInf ,SEXP RcoeffInference, SEXP Rbeta0, SEXP Rf0eval, SEXP RfvarInference,
-			       SEXP RinferenceQuantile, SEXP RinferenceAlpha, SEXP RinferenceFlip, SEXP RinferenceTolFspai, SEXP RinferenceDefined)
+			       SEXP RinferenceQuantile, SEXP RinferenceAlpha, SEXP RinferenceFlip, SEXP RinferenceSeed, SEXP RinferenceMCError, SEXP RinferenceTolFspai, SEXP RinferenceDefined)
   {
     //Set input data
     RegressionData regressionData(Rlocations, RbaryLocations, Rtime_locations, Robservations, Rorder, Rcovariates, RBCIndices, RBCValues,
 				  RincidenceMatrix, RarealDataAvg, Rflag_mass, Rflag_parabolic, Rflag_iterative, Rmax_num_iteration, Rtreshold, Ric, Rsearch);
     OptimizationData optimizationData(Roptim, Rlambda_S, Rlambda_T, Rflag_parabolic, Rnrealizations, Rseed, RDOF_matrix, Rtune, Rsct);
-    InferenceData inferenceData(RtestType, RintervalType, RimplementationType, RcomponentType, RexactInference, RlocsInference, RlocsindexInference, Rlocsarenodes, RtimeLocsInf, RcoeffInference, Rbeta0, Rf0eval, RfvarInference, RinferenceQuantile, RinferenceAlpha, RinferenceFlip, RinferenceTolFspai, RinferenceDefined);
+    InferenceData inferenceData(RtestType, RintervalType, RimplementationType, RcomponentType, RexactInference, RlocsInference, RlocsindexInference, Rlocsarenodes, RtimeLocsInf, RcoeffInference, Rbeta0, Rf0eval, RfvarInference, RinferenceQuantile, RinferenceAlpha, RinferenceFlip, RinferenceSeed, RinferenceMCError, RinferenceTolFspai, RinferenceDefined);
 
     UInt mydim = INTEGER(Rmydim)[0];
     UInt ndim = INTEGER(Rndim)[0];
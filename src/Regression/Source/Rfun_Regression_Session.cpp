@@ -0,0 +1,249 @@
+#include "../../FdaPDE.h"
+#include "../../Skeletons/Include/Regression_Session.h"
+#include "../Include/Regression_Data.h"
+#include "../../Lambda_Optimization/Include/Optimization_Data.h"
+#include "../../Inference/Include/Inference_Data.h"
+
+namespace
+{
+  //! Finalizer of the external pointer, called by the R garbage collector (or at exit)
+  void regression_session_finalizer(SEXP Rsession)
+  {
+    RegressionSessionBase * session = static_cast<RegressionSessionBase *>(R_ExternalPtrAddr(Rsession));
+    if(session != nullptr)
+      {
+	delete session;
+	R_ClearExternalPtr(Rsession);
+      }
+  }
+
+  //! Utility that extracts the session from the external pointer, nullptr if the pointer is not valid
+  RegressionSessionBase * get_regression_session(SEXP Rsession)
+  {
+    if(TYPEOF(Rsession) != EXTPTRSXP || R_ExternalPtrAddr(Rsession) == nullptr)
+      {
+	Rprintf("ERROR: invalid regression session, it may have been created in another R session\n");
+	return nullptr;
+      }
+    return static_cast<RegressionSessionBase *>(R_ExternalPtrAddr(Rsession));
+  }
+}
+
+extern "C"
+{
+  //! This function creates a persistent session for Spatial Regression
+  /*!
+    This function is then called from R code. The mesh, the FE matrices, Psi and the factorizations are built once and kept
+    alive inside the returned external pointer until it is garbage collected.
+    \param Rlocations an R-matrix containing the spatial locations of the observations
+    \param RbaryLocations A list with three vectors:
+    location points which are same as the given locations options (to checks whether both locations are the same),
+    a vector of element id of the points from the mesh where they are located,
+    a vector of barycenter of points from the located element.
+    \param Robservations an R-vector containing the values of the observations.
+    \param Rmesh an R-object containg the output mesh from Trilibrary
+    \param Rorder an R-integer containing the order of the approximating basis.
+    \param Rmydim an R-integer specifying if the mesh nodes lie in R^2 or R^3
+    \param Rndim  an R-integer specifying if the "local dimension" is 2 or 3
+    \param Rcovariates an R-matrix of covariates for the regression model
+    \param RBCIndices an R-integer containing the indexes of the nodes the user want to apply a Dirichlet Condition,
+    the other are automatically considered in Neumann Condition.
+    \param RBCValues an R-double containing the value to impose for the Dirichlet condition, on the indexes specified in RBCIndices
+    \param RincidenceMatrix an R-matrix containing the incidence matrix defining the regions for the smooth regression with areal data
+    \param RarealDataAvg an R boolean indicating whether the areal data are averaged or not.
+    \param Rsearch an R-integer to decide the search algorithm type (tree or naive search algorithm).
+    \param Roptim optimzation type, DOF evaluation and loss function used coded as integer vector
+    \param Rlambda a vector containing the penalization term of the empirical evidence respect to the prior one. or initial codition for optimized methods
+    \param Rnrealizations integer, the number of random points used in the stochastic computation of the dofs
+    \param Rseed integer, user defined seed for stochastic DOF computation methods
+    \param RDOF_matrix user provided DOF matrix for GCV computation
+    \param Rtune a R-double, Tuning parameter used for the estimation of GCV. called 'GCV.inflation.factor' in R code.
+    \param Rsct user defined stopping criterion tolerance for optimized methods (newton or newton with finite differences)
+    \return an R external pointer to the session
+  */
+  SEXP regression_Laplace_session_create(SEXP Rlocations, SEXP RbaryLocations, SEXP Robservations, SEXP Rmesh, SEXP Rorder, SEXP Rmydim, SEXP Rndim,
+					 SEXP Rcovariates, SEXP RBCIndices, SEXP RBCValues, SEXP RincidenceMatrix, SEXP RarealDataAvg, SEXP Rsearch,
+					 SEXP Roptim, SEXP Rlambda, SEXP Rnrealizations, SEXP Rseed, SEXP RDOF_matrix, SEXP Rtune, SEXP Rsct)
+  {
+    //Set input data
+    RegressionData regressionData(Rlocations, RbaryLocations, Robservations, Rorder, Rcovariates, RBCIndices, RBCValues, RincidenceMatrix, RarealDataAvg, Rsearch);
+    OptimizationData optimizationData(Roptim, Rlambda, Rnrealizations, Rseed, RDOF_matrix, Rtune, Rsct);
+
+    UInt mydim = INTEGER(Rmydim)[0];
+    UInt ndim = INTEGER(Rndim)[0];
+    RegressionSessionBase * session = nullptr;
+    if(regressionData.getOrder()==1 && mydim==2 && ndim==2)
+      session = new RegressionSession<1, 2, 2>(regressionData, optimizationData, Rmesh, Rf_length(Robservations));
+    else if(regressionData.getOrder()==2 && mydim==2 && ndim==2)
+      session = new RegressionSession<2, 2, 2>(regressionData, optimizationData, Rmesh, Rf_length(Robservations));
+    else if(regressionData.getOrder()==1 && mydim==2 && ndim==3)
+      session = new RegressionSession<1, 2, 3>(regressionData, optimizationData, Rmesh, Rf_length(Robservations));
+    else if(regressionData.getOrder()==2 && mydim==2 && ndim==3)
+      session = new RegressionSession<2, 2, 3>(regressionData, optimizationData, Rmesh, Rf_length(Robservations));
+    else if(regressionData.getOrder()==1 && mydim==3 && ndim==3)
+      session = new RegressionSession<1, 3, 3>(regressionData, optimizationData, Rmesh, Rf_length(Robservations));
+    else if(regressionData.getOrder()==2 && mydim==3 && ndim==3)
+      session = new RegressionSession<2, 3, 3>(regressionData, optimizationData, Rmesh, Rf_length(Robservations));
+    else if(regressionData.getOrder()==1 && mydim==1 && ndim==2)
+      session = new RegressionSession<1, 1, 2>(regressionData, optimizationData, Rmesh, Rf_length(Robservations));
+    else if(regressionData.getOrder()==2 && mydim==1 && ndim==2)
+      session = new RegressionSession<2, 1, 2>(regressionData, optimizationData, Rmesh, Rf_length(Robservations));
+
+    if(session == nullptr)
+      return(NILSXP);
+
+    // The mesh and the locations are read in place by the session, the external pointer keeps them alive
+    SEXP Rprotected = NILSXP;
+    Rprotected = PROTECT(Rf_allocVector(VECSXP, 3));
+    SET_VECTOR_ELT(Rprotected, 0, Rmesh);
+    SET_VECTOR_ELT(Rprotected, 1, Rlocations);
+    SET_VECTOR_ELT(Rprotected, 2, RbaryLocations);
+
+    SEXP Rsession = NILSXP;
+    Rsession = PROTECT(R_MakeExternalPtr(session, Rf_install("fdaPDE_regression_session"), Rprotected));
+    R_RegisterCFinalizerEx(Rsession, regression_session_finalizer, TRUE);
+
+    UNPROTECT(2);
+    return(Rsession);
+  }
+
+  //! This function solves the problem stored in a regression session
+  /*!
+    \param Rsession an R external pointer returned by regression_Laplace_session_create
+    \return R-vectors structured as the output of regression_Laplace
+  */
+  SEXP regression_session_fit(SEXP Rsession)
+  {
+    RegressionSessionBase * session = get_regression_session(Rsession);
+    if(session == nullptr)
+      return(NILSXP);
+
+    return(session->fit());
+  }
+
+  //! This function replaces the observations of a regression session, the solution must be recomputed with regression_session_fit
+  /*!
+    An R error is raised if the new observations do not match the ones of the session: a vector of a different length
+    would be read out of bounds by the following solves, and NA are admitted only for observations at the mesh nodes.
+    \param Rsession an R external pointer returned by regression_Laplace_session_create
+    \param Robservations an R-vector containing the new values of the observations, at the same locations
+    \return NULL
+  */
+  SEXP regression_session_update_observations(SEXP Rsession, SEXP Robservations)
+  {
+    RegressionSessionBase * session = get_regression_session(Rsession);
+    if(session == nullptr)
+      return(NILSXP);
+
+    if(TYPEOF(Robservations) != REALSXP)
+      Rf_error("the observations must be a numeric vector");
+    const UInt n_obs = Rf_length(Robservations);
+    if(n_obs != session->getObservationsLength())
+      Rf_error("%d observations given, the session has been created with %d observations", (int)n_obs, (int)session->getObservationsLength());
+
+    UInt n_missing = 0;
+    for(UInt i=0; i<n_obs; ++i)
+      {
+	if(ISNA(REAL(Robservations)[i]))
+	  ++n_missing;
+      }
+    if(n_missing > 0 && !session->areLocationsByNodes())
+      Rf_error("missing values are admitted only when the observations are associated with the mesh nodes");
+    if(n_missing == n_obs)
+      Rf_error("all the observations are missing");
+
+    session->updateObservations(Robservations);
+    return(NILSXP);
+  }
+
+  //! This function replaces the optimization data of a regression session, e.g. to refine the lambda search
+  /*!
+    \param Rsession an R external pointer returned by regression_Laplace_session_create
+    \param Roptim optimzation type, DOF evaluation and loss function used coded as integer vector
+    \param Rlambda a vector containing the penalization term of the empirical evidence respect to the prior one. or initial codition for optimized methods
+    \param Rnrealizations integer, the number of random points used in the stochastic computation of the dofs
+    \param Rseed integer, user defined seed for stochastic DOF computation methods
+    \param RDOF_matrix user provided DOF matrix for GCV computation
+    \param Rtune a R-double, Tuning parameter used for the estimation of GCV. called 'GCV.inflation.factor' in R code.
+    \param Rsct user defined stopping criterion tolerance for optimized methods (newton or newton with finite differences)
+    \return NULL
+  */
+  SEXP regression_session_update_lambda(SEXP Rsession, SEXP Roptim, SEXP Rlambda, SEXP Rnrealizations, SEXP Rseed, SEXP RDOF_matrix, SEXP Rtune, SEXP Rsct)
+  {
+    RegressionSessionBase * session = get_regression_session(Rsession);
+    if(session != nullptr)
+      session->updateOptimization(OptimizationData(Roptim, Rlambda, Rnrealizations, Rseed, RDOF_matrix, Rtune, Rsct));
+
+    return(NILSXP);
+  }
+
+  //! This function runs inference on the last solution of a regression session
+  /*!
+    \param Rsession an R external pointer returned by regression_Laplace_session_create
+    \param RtestType an R-vector defining if hypotesis testing is required, and which type (one at the time, simultaneous)
+    \param RintervalType an R-vector defining if confidence intervals are required, and which type (one at the time, simultaneous, bonferroni)
+    \param RimplementationType an R-vector defining the type of implementation required for inferential analysis (wald, speckman, sign-flip, eigen-sign-flip, enhanced-eigen-sign-flip)
+    \param RcomponentType an R-vector specifying on which component of the model the inferential analysis should be peformed (parametric, nonparametric, both)
+    \param RexactInference an R-integer that defines if an exact inferential analysis is required or not
+    \param RlocsInference an R-matrix of location points selected for inference on the nonparametric component
+    \param RlocsindexInference an R-vector of location indices selected for inference on the nonparametric component
+    \param Rlocsarenodes an R-integer specifying whether the selected locations are a subset of mesh nodes
+    \param RcoeffInference an R-matrix of coefficients that defines the linear combinations of the betas parameters of interest for inferential analysis
+    \param Rbeta0 an R-vector containing the null hypotesis values for the betas parameters, needed for the test
+    \param Rf0eval an R-vector containing the evaluation of the nonparametric component under the null hypothesis at the selected locations
+    \param RfvarInference an R-integer that defines if local f variance has to be estimated or not
+    \param RinferenceQuantile an R-vector defining the quantiles needed for the confidence intervals for the betas parameters of the model
+    \param RinferenceAlpha an R-vector defining the significance used to compute the sign-flip confidence intervals
+    \param RinferenceFlip an R-integer defining the number of sign-flips needed in eigen-sign-flip inference
+    \param RinferenceSeed an R-integer defining the seed of the sign-flips, 0 meaning a random seed
+    \param RinferenceMCError an R-double defining the error probability of the early stopping of the sign-flip tests, 0 meaning that all the sign-flips are performed
+    \param RinferenceTolFspai an R-double defining the tolerance of the FSPAI algorithm needed if non-exact implementation of inference is required
+    \param RinferenceDefined R-integer taking value 0 or 1; if equal to 0, inference analysis will not be carried out
+    \return R-vectors structured as the output of regression_Laplace
+  */
+  SEXP regression_session_inference(SEXP Rsession, SEXP RtestType, SEXP RintervalType, SEXP RimplementationType, SEXP RcomponentType, SEXP RexactInference,
+				    SEXP RlocsInference, SEXP RlocsindexInference, SEXP Rlocsarenodes, SEXP RcoeffInference, SEXP Rbeta0, SEXP Rf0eval, SEXP RfvarInference,
+				    SEXP RinferenceQuantile, SEXP RinferenceAlpha, SEXP RinferenceFlip, SEXP RinferenceSeed, SEXP RinferenceMCError, SEXP RinferenceTolFspai, SEXP RinferenceDefined)
+  {
+    RegressionSessionBase * session = get_regression_session(Rsession);
+    if(session == nullptr)
+      return(NILSXP);
+
+    InferenceData inferenceData(RtestType, RintervalType, RimplementationType, RcomponentType, RexactInference, RlocsInference, RlocsindexInference, Rlocsarenodes, RcoeffInference, Rbeta0, Rf0eval,
+    RfvarInference, RinferenceQuantile, RinferenceAlpha, RinferenceFlip, RinferenceSeed, RinferenceMCError, RinferenceTolFspai, RinferenceDefined);
+
+    return(session->inference(inferenceData));
+  }
+
+  //! This function evaluates the last solution of a regression session in a set of new locations
+  /*!
+    \param Rsession an R external pointer returned by regression_Laplace_session_create
+    \param Rlocations an R-matrix containing the coordinates of the points where the solution has to be evaluated
+    \param Rfast an R integer to enforce verbose search for Walking Algorithm (can miss location for non convex meshes)
+    \return an R-matrix with one column for each solution, NA for the points outside the domain
+  */
+  SEXP regression_session_eval(SEXP Rsession, SEXP Rlocations, SEXP Rfast)
+  {
+    RegressionSessionBase * session = get_regression_session(Rsession);
+    if(session == nullptr)
+      return(NILSXP);
+
+    return(session->eval(Rlocations, Rfast));
+  }
+
+  //! This function writes the mesh, its tree and the last solution of a regression session to a binary archive
+  /*!
+    \param Rsession an R external pointer returned by regression_Laplace_session_create
+    \param Rfilename an R string containing the path of the archive
+    \param Rsystem an R integer, if 1 the system matrix is stored too
+    \return an R logical, TRUE if the archive has been written
+  */
+  SEXP regression_session_save(SEXP Rsession, SEXP Rfilename, SEXP Rsystem)
+  {
+    RegressionSessionBase * session = get_regression_session(Rsession);
+    if(session == nullptr)
+      return(Rf_ScalarLogical(0));
+
+    return(Rf_ScalarLogical(session->save(CHAR(STRING_ELT(Rfilename, 0)), INTEGER(Rsystem)[0])));
+  }
+}
@@ -0,0 +1,229 @@
+#ifndef __REGRESSION_SESSION_H__
+#define __REGRESSION_SESSION_H__
+
+#include "../../FdaPDE.h"
+#include "Regression_Skeleton.h"
+#include "../../FE_Assemblers_Solvers/Include/Evaluator.h"
+#include "../../Global_Utilities/Include/Binary_Archive.h"
+#include "../../Lambda_Optimization/Include/Optimization_Data.h"
+#include "../../Lambda_Optimization/Include/Solution_Builders.h"
+#include "../../Inference/Include/Inference_Data.h"
+#include "../../Mesh/Include/Mesh.h"
+#include "../../Mesh/Include/Mesh_Archive.h"
+#include "../../Regression/Include/Mixed_FE_Regression.h"
+#include "../../Regression/Include/Regression_Data.h"
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+//! Abstract interface of a regression session kept alive across several calls from R
+/*!
+  The session is stored inside an R external pointer and owns all the C++ structures of a spatial regression problem,
+  so that follow-up calls do not need to rebuild them.
+  \sa RegressionSession
+*/
+class RegressionSessionBase
+{
+public:
+  virtual ~RegressionSessionBase() = default;
+
+  //! A method that solves the problem with the current observations and optimization data
+  virtual SEXP fit(void) = 0;
+  //! A method that replaces the observations (same locations and covariates)
+  /*!
+    \pre Robservations has getObservationsLength() elements and no NA, unless areLocationsByNodes()
+  */
+  virtual void updateObservations(SEXP Robservations) = 0;
+  //! A method returning the length of the vector of observations the session has been created with
+  virtual UInt getObservationsLength(void) const = 0;
+  //! A method returning true if the observations are associated with the mesh nodes, the only case in which NA are admitted
+  virtual bool areLocationsByNodes(void) const = 0;
+  //! A method that replaces the optimization data (e.g. a refined lambda grid)
+  virtual void updateOptimization(const OptimizationData & optimizationData) = 0;
+  //! A method that runs inference on the last fitted model
+  virtual SEXP inference(InferenceData & inferenceData) = 0;
+  //! A method that evaluates the last fitted field in a set of new locations
+  virtual SEXP eval(SEXP Rlocations, SEXP Rfast) = 0;
+  //! A method that writes mesh, tree and last solution (optionally the system matrix) to a binary archive
+  virtual bool save(const std::string & filename, bool saveSystem) = 0;
+};
+
+//! Persistent spatial regression session
+/*!
+  The mesh (with its ADTree, if required), the FE matrices R0 and R1, Psi and the factorization of the system
+  are built once and reused by every following call:
+  - a refit with new observations only recomputes the right hand side, the factorization is reused
+    unless lambda changes (or the pattern of missing observations at the nodes changes, which changes Psi);
+  - a refit with new optimization data (e.g. a refined lambda grid) reuses mesh, R0, R1 and Psi;
+  - inference and evaluation at new locations work on the last fitted solution.
+  \tparam ORDER the order of the mesh
+  \tparam mydim specifies if the mesh lie in R^2 or R^3
+  \tparam ndim specifies if the local dimension is 2 or 3
+*/
+template<UInt ORDER, UInt mydim, UInt ndim>
+class RegressionSession : public RegressionSessionBase
+{
+private:
+  RegressionData regressionData_;
+  OptimizationData optimizationData_;
+  MeshHandler<ORDER, mydim, ndim> mesh_;
+  std::unique_ptr<MixedFERegression<RegressionData>> regression_;
+
+  std::pair<MatrixXr, output_Data<1>> solution_bricks_;	//!< Last solution, used by inference and eval
+  bool isFitted_ = false;
+  const UInt observationsLength_;	//!< Length of the vector of observations (NA included), the same for every update
+
+public:
+  //! A constructor, it builds the mesh and preapplies the regression problem
+  /*!
+    \param regressionData the object containing regression informations, copied in the session
+    \param optimizationData the object containing optimization data, copied in the session
+    \param Rmesh the R object containing the mesh, it must be kept alive as long as the session exists
+    \param observationsLength the length of the R vector of observations, NA included
+  */
+  RegressionSession(const RegressionData & regressionData, const OptimizationData & optimizationData, SEXP Rmesh, UInt observationsLength):
+    regressionData_(regressionData), optimizationData_(optimizationData), mesh_(Rmesh, regressionData_.getSearch()),
+    regression_(fdaPDE::make_unique<MixedFERegression<RegressionData>>(regressionData_, optimizationData_, mesh_.num_nodes())),
+    observationsLength_(observationsLength)
+  {
+    regression_->preapply(mesh_);
+  }
+
+  SEXP fit(void) override
+  {
+    Instrumentation::get().reset(); // The output reports only the phases of this call
+    optimizationData_.set_best_value(std::numeric_limits<Real>::max()); // Forget the loss of the previous fit
+    solution_bricks_ = regression_solution_selection<RegressionData>(regressionData_, optimizationData_, *regression_);
+    isFitted_ = true;
+
+    // Inference is run on demand through inference(), an empty InferenceData produces the default output
+    InferenceData inferenceData;
+    MatrixXv inference_Output;
+    return Solution_Builders::build_solution_plain_regression<RegressionData, ORDER, mydim, ndim>(solution_bricks_.first, solution_bricks_.second,
+			mesh_, regressionData_, *regression_, inference_Output, inferenceData);
+  }
+
+  void updateObservations(SEXP Robservations) override
+  {
+    const std::vector<UInt> old_indices = *regressionData_.getObservationsIndices();
+    regressionData_.updateObservations(Robservations);
+
+    if(*regressionData_.getObservationsIndices() != old_indices)
+      {
+	// Observations at the nodes with a different pattern of NA: Psi changes, keep only mesh, R0 and R1
+	std::unique_ptr<MixedFERegression<RegressionData>> regression = fdaPDE::make_unique<MixedFERegression<RegressionData>>(regressionData_, optimizationData_, mesh_.num_nodes());
+	regression->setFEMatrices(*(regression_->getR0_()), *(regression_->getR1_()));
+	regression_ = std::move(regression);
+	optimizationData_.set_last_lS_used(std::numeric_limits<Real>::infinity()); // Force the factorization of the new system
+      }
+
+    regression_->preapply(mesh_); // Psi, R0 and R1 are already computed, only the data dependent quantities are updated
+    isFitted_ = false;
+  }
+
+  UInt getObservationsLength(void) const override {return observationsLength_;}
+  bool areLocationsByNodes(void) const override {return regressionData_.isLocationsByNodes();}
+
+  void updateOptimization(const OptimizationData & optimizationData) override
+  {
+    const Real last_lS_used = optimizationData_.get_last_lS_used();
+    optimizationData_ = optimizationData;
+    optimizationData_.set_last_lS_used(last_lS_used); // The current factorization is still valid for its lambda
+    isFitted_ = false;
+  }
+
+  SEXP inference(InferenceData & inferenceData) override
+  {
+    Instrumentation::get().reset();
+    if(!isFitted_)
+      {
+	Rprintf("ERROR: the session must be fitted before running inference\n");
+	return(NILSXP);
+      }
+
+    MatrixXv inference_Output;
+    regression_inference_selection<RegressionData, ORDER, mydim, ndim>(mesh_, regressionData_, optimizationData_, inferenceData, *regression_, solution_bricks_, inference_Output);
+    return Solution_Builders::build_solution_plain_regression<RegressionData, ORDER, mydim, ndim>(solution_bricks_.first, solution_bricks_.second,
+			mesh_, regressionData_, *regression_, inference_Output, inferenceData);
+  }
+
+  SEXP eval(SEXP Rlocations, SEXP Rfast) override
+  {
+    if(!isFitted_)
+      {
+	Rprintf("ERROR: the session must be fitted before evaluating the solution\n");
+	return(NILSXP);
+      }
+
+    RNumericMatrix locations(Rlocations);
+    const bool fast = INTEGER(Rfast)[0];
+    const UInt n_X = locations.nrows();
+    const UInt nnodes = mesh_.num_nodes();
+    MatrixXr & solution = solution_bricks_.first;
+
+    Evaluator<ORDER, mydim, ndim> evaluator(mesh_);
+    std::vector<bool> isinside(n_X);
+
+    // One column for each solution (a single one when lambda is selected through GCV)
+    SEXP result = NILSXP;
+    result = PROTECT(Rf_allocMatrix(REALSXP, n_X, solution.cols()));
+    for(UInt j=0; j<solution.cols(); ++j)
+      {
+	RNumericMatrix coef(solution.col(j).data(), nnodes, 1); // f is stored in the first nnodes rows
+	RNumericMatrix result_(REAL(result) + n_X*j, n_X, 1);
+	evaluator.eval(locations, coef, fast, result_, isinside);
+
+	for(UInt i=0; i<n_X; ++i)
+	  {
+	    if(!(isinside[i]))
+	      result_[i] = NA_REAL;
+	  }
+      }
+
+    UNPROTECT(1);
+    return(result);
+  }
+
+  bool save(const std::string & filename, bool saveSystem) override
+  {
+    if(!isFitted_)
+      {
+	Rprintf("ERROR: the session must be fitted before saving it\n");
+	return false;
+      }
+
+    BinaryArchiveWriter writer;
+    if(!archive_mesh<ORDER, mydim, ndim>(mesh_, writer))
+      {
+	Rprintf("ERROR: linear network meshes cannot be archived\n");
+	return false;
+      }
+
+    const UInt nnodes = mesh_.num_nodes();
+    const MatrixXr coefficients = solution_bricks_.first.topRows(nnodes); // f of each solution
+    writer.addSection(BinaryArchive::Coefficients, coefficients.data(), nnodes, coefficients.cols());
+
+    if(saveSystem)
+      {
+	// SparseLU has no portable representation: the compressed system matrix is stored, it can be mapped with
+	// Eigen::Map<SpMat> and factorized without any assembly
+	SpMat system = *(regression_->getmatrixNoCov_());
+	system.makeCompressed();
+	const Real lambda = optimizationData_.get_last_lS_used();
+	writer.addSection(BinaryArchive::SystemInfo, &lambda, 1, 1);
+	writer.addSection(BinaryArchive::SystemOuter, system.outerIndexPtr(), system.outerSize()+1, 1);
+	writer.addSection(BinaryArchive::SystemInner, system.innerIndexPtr(), system.nonZeros(), 1);
+	writer.addSection(BinaryArchive::SystemValues, system.valuePtr(), system.nonZeros(), 1);
+      }
+
+    if(!writer.write(filename))
+      {
+	Rprintf("ERROR: %s could not be written\n", filename.c_str());
+	return false;
+      }
+    return true;
+  }
+};
+
+#endif
@@ -22,6 +22,11 @@
 #include <algorithm>
 #include <set>
 
+template<typename InputHandler>
+std::pair<MatrixXr, output_Data<1>> regression_solution_selection(InputHandler & regressionData, OptimizationData & optimizationData, MixedFERegression<InputHandler> & regression);
+template<typename InputHandler, UInt ORDER, UInt mydim, UInt ndim>
+void regression_inference_selection(const MeshHandler<ORDER, mydim, ndim> & mesh, InputHandler & regressionData, const OptimizationData & optimizationData, InferenceData & inferenceData,
+				    MixedFERegression<InputHandler> & regression, std::pair<MatrixXr, output_Data<1>> & solution_bricks, MatrixXv & inference_Output);
 template<typename CarrierType>
 typename std::enable_if<std::is_same<multi_bool_type<std::is_base_of<Temporal, CarrierType>::value>, f_type>::value,
 			std::pair<MatrixXr, output_Data<1>> >::type optimizer_method_selection(CarrierType & carrier);
@@ -38,6 +43,7 @@ void compute_nonparametric_inference_matrices(const MeshHandler<ORDER, mydim, nd
 template<typename InputHandler, UInt ORDER, UInt mydim, UInt ndim>
 SEXP regression_skeleton(InputHandler & regressionData, OptimizationData & optimizationData, InferenceData & inferenceData, SEXP Rmesh)
 {
+  Instrumentation::get().reset(); // The output reports only the phases of this call
   MeshHandler<ORDER, mydim, ndim> mesh(Rmesh, regressionData.getSearch());	// Create the mesh
   MixedFERegression<InputHandler> regression(regressionData, optimizationData, mesh.num_nodes()); // Define the mixed object
 
@@ -45,9 +51,68 @@ SEXP regression_skeleton(InputHandler & regressionData, OptimizationData & optim
 	
   std::pair<MatrixXr, output_Data<1>> solution_bricks;	// Prepare solution to be filled
   MatrixXv inference_Output; 				// Matrix that will store the output from inference, i.e. p-values and/or intervals
+
+  solution_bricks = regression_solution_selection<InputHandler>(regressionData, optimizationData, regression); // Build the Carrier and solve
+  regression_inference_selection<InputHandler, ORDER, mydim, ndim>(mesh, regressionData, optimizationData, inferenceData, regression, solution_bricks, inference_Output); // Inference, if required
+
+  return Solution_Builders::build_solution_plain_regression<InputHandler, ORDER, mydim, ndim>(solution_bricks.first,solution_bricks.second,mesh,regressionData,regression,inference_Output,inferenceData);
+}
+
+//! Function that selects the lambda for inference and runs the required inferential analysis on an already solved problem
+/*
+  \tparam InputHandler the type of regression problem
+  \tparam ORDER the order of the mesh
+  \tparam mydim specifies if the mesh lie in R^2 or R^3
+  \tparam ndim specifies if the local dimension is 2 or 3
+  \param mesh the mesh of the problem
+  \param regressionData the object containing regression informations
+  \param optimizationData the object containing optimization data
+  \param inferenceData the object containing the data needed for inference
+  \param regression the object containing the model of the problem
+  \param solution_bricks the solution returned by regression_solution_selection
+  \param inference_Output the matrix that will store the output from inference, i.e. p-values and/or intervals
+  \return void
+*/
+template<typename InputHandler, UInt ORDER, UInt mydim, UInt ndim>
+void regression_inference_selection(const MeshHandler<ORDER, mydim, ndim> & mesh, InputHandler & regressionData, const OptimizationData & optimizationData, InferenceData & inferenceData,
+				    MixedFERegression<InputHandler> & regression, std::pair<MatrixXr, output_Data<1>> & solution_bricks, MatrixXv & inference_Output)
+{
   Real lambda_inference = 0; 				// Will store the value of the optimal lambda
+  lambda_inference_selection(optimizationData, solution_bricks.second, inferenceData, regression, lambda_inference); // Set lambda for inference
+
+  //Inference
+  if(inferenceData.get_definition()==true){ 
+    //only if inference is actually required
+    ScopedPhase phase("inference");
+    Inference_Carrier<InputHandler> inf_car(&regressionData, &regression, &solution_bricks.second, &inferenceData, lambda_inference); //Carrier for inference Data
 
-  // Build the Carrier according to problem type
+    //get the component on which inference is required
+    const std::vector<std::string> inf_component = inferenceData.get_component_type(); 
+
+    //if nonparametric inference is required
+    if(std::find(inf_component.begin(), inf_component.end(), "nonparametric") != inf_component.end() || 
+       std::find(inf_component.begin(), inf_component.end(), "both") != inf_component.end()){
+      // set the solution of the system inside the inference carrier
+      inf_car.setSolutionp(&(solution_bricks.first));
+      // compute other local matrices according to the implementation
+      compute_nonparametric_inference_matrices<InputHandler, ORDER, mydim, ndim>(mesh, regressionData, inferenceData, inf_car);
+    }
+
+    inference_wrapper_space(optimizationData, solution_bricks.second, inf_car, inference_Output);    
+  }
+}
+
+//! Function that builds the Carrier according to the problem type and applies the selected optimization method
+/*
+  \tparam InputHandler the type of regression problem
+  \param regressionData the object containing regression informations
+  \param optimizationData the object containing optimization data
+  \param regression the object containing the model of the problem, already preapplied
+  \return the solution to pass to the Solution_Builders
+*/
+template<typename InputHandler>
+std::pair<MatrixXr, output_Data<1>> regression_solution_selection(InputHandler & regressionData, OptimizationData & optimizationData, MixedFERegression<InputHandler> & regression)
+{
   if(regression.isSV())
     {
       if(regressionData.getNumberOfRegions()>0)
@@ -55,18 +120,14 @@ SEXP regression_skeleton(InputHandler & regressionData, OptimizationData & optim
 	  //Rprintf("Areal-forced\n");
 	  Carrier<InputHandler,Forced,Areal>
 	    carrier = CarrierBuilder<InputHandler>::build_forced_areal_carrier(regressionData, regression, optimizationData);
-	  solution_bricks = optimizer_method_selection<Carrier<InputHandler, Forced,Areal>>(carrier);
-                        
-	  lambda_inference_selection(optimizationData, solution_bricks.second, inferenceData, regression, lambda_inference); // Set lambda for inference
+	  return optimizer_method_selection<Carrier<InputHandler, Forced,Areal>>(carrier);
 	}
       else
 	{
 	  //Rprintf("Pointwise-forced\n");
 	  Carrier<InputHandler,Forced>
 	    carrier = CarrierBuilder<InputHandler>::build_forced_carrier(regressionData, regression, optimizationData);
-	  solution_bricks = optimizer_method_selection<Carrier<InputHandler,Forced>>(carrier);
-
-	  lambda_inference_selection(optimizationData, solution_bricks.second, inferenceData, regression, lambda_inference); // Set lambda for inference
+	  return optimizer_method_selection<Carrier<InputHandler,Forced>>(carrier);
 	}
     }
   else
@@ -76,40 +137,16 @@ SEXP regression_skeleton(InputHandler & regressionData, OptimizationData & optim
 	  //Rprintf("Areal\n");
 	  Carrier<InputHandler,Areal>
 	    carrier = CarrierBuilder<InputHandler>::build_areal_carrier(regressionData, regression, optimizationData);
-	  solution_bricks = optimizer_method_selection<Carrier<InputHandler,Areal>>(carrier);
-
-	  lambda_inference_selection(optimizationData, solution_bricks.second, inferenceData, regression, lambda_inference); // Set lambda for inference
+	  return optimizer_method_selection<Carrier<InputHandler,Areal>>(carrier);
 	}
       else
 	{
 	  //Rprintf("Pointwise\n");
 	  Carrier<InputHandler>
 	    carrier = CarrierBuilder<InputHandler>::build_plain_carrier(regressionData, regression, optimizationData);
-	  solution_bricks = optimizer_method_selection<Carrier<InputHandler>>(carrier);
-
-	  lambda_inference_selection(optimizationData, solution_bricks.second, inferenceData, regression, lambda_inference); // Set lambda for inference	
-																  }
-    }
-  //Inference
-  if(inferenceData.get_definition()==true){ 
-    //only if inference is actually required
-    Inference_Carrier<InputHandler> inf_car(&regressionData, &regression, &solution_bricks.second, &inferenceData, lambda_inference); //Carrier for inference Data
-
-    //get the component on which inference is required
-    const std::vector<std::string> inf_component = inferenceData.get_component_type(); 
-
-    //if nonparametric inference is required
-    if(std::find(inf_component.begin(), inf_component.end(), "nonparametric") != inf_component.end() || 
-       std::find(inf_component.begin(), inf_component.end(), "both") != inf_component.end()){
-      // set the solution of the system inside the inference carrier
-      inf_car.setSolutionp(&(solution_bricks.first));
-      // compute other local matrices according to the implementation
-      compute_nonparametric_inference_matrices<InputHandler, ORDER, mydim, ndim>(mesh, regressionData, inferenceData, inf_car);
+	  return optimizer_method_selection<Carrier<InputHandler>>(carrier);
+	}
     }
-
-    inference_wrapper_space(optimizationData, solution_bricks.second, inf_car, inference_Output);    
-  }
-  return Solution_Builders::build_solution_plain_regression<InputHandler, ORDER, mydim, ndim>(solution_bricks.first,solution_bricks.second,mesh,regressionData,regression,inference_Output,inferenceData);
 }
 
 //! Function to select the right optimization method
@@ -284,6 +321,47 @@ optimizer_strategy_selection(EvaluationType & optim, CarrierType & carrier)
     }
 }
 
+//! Function that runs the required inference methods, given the policy for the inversion of MatrixNoCov
+/*
+  \tparam InputHandler the type of regression problem
+  \tparam MatrixType the type of the inverse of MatrixNoCov: MatrixXr for exact inference, SpMat for non-exact inference
+  \param opt_data the object containing optimization data
+  \param output the object containing the solution of the optimization problem 
+  \param inf_car the inference carrier object wrapping all the objects needed to make inference
+  \param inference_Inverter the object that computes the inverse of MatrixNoCov
+  \param inference_output the object to be filled with inference output, already resized: two rows for each implementation, then the local f variance and the sign-flips summary
+  \return void
+*/
+template<typename InputHandler, typename MatrixType>
+void inference_wrapper_space_solvers(const OptimizationData & opt_data, output_Data<1> & output, const Inference_Carrier<InputHandler> & inf_car, std::shared_ptr<Inverse_Base<MatrixType>> inference_Inverter, MatrixXv & inference_output)
+{
+  UInt n_implementations = inf_car.getInfData()->get_implementation_type().size();
+  // Workspace shared by all the required implementations: each heavy quantity is computed at most once in this call
+  Inference_Workspace<InputHandler, MatrixType> inference_Workspace(inf_car, inference_Inverter);
+  // Number of sign-flips used and Monte Carlo standard error of each implementation, stored after the local f variance
+  VectorXr flips_info(4*n_implementations);
+
+  for(UInt i=0; i<n_implementations; ++i){
+    // Factory instantiation for solver: using factory provided in Inference_Factory.h
+    std::shared_ptr<Inference_Base<InputHandler,MatrixType>> inference_Solver = Inference_Factory<InputHandler,MatrixType>::create_inference_method(inf_car.getInfData()->get_implementation_type()[i], inference_Workspace, i); // Selects the right implementation and solves the inferential problems
+    inference_output.middleRows(2*i,2) = inference_Solver->compute_inference_output();
+    flips_info.segment(4*i,4) = inference_Solver->get_flips_info();
+
+    if(inf_car.getInfData()->get_implementation_type()[i]=="wald" && opt_data.get_loss_function()=="unused" && opt_data.get_size_S()==1){
+      output.GCV_opt=inference_Solver->compute_GCV_from_inference(); // Computing GCV if Wald has being called is an almost zero-cost function, since tr(S) hase been already computed
+    }
+  }
+  inference_output(2*n_implementations,1) = flips_info;
+    
+  // Check if local f variance has to be computed
+  if(inf_car.getInfData()->get_f_var()){
+    std::shared_ptr<Inference_Base<InputHandler,MatrixType>> inference_Solver = Inference_Factory<InputHandler,MatrixType>::create_inference_method("wald", inference_Workspace, n_implementations);
+    inference_output(2*n_implementations,0) = inference_Solver->compute_f_var();
+  }
+  
+  return;
+}
+
 //! Function to select the right inference method
 /*
   \tparam InputHandler the type of regression problem
@@ -307,25 +385,18 @@ void inference_wrapper_space(const OptimizationData & opt_data, output_Data<1> &
   // Preallocate with the correct dimension
   inference_output.resize(2*n_implementations+1, out_dim+1);
 
-  // Select the right policy for inversion of MatrixNoCov (Only exact inversion implemented in this CRAN version)
-  std::shared_ptr<Inverse_Base<MatrixXr>> inference_Inverter = std::make_shared<Inverse_Exact>(inf_car.getEp(), inf_car.getE_decp());
-
-  for(UInt i=0; i<n_implementations; ++i){
-    // Factory instantiation for solver: using factory provided in Inference_Factory.h
-    std::shared_ptr<Inference_Base<InputHandler,MatrixXr>> inference_Solver = Inference_Factory<InputHandler,MatrixXr>::create_inference_method(inf_car.getInfData()->get_implementation_type()[i], inference_Inverter, inf_car, i); // Selects the right implementation and solves the inferential problems
-    inference_output.middleRows(2*i,2) = inference_Solver->compute_inference_output();
-
-    if(inf_car.getInfData()->get_implementation_type()[i]=="wald" && opt_data.get_loss_function()=="unused" && opt_data.get_size_S()==1){
-      output.GCV_opt=inference_Solver->compute_GCV_from_inference(); // Computing GCV if Wald has being called is an almost zero-cost function, since tr(S) hase been already computed
+  // Select the right policy for inversion of MatrixNoCov: exact inverse or sparse approximate inverse
+  if(inf_car.getInfData()->get_exact_inference()=="non-exact"){
+    std::shared_ptr<Inverse_Non_Exact> inference_Inverter = std::make_shared<Inverse_Non_Exact>(inf_car.getEp(), inf_car.getInfData()->get_tol_Fspai());
+    inference_wrapper_space_solvers<InputHandler, SpMat>(opt_data, output, inf_car, inference_Inverter, inference_output);
+    if(!inference_Inverter->get_status_inverse()){
+      Rprintf("WARNING: the sparse approximate inverse did not reach the tolerance tol_fspai on all its columns\n");
     }
+  }else{
+    std::shared_ptr<Inverse_Base<MatrixXr>> inference_Inverter = std::make_shared<Inverse_Exact>(inf_car.getEp(), inf_car.getE_decp());
+    inference_wrapper_space_solvers<InputHandler, MatrixXr>(opt_data, output, inf_car, inference_Inverter, inference_output);
   }
-    
-  // Check if local f variance has to be computed
-  if(inf_car.getInfData()->get_f_var()){
-    std::shared_ptr<Inference_Base<InputHandler,MatrixXr>> inference_Solver = Inference_Factory<InputHandler,MatrixXr>::create_inference_method("wald", inference_Inverter, inf_car, n_implementations);
-    inference_output(2*n_implementations,0) = inference_Solver->compute_f_var();
-  }
-  
+
   return;
   
 }
@@ -381,33 +452,42 @@ void compute_nonparametric_inference_matrices(const MeshHandler<ORDER, mydim, nd
 		
     constexpr UInt EL_NNODES = how_many_nodes(ORDER,mydim);
     Eigen::Matrix<Real,EL_NNODES,1> coefficients;    // Dummy for point evaluation
-    Real evaluator;                // Dummy for evaluation storage
+    const MatrixXr & locations = inferenceData_.get_locs_inference();
+
+    // Search the elements containing the points in parallel (the search structures of the mesh are only read)
+    std::vector<Element<EL_NNODES, mydim, ndim>> tri_activated(nlocations);
+    #pragma omp parallel for schedule(dynamic, 256)
+    for(long int i=0; i<long(nlocations); i++)
+      {
+	VectorXr coords = locations.row(i);
+	tri_activated[i] = mesh_.findLocation(Point<ndim>(i, coords));
+      }
+
+    // vector storing the non zero elements of psi, EL_NNODES for each location
+    std::vector<coeff> triplets;
+    triplets.reserve(nlocations*EL_NNODES);
 
     for(UInt i=0; i<nlocations;i++)
       { // Update psi looping on all locations
-	// [[GM missing a defaulted else, raising a WARNING!]]
-	VectorXr coords = (inferenceData_.get_locs_inference()).row(i);
-	Element<EL_NNODES, mydim, ndim> tri_activated = mesh_.findLocation(Point<ndim>(i, coords));
-
-	// Search the element containing the point
-	if(tri_activated.getId() == Identifier::NVAL)
+	if(tri_activated[i].getId() == Identifier::NVAL)
 	  { // If not found
 	    Rprintf("ERROR: Point %d is not in the domain, remove point and re-perform smoothing\n", i+1);
 	  }
 	else
 	  {
+	    VectorXr coords = locations.row(i);
 	    for(UInt node=0; node<EL_NNODES ; ++node)
-	      {// Loop on all the nodes of the found element and update the related entries of Psi
+	      {// Loop on all the nodes of the found element and store the related entries of Psi
 		// Define vector of all zeros but "node" component (necessary for function evaluate_point)
 		coefficients = Eigen::Matrix<Real,EL_NNODES,1>::Zero();
 		coefficients(node) = 1; //Activates only current base-node
-		// Evaluate psi in the node
-		evaluator = tri_activated.evaluate_point(Point<ndim>(i, coords), coefficients);
-		// Insert the value in the column given by the GLOBAL indexing of the evaluated NODE
-		psi.insert(i, tri_activated[node].getId()) = evaluator;
+		// Evaluate psi in the node, in the column given by the GLOBAL indexing of the evaluated NODE
+		triplets.push_back(coeff(i, tri_activated[i][node].getId(), tri_activated[i].evaluate_point(Point<ndim>(i, coords), coefficients)));
 	      }
 	  }
       } // End of for loop
+
+    psi.setFromTriplets(triplets.begin(), triplets.end());
         
     psi.makeCompressed();   
            
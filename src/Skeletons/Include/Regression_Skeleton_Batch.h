@@ -0,0 +1,88 @@
+#ifndef __REGRESSION_SKELETON_BATCH_H__
+#define __REGRESSION_SKELETON_BATCH_H__
+
+#include "../../FdaPDE.h"
+#include "../../Lambda_Optimization/Include/Optimization_Data.h"
+#include "../../Lambda_Optimization/Include/Solution_Builders.h"
+#include "../../Inference/Include/Inference_Data.h"
+#include "../../Mesh/Include/Mesh.h"
+#include "../../Regression/Include/Mixed_FE_Regression.h"
+#include "../../Global_Utilities/Include/Print_Buffer.h"
+#include "Regression_Skeleton.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+//! Function that fits several independent datasets sharing the same mesh
+/*!
+  The mesh (and its ADTree, if required) is built once and the FE matrices R0 and R1 are assembled
+  only for the first dataset and then shared by all the others. Each dataset keeps its own Psi, system
+  factorization, lambda selection and output. Psi construction and the R output are handled sequentially,
+  since they may interact with the R API; the lambda selection and the solution of the systems, which
+  are independent across datasets, are run in parallel when OpenMP is available and the criterion is "grid".
+  The messages printed by each dataset during the parallel phase (grid progress, warnings on the dofs, ...)
+  are captured through Print_Capture and printed by the master thread after the loop, in the order of the
+  datasets. Newton-type criteria log their iterations through Rprintf and are therefore always run sequentially. The timings attached
+  to each output refer to the whole batch (the times of the parallel phases are summed over the threads).
+  \tparam InputHandler the type of regression problem
+  \tparam ORDER the order of the mesh
+  \tparam mydim specifies if the mesh lie in R^2 or R^3
+  \tparam ndim specifies if the local dimension is 2 or 3
+  \param regressionData vector of objects containing the regression informations, one for each dataset
+  \param optimizationData the object containing optimization data, copied for each dataset
+  \param Rmesh the R object containing the mesh shared by all the datasets
+  \return an R list with one element per dataset, each of them structured as the output of regression_skeleton
+*/
+template<typename InputHandler, UInt ORDER, UInt mydim, UInt ndim>
+SEXP regression_skeleton_batch(std::vector<std::unique_ptr<InputHandler>> & regressionData, const OptimizationData & optimizationData, SEXP Rmesh)
+{
+  Instrumentation::get().reset(); // The phases of the whole batch are reported in the output of every dataset
+  const UInt n_datasets = regressionData.size();
+
+  MeshHandler<ORDER, mydim, ndim> mesh(Rmesh, regressionData[0]->getSearch());	// Create the mesh (and the tree) once
+
+  // Each dataset needs its own OptimizationData, since it keeps track of the last lambda used
+  std::vector<OptimizationData> optimizationData_batch(n_datasets, optimizationData);
+  std::vector<std::unique_ptr<MixedFERegression<InputHandler>>> regression_batch;
+  regression_batch.reserve(n_datasets);
+
+  for(UInt i=0; i<n_datasets; ++i)
+    {
+      regression_batch.push_back(fdaPDE::make_unique<MixedFERegression<InputHandler>>(*regressionData[i], optimizationData_batch[i], mesh.num_nodes()));
+      if(i>0)
+	regression_batch[i]->setFEMatrices(*(regression_batch[0]->getR0_()), *(regression_batch[0]->getR1_())); // Reuse the matrices assembled for the first dataset
+      regression_batch[i]->preapply(mesh); // Only Psi and the data dependent matrices are computed here
+    }
+
+  std::vector<std::pair<MatrixXr, output_Data<1>>> solution_bricks(n_datasets);
+  std::vector<std::string> messages(n_datasets);
+  const bool parallel_batch = (optimizationData.get_criterion() == "grid");
+
+  #pragma omp parallel for schedule(dynamic) if(parallel_batch)
+  for(UInt i=0; i<n_datasets; ++i)
+    {
+      Print_Capture capture(messages[i]); // R cannot be called from the worker threads
+      solution_bricks[i] = regression_solution_selection<InputHandler>(*regressionData[i], optimizationData_batch[i], *regression_batch[i]);
+    }
+
+  for(UInt i=0; i<n_datasets; ++i)
+    if(!messages[i].empty())
+      Rprintf("Dataset %d:\n%s", i+1, messages[i].c_str());
+
+  // Inference is not available in batch mode, an empty InferenceData produces the default output
+  InferenceData inferenceData;
+  MatrixXv inference_Output;
+
+  SEXP result = NILSXP;
+  result = PROTECT(Rf_allocVector(VECSXP, n_datasets));
+  for(UInt i=0; i<n_datasets; ++i)
+    {
+      SET_VECTOR_ELT(result, i, Solution_Builders::build_solution_plain_regression<InputHandler, ORDER, mydim, ndim>(solution_bricks[i].first, solution_bricks[i].second,
+			mesh, *regressionData[i], *regression_batch[i], inference_Output, inferenceData));
+    }
+
+  UNPROTECT(1);
+  return(result);
+}
+
+#endif
@@ -45,6 +45,7 @@ void compute_nonparametric_inference_matrices_time(const MeshHandler<ORDER, mydi
 template<typename InputHandler, UInt ORDER, UInt mydim, UInt ndim>
 SEXP regression_skeleton_time(InputHandler & regressionData, OptimizationData & optimizationData, InferenceData & inferenceData, SEXP Rmesh, SEXP Rmesh_time)
 {
+	Instrumentation::get().reset(); // The output reports only the phases of this call
 	MeshHandler<ORDER, mydim, ndim> mesh(Rmesh, regressionData.getSearch());//! load the mesh
 	UInt n_time = Rf_length(Rmesh_time);
 	std::vector<Real> mesh_time(n_time);
@@ -110,6 +111,7 @@ SEXP regression_skeleton_time(InputHandler & regressionData, OptimizationData &
 	if(inferenceData.get_definition()==true){ 
 
 		//!Only if inference is actually required
+		ScopedPhase phase("inference");
 		Inference_Carrier<InputHandler> inf_car(&regressionData, &regression, &solution_bricks.second,  &inferenceData, lambda_inference_S, lambda_inference_T); //Carrier for inference
 		
 		//get the component on which inference is required
@@ -418,6 +420,47 @@ optimizer_strategy_selection(EvaluationType & optim, CarrierType & carrier)
 
 
 
+//! Function that runs the required inference methods, given the policy for the inversion of MatrixNoCov
+/*
+  \tparam InputHandler the type of regression problem
+  \tparam MatrixType the type of the inverse of MatrixNoCov: MatrixXr for exact inference, SpMat for non-exact inference
+  \param opt_data the object containing optimization data
+  \param output the object containing the solution of the optimization problem 
+  \param inf_car the inference carrier object wrapping all the objects needed to make inference
+  \param inference_Inverter the object that computes the inverse of MatrixNoCov
+  \param inference_output the object to be filled with inference output, already resized: two rows for each implementation, then the local f variance and the sign-flips summary
+  \return void
+*/
+template<typename InputHandler, typename MatrixType>
+void inference_wrapper_time_solvers(const OptimizationData & opt_data, output_Data<2> & output, const Inference_Carrier<InputHandler> & inf_car, std::shared_ptr<Inverse_Base<MatrixType>> inference_Inverter, MatrixXv & inference_output)
+{
+  UInt n_implementations = inf_car.getInfData()->get_implementation_type().size();
+  // Workspace shared by all the required implementations: each heavy quantity is computed at most once in this call
+  Inference_Workspace<InputHandler, MatrixType> inference_Workspace(inf_car, inference_Inverter);
+  // Number of sign-flips used and Monte Carlo standard error of each implementation, stored after the local f variance
+  VectorXr flips_info(4*n_implementations);
+
+  for(UInt i=0; i<n_implementations; ++i){
+    // Factory instantiation for solver: using factory provided in Inference_Factory.h
+    std::shared_ptr<Inference_Base<InputHandler,MatrixType>> inference_Solver = Inference_Factory<InputHandler,MatrixType>::create_inference_method(inf_car.getInfData()->get_implementation_type()[i], inference_Workspace, i); // Selects the right implementation and solves the inferential problems
+    inference_output.middleRows(2*i,2) = inference_Solver->compute_inference_output();
+    flips_info.segment(4*i,4) = inference_Solver->get_flips_info();
+
+    if(inf_car.getInfData()->get_implementation_type()[i]=="wald" && opt_data.get_loss_function()=="unused" && opt_data.get_size_S()==1 && opt_data.get_size_T()==1){
+      output.GCV_opt=inference_Solver->compute_GCV_from_inference(); // Computing GCV if Wald has being called is an almost zero-cost function, since tr(S) hase been already computed
+    }
+  }
+  inference_output(2*n_implementations,1) = flips_info;
+    
+  // Check if local f variance has to be computed
+  if(inf_car.getInfData()->get_f_var()){
+    std::shared_ptr<Inference_Base<InputHandler,MatrixType>> inference_Solver = Inference_Factory<InputHandler,MatrixType>::create_inference_method("wald", inference_Workspace, n_implementations);
+    inference_output(2*n_implementations,0) = inference_Solver->compute_f_var();
+  }
+
+  return;
+}
+
 //! Function to select the right inference method
 /*
   \tparam InputHandler the type of regression problem
@@ -439,23 +482,16 @@ void inference_wrapper_time(const OptimizationData & opt_data, output_Data<2> &
   // since only inference on beta is implemented for ST, the rows corresponding to f inference will be empty to be coherent with the size of inference_Solver's output
   inference_output.resize(2*n_implementations+1, out_dim+1);
 
-  // Select the right policy for inversion of MatrixNoCov
-  std::shared_ptr<Inverse_Base<MatrixXr>> inference_Inverter = std::make_shared<Inverse_Exact>(inf_car.getEp(), inf_car.getE_decp());
-
-  for(UInt i=0; i<n_implementations; ++i){
-    // Factory instantiation for solver: using factory provided in Inference_Factory.h
-    std::shared_ptr<Inference_Base<InputHandler,MatrixXr>> inference_Solver = Inference_Factory<InputHandler,MatrixXr>::create_inference_method(inf_car.getInfData()->get_implementation_type()[i], inference_Inverter, inf_car, i); // Selects the right implementation and solves the inferential problems
-    inference_output.middleRows(2*i,2) = inference_Solver->compute_inference_output();
-
-    if(inf_car.getInfData()->get_implementation_type()[i]=="wald" && opt_data.get_loss_function()=="unused" && opt_data.get_size_S()==1 && opt_data.get_size_T()==1){
-      output.GCV_opt=inference_Solver->compute_GCV_from_inference(); // Computing GCV if Wald has being called is an almost zero-cost function, since tr(S) hase been already computed
+  // Select the right policy for inversion of MatrixNoCov: exact inverse or sparse approximate inverse
+  if(inf_car.getInfData()->get_exact_inference()=="non-exact"){
+    std::shared_ptr<Inverse_Non_Exact> inference_Inverter = std::make_shared<Inverse_Non_Exact>(inf_car.getEp(), inf_car.getInfData()->get_tol_Fspai());
+    inference_wrapper_time_solvers<InputHandler, SpMat>(opt_data, output, inf_car, inference_Inverter, inference_output);
+    if(!inference_Inverter->get_status_inverse()){
+      Rprintf("WARNING: the sparse approximate inverse did not reach the tolerance tol_fspai on all its columns\n");
     }
-  }
-    
-  // Check if local f variance has to be computed
-  if(inf_car.getInfData()->get_f_var()){
-    std::shared_ptr<Inference_Base<InputHandler,MatrixXr>> inference_Solver = Inference_Factory<InputHandler,MatrixXr>::create_inference_method("wald", inference_Inverter, inf_car, n_implementations);
-    inference_output(2*n_implementations,0) = inference_Solver->compute_f_var();
+  }else{
+    std::shared_ptr<Inverse_Base<MatrixXr>> inference_Inverter = std::make_shared<Inverse_Exact>(inf_car.getEp(), inf_car.getE_decp());
+    inference_wrapper_time_solvers<InputHandler, MatrixXr>(opt_data, output, inf_car, inference_Inverter, inference_output);
   }
 
   return;
@@ -517,33 +553,42 @@ void compute_nonparametric_inference_matrices_time(const MeshHandler<ORDER, mydi
 		
     constexpr UInt EL_NNODES = how_many_nodes(ORDER,mydim);
     Eigen::Matrix<Real,EL_NNODES,1> coefficients;    // Dummy for point evaluation
-    Real evaluator;                // Dummy for evaluation storage
+    const MatrixXr & locations = inferenceData_.get_locs_inference();
+
+    // Search the elements containing the points in parallel (the search structures of the mesh are only read)
+    std::vector<Element<EL_NNODES, mydim, ndim>> tri_activated(nlocations);
+    #pragma omp parallel for schedule(dynamic, 256)
+    for(long int i=0; i<long(nlocations); i++)
+      {
+	VectorXr coords = locations.row(i);
+	tri_activated[i] = mesh_.findLocation(Point<ndim>(i, coords));
+      }
+
+    // vector storing the non zero elements of psi, EL_NNODES for each location
+    std::vector<coeff> triplets;
+    triplets.reserve(nlocations*EL_NNODES);
 
     for(UInt i=0; i<nlocations;i++)
       { // Update psi looping on all locations
-	// [[GM missing a defaulted else, raising a WARNING!]]
-	VectorXr coords = (inferenceData_.get_locs_inference()).row(i);
-	Element<EL_NNODES, mydim, ndim> tri_activated = mesh_.findLocation(Point<ndim>(i, coords));
-
-	// Search the element containing the point
-	if(tri_activated.getId() == Identifier::NVAL)
+	if(tri_activated[i].getId() == Identifier::NVAL)
 	  { // If not found
 	    Rprintf("ERROR: Point %d is not in the domain, remove point and re-perform smoothing\n", i+1);
 	  }
 	else
 	  {
+	    VectorXr coords = locations.row(i);
 	    for(UInt node=0; node<EL_NNODES ; ++node)
-	      {// Loop on all the nodes of the found element and update the related entries of Psi
+	      {// Loop on all the nodes of the found element and store the related entries of Psi
 		// Define vector of all zeros but "node" component (necessary for function evaluate_point)
 		coefficients = Eigen::Matrix<Real,EL_NNODES,1>::Zero();
 		coefficients(node) = 1; //Activates only current base-node
-		// Evaluate psi in the node
-		evaluator = tri_activated.evaluate_point(Point<ndim>(i, coords), coefficients);
-		// Insert the value in the column given by the GLOBAL indexing of the evaluated NODE
-		psi_temp.insert(i, tri_activated[node].getId()) = evaluator;
+		// Evaluate psi in the node, in the column given by the GLOBAL indexing of the evaluated NODE
+		triplets.push_back(coeff(i, tri_activated[i][node].getId(), tri_activated[i].evaluate_point(Point<ndim>(i, coords), coefficients)));
 	      }
 	  }
       } // End of for loop
+
+    psi_temp.setFromTriplets(triplets.begin(), triplets.end());
         
     psi_temp.makeCompressed();                  	
   }